@@ -0,0 +1,286 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "bench.h"
+
+#include "RowParser.h"
+
+#define BENCH_ITERATIONS (3)
+#define LEGACY_PARSE_BUF_SIZE (256)
+
+typedef struct
+{
+	const char* path;
+	int ncols;
+} BenchFile;
+
+static const BenchFile BENCH_FILES[] = {
+	{ "./test_data/weather_1p00_f1/ugrd.csv", 3 },
+	{ "./test_data/weather_1p00_f1/pres.csv", 3 },
+	{ "./test_data/weather_1p00_f1/cld.csv", 3 },
+	{ "./test_data/weather_0p50_f1/tmp.csv", 3 },
+	{ "./test_data/weather_0p50_f1/prate.csv", 3 },
+	{ "./test_data/weather_0p50_f1/rain.csv", 3 },
+	{ "./test_data/wave/f1.csv", 3 }
+};
+
+static int parseLegacy(const char* path, int ncols, double* sum, long* rows);
+static int parseRowReader(const char* path, int ncols, double* sum, long* rows);
+static int benchGzip(void);
+static int gzipFile(const char* src, const char* dst);
+
+
+int bench_RowParser_run()
+{
+	printf("\t%-40s %10s %12s %12s %8s\n", "file", "rows", "legacy MB/s", "parser MB/s", "speedup");
+
+	for (size_t i = 0; i < (sizeof(BENCH_FILES) / sizeof(BenchFile)); i++)
+	{
+		const BenchFile* bf = &BENCH_FILES[i];
+
+		struct stat st;
+		if (stat(bf->path, &st) != 0)
+		{
+			printf("\t%-40s (missing)\n", bf->path);
+			continue;
+		}
+
+		const double mb = (double) st.st_size / (1024.0 * 1024.0);
+
+		double bestLegacy = INFINITY;
+		double bestParser = INFINITY;
+
+		double sumLegacy = 0.0;
+		double sumParser = 0.0;
+		long rowsLegacy = 0;
+		long rowsParser = 0;
+
+		for (int k = 0; k < BENCH_ITERATIONS; k++)
+		{
+			double t0 = bench_now();
+			if (parseLegacy(bf->path, bf->ncols, &sumLegacy, &rowsLegacy) != 0)
+			{
+				return 1;
+			}
+			double t1 = bench_now();
+
+			if (t1 - t0 < bestLegacy)
+			{
+				bestLegacy = t1 - t0;
+			}
+
+			t0 = bench_now();
+			if (parseRowReader(bf->path, bf->ncols, &sumParser, &rowsParser) != 0)
+			{
+				return 1;
+			}
+			t1 = bench_now();
+
+			if (t1 - t0 < bestParser)
+			{
+				bestParser = t1 - t0;
+			}
+		}
+
+		// Both parsers must agree on what was read.
+		if (rowsLegacy != rowsParser || fabs(sumLegacy - sumParser) > fabs(sumLegacy) * 0.000001)
+		{
+			printf("\t%s: result mismatch! rows=%ld/%ld, sum=%f/%f\n", bf->path, rowsLegacy, rowsParser, sumLegacy, sumParser);
+			return 1;
+		}
+
+		printf("\t%-40s %10ld %12.1f %12.1f %7.2fx\n", bf->path, rowsParser, mb / bestLegacy, mb / bestParser, bestLegacy / bestParser);
+	}
+
+	return benchGzip();
+}
+
+// Parsing gzip compressed files (streamed through inflate) vs. the same files uncompressed, with both in the page cache.
+// Throughput is in MB/s of uncompressed data.
+static int benchGzip(void)
+{
+	printf("\n\t%-40s %10s %12s %12s %8s\n", "file (gzip)", "ratio", "plain MB/s", "gzip MB/s", "speedup");
+
+	for (size_t i = 0; i < (sizeof(BENCH_FILES) / sizeof(BenchFile)); i++)
+	{
+		const BenchFile* bf = &BENCH_FILES[i];
+		const char* gzPath = "/tmp/proteus_bench_RowParser.csv.gz";
+
+		struct stat st;
+		struct stat gzSt;
+		if (stat(bf->path, &st) != 0 || gzipFile(bf->path, gzPath) != 0 || stat(gzPath, &gzSt) != 0)
+		{
+			printf("\t%-40s (missing)\n", bf->path);
+			continue;
+		}
+
+		const double mb = (double) st.st_size / (1024.0 * 1024.0);
+
+		double bestPlain = INFINITY;
+		double bestGzip = INFINITY;
+
+		double sumPlain = 0.0;
+		double sumGzip = 0.0;
+		long rowsPlain = 0;
+		long rowsGzip = 0;
+
+		for (int k = 0; k < BENCH_ITERATIONS; k++)
+		{
+			double t0 = bench_now();
+			if (parseRowReader(bf->path, bf->ncols, &sumPlain, &rowsPlain) != 0)
+			{
+				return 1;
+			}
+			double t1 = bench_now();
+
+			if (t1 - t0 < bestPlain)
+			{
+				bestPlain = t1 - t0;
+			}
+
+			t0 = bench_now();
+			if (parseRowReader(gzPath, bf->ncols, &sumGzip, &rowsGzip) != 0)
+			{
+				return 1;
+			}
+			t1 = bench_now();
+
+			if (t1 - t0 < bestGzip)
+			{
+				bestGzip = t1 - t0;
+			}
+		}
+
+		unlink(gzPath);
+
+		if (rowsPlain != rowsGzip || sumPlain != sumGzip)
+		{
+			printf("\t%s: result mismatch! rows=%ld/%ld, sum=%f/%f\n", bf->path, rowsPlain, rowsGzip, sumPlain, sumGzip);
+			return 1;
+		}
+
+		printf("\t%-40s %9.1fx %12.1f %12.1f %7.2fx\n", bf->path, (double) st.st_size / gzSt.st_size, mb / bestPlain, mb / bestGzip, bestPlain / bestGzip);
+	}
+
+	return 0;
+}
+
+
+// The fgets() + strtok_r() + strtof() approach previously used by all data file loaders.
+static int parseLegacy(const char* path, int ncols, double* sum, long* rows)
+{
+	FILE* fp = fopen(path, "r");
+	if (!fp)
+	{
+		return -1;
+	}
+
+	char buf[LEGACY_PARSE_BUF_SIZE];
+
+	*sum = 0.0;
+	*rows = 0;
+
+	while (fgets(buf, LEGACY_PARSE_BUF_SIZE, fp) == buf)
+	{
+		char* t;
+		char* u = strtok_r(buf, ",", &t);
+
+		for (int i = 0; i < ncols; i++)
+		{
+			if (!u)
+			{
+				fclose(fp);
+				return -2;
+			}
+
+			*sum += strtof(u, 0);
+			u = strtok_r(0, ",", &t);
+		}
+
+		(*rows)++;
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+static int parseRowReader(const char* path, int ncols, double* sum, long* rows)
+{
+	RowReader rr;
+	if (RowReader_open(&rr, path) != 0)
+	{
+		return -1;
+	}
+
+	float cols[ROW_PARSER_MAX_COLS];
+	int rc;
+
+	*sum = 0.0;
+	*rows = 0;
+
+	while ((rc = RowReader_next(&rr, cols, ncols)) == 1)
+	{
+		for (int i = 0; i < ncols; i++)
+		{
+			*sum += cols[i];
+		}
+
+		(*rows)++;
+	}
+
+	RowReader_close(&rr);
+	return rc;
+}
+
+static int gzipFile(const char* src, const char* dst)
+{
+	FILE* in = fopen(src, "rb");
+	if (!in)
+	{
+		return -1;
+	}
+
+	gzFile out = gzopen(dst, "wb6");
+	if (!out)
+	{
+		fclose(in);
+		return -1;
+	}
+
+	int rc = 0;
+	char buf[64 * 1024];
+	size_t n;
+
+	while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+	{
+		if ((int) n != gzwrite(out, buf, n))
+		{
+			rc = -1;
+			break;
+		}
+	}
+
+	fclose(in);
+	return ((Z_OK == gzclose(out)) ? rc : -1);
+}
@@ -0,0 +1,514 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "proteus/Weather.h"
+
+#define BENCH_ITERATIONS (5)
+#define BENCH_POSITIONS (200000)
+
+#define WEATHER_DIR_1P00 "./test_data/weather_1p00_f1/"
+
+static void timeSingle(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly, double* best);
+static void timeBatch(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly, double* best);
+static int benchFleet(void);
+static int benchQuantize(void);
+static int benchClusteredFleets(void);
+static int benchSegments(void);
+
+
+int bench_Weather_run()
+{
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00, WEATHER_DIR_1P00))
+	{
+		printf("\t%s (missing)\n", WEATHER_DIR_1P00);
+		return 0;
+	}
+
+	proteus_GeoPos* pos = malloc(BENCH_POSITIONS * sizeof(proteus_GeoPos));
+	proteus_Weather* wx = malloc(BENCH_POSITIONS * sizeof(proteus_Weather));
+	if (!pos || !wx)
+	{
+		free(pos);
+		free(wx);
+		return 1;
+	}
+
+	srand(1);
+	for (int i = 0; i < BENCH_POSITIONS; i++)
+	{
+		pos[i].lat = -90.0 + ((180.0 * rand()) / RAND_MAX);
+		pos[i].lon = -180.0 + ((360.0 * rand()) / RAND_MAX);
+	}
+
+	printf("\t%-24s %14s %14s %8s\n", "query", "get() Mq/s", "getBatch Mq/s", "speedup");
+
+	for (int w = 0; w < 2; w++)
+	{
+		const bool windOnly = (w == 1);
+
+		double bestSingle = INFINITY;
+		double bestBatch = INFINITY;
+
+		timeSingle(pos, wx, windOnly, &bestSingle);
+		timeBatch(pos, wx, windOnly, &bestBatch);
+
+		const double mq = BENCH_POSITIONS / 1000000.0;
+		printf("\t%-24s %14.2f %14.2f %7.2fx\n", (windOnly ? "wind only" : "all fields"), mq / bestSingle, mq / bestBatch, bestSingle / bestBatch);
+	}
+
+	// Current time queries using a time-blended grid (4 rather than 8 points per query)
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	opts.blendInterval = 60;
+
+	if (0 == proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00, WEATHER_DIR_1P00, &opts))
+	{
+		for (int w = 0; w < 2; w++)
+		{
+			const bool windOnly = (w == 1);
+
+			double bestSingle = INFINITY;
+			double bestBatch = INFINITY;
+
+			timeSingle(pos, wx, windOnly, &bestSingle);
+			timeBatch(pos, wx, windOnly, &bestBatch);
+
+			const double mq = BENCH_POSITIONS / 1000000.0;
+			printf("\t%-24s %14.2f %14.2f %7.2fx\n", (windOnly ? "wind only (blended)" : "all fields (blended)"), mq / bestSingle, mq / bestBatch, bestSingle / bestBatch);
+		}
+
+		proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00, WEATHER_DIR_1P00);
+	}
+
+	free(pos);
+	free(wx);
+
+	if (benchFleet() != 0)
+	{
+		return 1;
+	}
+
+	if (benchQuantize() != 0)
+	{
+		return 1;
+	}
+
+	if (benchClusteredFleets() != 0)
+	{
+		return 1;
+	}
+
+	return benchSegments();
+}
+
+
+static void timeSingle(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly, double* best)
+{
+	for (int k = 0; k < BENCH_ITERATIONS; k++)
+	{
+		const double t0 = bench_now();
+		for (int i = 0; i < BENCH_POSITIONS; i++)
+		{
+			proteus_Weather_get(pos + i, wx + i, windOnly);
+		}
+		const double t = bench_now() - t0;
+
+		if (t < *best)
+		{
+			*best = t;
+		}
+	}
+}
+
+static void timeBatch(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly, double* best)
+{
+	for (int k = 0; k < BENCH_ITERATIONS; k++)
+	{
+		const double t0 = bench_now();
+		proteus_Weather_getBatch(pos, BENCH_POSITIONS, wx, 0, windOnly);
+		const double t = bench_now() - t0;
+
+		if (t < *best)
+		{
+			*best = t;
+		}
+	}
+}
+
+
+#define BENCH_FLEET_BOATS (1000)
+#define BENCH_FLEET_TICKS (200)
+
+// Boats moving a few metres per tick, each queried once per tick (with and without a cache per boat)
+static int benchFleet(void)
+{
+	proteus_GeoPos* pos = malloc(BENCH_FLEET_BOATS * sizeof(proteus_GeoPos));
+	double* heading = malloc(BENCH_FLEET_BOATS * sizeof(double));
+	proteus_WeatherCache** caches = calloc(BENCH_FLEET_BOATS, sizeof(proteus_WeatherCache*));
+	if (!pos || !heading || !caches)
+	{
+		free(pos);
+		free(heading);
+		free(caches);
+		return 1;
+	}
+
+	for (int i = 0; i < BENCH_FLEET_BOATS; i++)
+	{
+		caches[i] = proteus_Weather_createCache();
+	}
+
+	const time_t now = time(0);
+	double best[2] = { INFINITY, INFINITY };
+
+	for (int k = 0; k < BENCH_ITERATIONS; k++)
+	{
+		for (int c = 0; c < 2; c++)
+		{
+			srand(2);
+			for (int i = 0; i < BENCH_FLEET_BOATS; i++)
+			{
+				pos[i].lat = -60.0 + ((120.0 * rand()) / RAND_MAX);
+				pos[i].lon = -180.0 + ((360.0 * rand()) / RAND_MAX);
+				heading[i] = (2.0 * M_PI * rand()) / RAND_MAX;
+			}
+
+			proteus_Weather wx;
+
+			const double t0 = bench_now();
+			for (int tick = 0; tick < BENCH_FLEET_TICKS; tick++)
+			{
+				for (int i = 0; i < BENCH_FLEET_BOATS; i++)
+				{
+					// About 5 metres per tick
+					pos[i].lat += 0.000045 * cos(heading[i]);
+					pos[i].lon += 0.000045 * sin(heading[i]);
+
+					if (c == 0)
+					{
+						proteus_Weather_getAt(pos + i, now, &wx, PROTEUS_WX_FIELD_ALL);
+					}
+					else
+					{
+						proteus_Weather_getCached(caches[i], pos + i, now, &wx, PROTEUS_WX_FIELD_ALL);
+					}
+				}
+			}
+			const double t = bench_now() - t0;
+
+			if (t < best[c])
+			{
+				best[c] = t;
+			}
+		}
+	}
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	for (int i = 0; i < BENCH_FLEET_BOATS; i++)
+	{
+		proteus_WeatherCacheStats stats;
+		proteus_Weather_getCacheStats(caches[i], &stats);
+		hits += stats.hits;
+		misses += stats.misses;
+
+		proteus_Weather_freeCache(caches[i]);
+	}
+
+	const double mq = (BENCH_FLEET_BOATS * BENCH_FLEET_TICKS) / 1000000.0;
+	printf("\t%-24s %14s %14s %8s\n", "fleet query", "getAt() Mq/s", "cached Mq/s", "speedup");
+	printf("\t%-24s %14.2f %14.2f %7.2fx\n", "all fields", mq / best[0], mq / best[1], best[0] / best[1]);
+	printf("\tcache hit rate: %.2f%%\n", (100.0 * hits) / (hits + misses));
+
+	free(pos);
+	free(heading);
+	free(caches);
+
+	return 0;
+}
+
+
+// Random all-field queries of unquantized (32-bit) and quantized (16-bit) grids. The 0.25 degree
+// grid is only sparsely filled from the 1.00 degree data, but its memory footprint is that of a
+// full 0.25 degree grid, so this shows whether halving it saves cache misses on a given machine.
+static int benchQuantize(void)
+{
+	static const struct
+	{
+		const char* name;
+		int sourceDataGrid;
+		size_t points;
+	} grids[] = {
+		{ "1.00 degree grid", PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, 360 * 181 },
+		{ "0.25 degree grid", PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25, 1440 * 721 }
+	};
+
+	proteus_GeoPos* pos = malloc(BENCH_POSITIONS * sizeof(proteus_GeoPos));
+	proteus_Weather* wx = malloc(BENCH_POSITIONS * sizeof(proteus_Weather));
+	if (!pos || !wx)
+	{
+		free(pos);
+		free(wx);
+		return 1;
+	}
+
+	srand(3);
+	for (int i = 0; i < BENCH_POSITIONS; i++)
+	{
+		pos[i].lat = -90.0 + ((180.0 * rand()) / RAND_MAX);
+		pos[i].lon = -180.0 + ((360.0 * rand()) / RAND_MAX);
+	}
+
+	printf("\t%-24s %14s %14s %8s %16s\n", "quantized query", "float Mq/s", "16-bit Mq/s", "speedup", "MB per step");
+
+	for (size_t g = 0; g < sizeof(grids) / sizeof(grids[0]); g++)
+	{
+		double best[2] = { INFINITY, INFINITY };
+		bool ok = true;
+
+		for (int q = 0; q < 2 && ok; q++)
+		{
+			proteus_WeatherOptions opts;
+			proteus_Weather_getDefaultOptions(&opts);
+			opts.quantize = (q == 1);
+
+			ok = (0 == proteus_Weather_initWithOptions(grids[g].sourceDataGrid, WEATHER_DIR_1P00, WEATHER_DIR_1P00, &opts));
+			if (ok)
+			{
+				timeSingle(pos, wx, false, best + q);
+			}
+		}
+
+		if (!ok)
+		{
+			printf("\t%-24s (init failed)\n", grids[g].name);
+			continue;
+		}
+
+		// 9 fields and a byte of conditions per point
+		const double mq = BENCH_POSITIONS / 1000000.0;
+		printf("\t%-24s %14.2f %14.2f %7.2fx %7.1f / %-6.1f\n", grids[g].name, mq / best[0], mq / best[1], best[0] / best[1],
+				(grids[g].points * 37) / 1000000.0, (grids[g].points * 19) / 1000000.0);
+	}
+
+	proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00, WEATHER_DIR_1P00);
+
+	free(pos);
+	free(wx);
+
+	return 0;
+}
+
+
+#define BENCH_CLUSTER_FLEETS (8)
+#define BENCH_CLUSTER_BOATS (1000)
+#define BENCH_CLUSTER_SPREAD (10.0)
+
+// Several fleets of boats, each spread over a region some 10 degrees across (such as a race
+// or a shipping lane), queried boat by boat with the fleets interleaved, on the 0.25 degree grid
+// (sparsely filled from the 1.00 degree data, see benchQuantize()), stored row by row and in tiles.
+static int benchClusteredFleets(void)
+{
+	const size_t n = BENCH_CLUSTER_FLEETS * BENCH_CLUSTER_BOATS;
+
+	proteus_GeoPos* pos = malloc(n * sizeof(proteus_GeoPos));
+	proteus_Weather* wx = malloc(n * sizeof(proteus_Weather));
+	if (!pos || !wx)
+	{
+		free(pos);
+		free(wx);
+		return 1;
+	}
+
+	srand(4);
+
+	proteus_GeoPos centres[BENCH_CLUSTER_FLEETS];
+	for (int f = 0; f < BENCH_CLUSTER_FLEETS; f++)
+	{
+		centres[f].lat = -50.0 + ((100.0 * rand()) / RAND_MAX);
+		centres[f].lon = -170.0 + ((340.0 * rand()) / RAND_MAX);
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const proteus_GeoPos* c = centres + (i % BENCH_CLUSTER_FLEETS);
+		pos[i].lat = c->lat + (BENCH_CLUSTER_SPREAD * (((double) rand() / RAND_MAX) - 0.5));
+		pos[i].lon = c->lon + (BENCH_CLUSTER_SPREAD * (((double) rand() / RAND_MAX) - 0.5));
+	}
+
+	// Best times by layout (row by row, then tiled), by fields queried, and by single or batch queries
+	double best[2][2][2];
+
+	for (int tiled = 0; tiled < 2; tiled++)
+	{
+		proteus_WeatherOptions opts;
+		proteus_Weather_getDefaultOptions(&opts);
+		opts.rowMajor = (tiled == 0);
+
+		if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25, WEATHER_DIR_1P00, WEATHER_DIR_1P00, &opts))
+		{
+			printf("\tclustered fleets (init failed)\n");
+			proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00, WEATHER_DIR_1P00);
+			free(pos);
+			free(wx);
+			return 0;
+		}
+
+		for (int w = 0; w < 2; w++)
+		{
+			const bool windOnly = (w == 1);
+
+			best[tiled][w][0] = INFINITY;
+			best[tiled][w][1] = INFINITY;
+
+			for (int k = 0; k < BENCH_ITERATIONS; k++)
+			{
+				double t0 = bench_now();
+				for (size_t i = 0; i < n; i++)
+				{
+					proteus_Weather_get(pos + i, wx + i, windOnly);
+				}
+				double t = bench_now() - t0;
+
+				if (t < best[tiled][w][0])
+				{
+					best[tiled][w][0] = t;
+				}
+
+				t0 = bench_now();
+				proteus_Weather_getBatch(pos, n, wx, 0, windOnly);
+				t = bench_now() - t0;
+
+				if (t < best[tiled][w][1])
+				{
+					best[tiled][w][1] = t;
+				}
+			}
+		}
+	}
+
+	proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00, WEATHER_DIR_1P00);
+
+	// (Speedups are those of the tiled layout over the row-major one, for single and batch queries.)
+	printf("\t%-24s %14s %14s %15s\n", "clustered fleets (0.25)", "get() Mq/s", "getBatch Mq/s", "speedup");
+
+	const double mq = n / 1000000.0;
+	for (int w = 0; w < 2; w++)
+	{
+		const char* fields = (w == 1 ? "wind only" : "all fields");
+		char name[32];
+
+		snprintf(name, sizeof(name), "%s (row-major)", fields);
+		printf("\t%-24s %14.2f %14.2f\n", name, mq / best[0][w][0], mq / best[0][w][1]);
+
+		snprintf(name, sizeof(name), "%s (tiled)", fields);
+		printf("\t%-24s %14.2f %14.2f %6.2fx / %.2fx\n", name, mq / best[1][w][0], mq / best[1][w][1],
+				best[0][w][0] / best[1][w][0], best[0][w][1] / best[1][w][1]);
+	}
+
+	free(pos);
+	free(wx);
+
+	return 0;
+}
+
+
+#define BENCH_SEGMENT_LEGS (1000)
+#define BENCH_SEGMENT_SAMPLES (300)
+
+// Candidate route legs of a few degrees, each sampled at evenly spaced positions (by a query per
+// position, and by sampling the whole leg at once)
+static int benchSegments(void)
+{
+	proteus_WeatherSegment* legs = malloc(BENCH_SEGMENT_LEGS * sizeof(proteus_WeatherSegment));
+	proteus_GeoPos* pos = malloc(BENCH_SEGMENT_LEGS * BENCH_SEGMENT_SAMPLES * sizeof(proteus_GeoPos));
+	proteus_Weather* wx = malloc(BENCH_SEGMENT_SAMPLES * sizeof(proteus_Weather));
+	if (!legs || !pos || !wx)
+	{
+		free(legs);
+		free(pos);
+		free(wx);
+		return 1;
+	}
+
+	printf("\t%-24s %14s %14s %8s\n", "segment samples", "getAt() Mq/s", "sample Mq/s", "speedup");
+
+	for (int gc = 0; gc < 2; gc++)
+	{
+		srand(4);
+		for (int i = 0; i < BENCH_SEGMENT_LEGS; i++)
+		{
+			proteus_WeatherSegment* leg = legs + i;
+
+			leg->start.lat = -60.0 + ((120.0 * rand()) / RAND_MAX);
+			leg->start.lon = -170.0 + ((340.0 * rand()) / RAND_MAX);
+			leg->end.lat = leg->start.lat - 2.5 + ((5.0 * rand()) / RAND_MAX);
+			leg->end.lon = leg->start.lon - 2.5 + ((5.0 * rand()) / RAND_MAX);
+			leg->greatCircle = (gc != 0);
+			leg->startTime = time(0);
+			leg->speed = 5.0;
+
+			// (Positions to query one at a time, and the times at which they're reached, are those sampled.)
+			proteus_Weather_sampleSegment(leg, BENCH_SEGMENT_SAMPLES, pos + (i * BENCH_SEGMENT_SAMPLES), wx, 0, PROTEUS_WX_FIELD_ALL);
+		}
+
+		double best[2] = { INFINITY, INFINITY };
+
+		for (int k = 0; k < BENCH_ITERATIONS; k++)
+		{
+			for (int c = 0; c < 2; c++)
+			{
+				const double t0 = bench_now();
+				for (int i = 0; i < BENCH_SEGMENT_LEGS; i++)
+				{
+					if (c == 0)
+					{
+						const proteus_GeoPos* legPos = pos + (i * BENCH_SEGMENT_SAMPLES);
+						for (int j = 0; j < BENCH_SEGMENT_SAMPLES; j++)
+						{
+							proteus_Weather_getAt(legPos + j, legs[i].startTime, wx + j, PROTEUS_WX_FIELD_ALL);
+						}
+					}
+					else
+					{
+						proteus_Weather_sampleSegment(legs + i, BENCH_SEGMENT_SAMPLES, 0, wx, 0, PROTEUS_WX_FIELD_ALL);
+					}
+				}
+				const double t = bench_now() - t0;
+
+				if (t < best[c])
+				{
+					best[c] = t;
+				}
+			}
+		}
+
+		const double mq = (BENCH_SEGMENT_LEGS * BENCH_SEGMENT_SAMPLES) / 1000000.0;
+		printf("\t%-24s %14.2f %14.2f %7.2fx\n", (gc ? "great circle, all fields" : "track, all fields"), mq / best[0], mq / best[1], best[0] / best[1]);
+	}
+
+	free(legs);
+	free(pos);
+	free(wx);
+
+	return 0;
+}
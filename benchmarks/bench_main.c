@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <proteus/proteus.h>
+
+#include "bench.h"
+
+typedef int (*bench_func)(void);
+
+static const char* BENCH_NAMES[] = {
+	"RowParser",
+	"Weather"
+};
+
+static const bench_func BENCH_FUNCS[] = {
+	&bench_RowParser_run,
+	&bench_Weather_run
+};
+
+int main()
+{
+	int sum = 0;
+
+	printf("Running benchmarks for libproteus v%s\n", proteus_getVersionString());
+
+	for (size_t i = 0; i < (sizeof(BENCH_NAMES) / sizeof(const char*)); i++)
+	{
+		printf("%s...\n", BENCH_NAMES[i]);
+
+		if (0 != BENCH_FUNCS[i]())
+		{
+			printf("\tFAILED!\n");
+			sum++;
+		}
+	}
+
+	return sum;
+}
@@ -18,6 +18,9 @@
 #define _proteus_Ocean_h_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 
 #include <proteus/proteus.h>
 #include <proteus/GeoPos.h>
@@ -40,11 +43,64 @@ typedef struct
 	float ice; // Sea ice concentration, in percent
 } proteus_OceanData;
 
+/**
+ * Ocean data fields that may be requested (see proteus_Ocean_getFields())
+ */
+#define PROTEUS_OCEAN_FIELD_CURRENT (0x0001) // Ocean surface current (current)
+#define PROTEUS_OCEAN_FIELD_SURFACE_TEMP (0x0002) // Sea surface temperature (surfaceTemp)
+#define PROTEUS_OCEAN_FIELD_SALINITY (0x0004) // Sea surface salinity (salinity)
+#define PROTEUS_OCEAN_FIELD_ICE (0x0008) // Sea ice concentration (ice)
+
+#define PROTEUS_OCEAN_FIELD_ALL (0x000f) // All of the above
+
+/**
+ * Options for the ocean data processing system
+ *
+ * Always initialize with proteus_Ocean_getDefaultOptions() before setting
+ * individual options, so that options added in the future get sane defaults.
+ */
+typedef struct
+{
+	bool watchFiles; // Watch the forecast data files for changes (with inotify), and update the ocean
+	                 // grids once either of them has been written, rather than only at the scheduled
+	                 // update times. Updates (whether so triggered or scheduled) are skipped if the
+	                 // content hash of the file matches that of data already loaded. (default: false)
+
+	bool quantize; // Store the ocean grids with 16 bits per value rather than 32, and without ice
+	               // concentrations (which are computed from the stored surface temperature and
+	               // salinity instead), taking about 40% of the memory of unquantized grids (and
+	               // less memory traffic for queries), at the cost of precision. Values outside the
+	               // stored range are clamped to it. (default: false)
+	               //
+	               //   field         stored range             max error of a query
+	               //   current       -16 to 16 m/s            0.00025 m/s (per u/v component)
+	               //   surfaceTemp   -8 to 56 degrees C       0.0005 degrees C
+	               //   salinity      0 to 64                  0.0005
+	               //   ice           (computed)               4 / salinity % (0.12 % at a salinity of 34)
+	               //
+	               // The direction of very weak currents may be affected more than their magnitude.
+
+	int ingestThreads; // Number of threads used to parse each forecast data file, each parsing byte ranges of
+	                   // the file concurrently (default: 1, i.e. no parallelism). Compressed files are
+	                   // always parsed on a single thread.
+} proteus_OceanOptions;
+
+/**
+ * Fills in the default ocean data processing system options.
+ *
+ * Parameters
+ * 	opts [out]: the options to be filled in
+ */
+PROTEUS_API void proteus_Ocean_getDefaultOptions(proteus_OceanOptions* opts);
+
 /**
  * Initializes the ocean data processing system.
  *
  * Assumes two forecast points, 12 hours apart (used for temporal interpolation).
  *
+ * The files may be gzip compressed (detected by their contents, whatever their
+ * names), in which case they are decompressed as they are parsed.
+ *
  * Parameters
  * 	f1File [in]: the path to the file with the first forecast point data
  * 	f2File [in]: the path to the file with the second forecast point data
@@ -55,6 +111,21 @@ typedef struct
  */
 PROTEUS_API int proteus_Ocean_init(const char* f1File, const char* f2File);
 
+/**
+ * Initializes the ocean data processing system, as with proteus_Ocean_init(),
+ * but using the provided options instead of the defaults.
+ *
+ * Parameters
+ * 	f1File [in]: the path to the file with the first forecast point data
+ * 	f2File [in]: the path to the file with the second forecast point data
+ * 	opts [in]: the options to use
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Ocean_initWithOptions(const char* f1File, const char* f2File, const proteus_OceanOptions* opts);
+
 /**
  * Provides ocean information, if available, at the given geographical position.
  *
@@ -68,6 +139,182 @@ PROTEUS_API int proteus_Ocean_init(const char* f1File, const char* f2File);
  */
 PROTEUS_API bool proteus_Ocean_get(const proteus_GeoPos* pos, proteus_OceanData* od);
 
+/**
+ * Provides ocean information, if available, at the given geographical position,
+ * as with proteus_Ocean_get(), but at the given time rather than at the current time.
+ *
+ * Times outside of the loaded forecast window are clamped to it, in the same
+ * way as for current time queries.
+ *
+ * Parameters
+ * 	pos [in]: the geographical position to be queried
+ * 	t [in]: the time to be queried
+ * 	od [out]: the ocean data structure to be populated
+ *
+ * Returns
+ * 	true, if ocean data is available and valid at the provided position
+ * 	false, if ocean data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Ocean_getAt(const proteus_GeoPos* pos, time_t t, proteus_OceanData* od);
+
+/**
+ * Provides selected ocean information at the given geographical position.
+ *
+ * Only the requested fields are interpolated, so requesting fewer fields makes
+ * queries cheaper. Sea ice concentration is kept as a field of its own (computed
+ * from the surface temperature and salinity at each grid point when the data is
+ * loaded), so requesting only PROTEUS_OCEAN_FIELD_ICE reads nothing else, which
+ * suits ice checks and scans over whole regions. (Quantized grids don't keep it,
+ * but compute it from the surface temperature and salinity of each grid point
+ * instead, which are stored next to each other.)
+ *
+ * Requested fields are computed exactly as by proteus_Ocean_get().
+ *
+ * Parameters
+ * 	pos [in]: the geographical position to be queried
+ * 	od [out]: the ocean data structure to be populated; fields which weren't
+ * 	          requested are left untouched
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_OCEAN_FIELD_* values)
+ *
+ * Returns
+ * 	true, if ocean data is available and valid at the provided position
+ * 	false, if ocean data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Ocean_getFields(const proteus_GeoPos* pos, proteus_OceanData* od, uint32_t fields);
+
+/**
+ * Provides selected ocean information at the given geographical position,
+ * as with proteus_Ocean_getFields(), but at the given time rather than at
+ * the current time (as with proteus_Ocean_getAt()).
+ *
+ * Parameters
+ * 	pos [in]: the geographical position to be queried
+ * 	t [in]: the time to be queried
+ * 	od [out]: the ocean data structure to be populated; fields which weren't
+ * 	          requested are left untouched
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_OCEAN_FIELD_* values)
+ *
+ * Returns
+ * 	true, if ocean data is available and valid at the provided position
+ * 	false, if ocean data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Ocean_getFieldsAt(const proteus_GeoPos* pos, time_t t, proteus_OceanData* od, uint32_t fields);
+
+/**
+ * Integration methods for proteus_Ocean_advect()
+ */
+#define PROTEUS_OCEAN_ADVECT_RK2 (2) // Second order Runge-Kutta (midpoint) method
+#define PROTEUS_OCEAN_ADVECT_RK4 (4) // Classic fourth order Runge-Kutta method
+
+/**
+ * Advects particles drifting with the ocean surface current (e.g. people in the
+ * water, debris or drifting marks) over a number of time steps, integrating their
+ * paths through the currents of the loaded forecast window.
+ *
+ * This replaces querying the current at each particle (with proteus_Ocean_getAt())
+ * and advancing the particle along it (with proteus_GeoPos_advance()) at every
+ * step, and is much faster for large numbers of particles: particles are advected
+ * in blocks, with the currents of a block interpolated together, and spread over
+ * multiple threads for large numbers of particles.
+ *
+ * Currents are interpolated in space and time as by proteus_Ocean_getAt() (but
+ * at fractional times within steps, as the integration method requires). All
+ * particles are advected through the same ocean data, as ocean data updates wait
+ * for the call to finish.
+ *
+ * A particle is stopped once it reaches land (a grid cell with no water at any of
+ * its corners) or leaves the ocean grid: if the current isn't available at any of
+ * the positions the integration method evaluates it at within a step, the particle
+ * stays at its position at the start of that step, and is no longer advected.
+ *
+ * Parameters
+ * 	pos [in/out]: the positions of the particles, advanced in place
+ * 	n [in]: the number of particles
+ * 	startTime [in]: the time at the start of the first step
+ * 	dt [in]: the length of each step, in seconds (negative to advect backwards in time)
+ * 	steps [in]: the number of steps
+ * 	method [in]: the integration method (one of the PROTEUS_OCEAN_ADVECT_* values)
+ * 	threads [in]: the maximum number of threads to use (at least 1); no more
+ * 	              than one per thousand or so particles are used
+ * 	drifting [in/out]: if not NULL, whether each particle is drifting; particles
+ * 	                   not drifting on input are left untouched, and those stopped
+ * 	                   are cleared on output
+ *
+ * Returns
+ * 	the number of particles still drifting after the last step, on success
+ * 	-3, if any of the arguments are invalid
+ * 	any other negative value, on failure
+ */
+PROTEUS_API int proteus_Ocean_advect(proteus_GeoPos* pos, int n, time_t startTime, double dt, int steps, int method, int threads, bool* drifting);
+
+/**
+ * Ocean data grid statistics
+ */
+typedef struct
+{
+	size_t bytes; // Memory held by the loaded grids (both of them), in bytes
+	int coastalCells; // Cells of the latest grid with both water and land corners
+} proteus_OceanGridStats;
+
+/**
+ * Provides the statistics of the loaded ocean data grids.
+ *
+ * A grid holds each grid point's values once (using about 7.8 MB, or about 3.2 MB
+ * if quantized, against about 7.7 MB for a struct per grid point). The values at
+ * the land corners of coastal cells aren't stored, but are worked out by queries
+ * of those cells (as the average of their water corners).
+ *
+ * Parameters
+ * 	stats [out]: the statistics of the grids (all zeros, if not initialized)
+ */
+PROTEUS_API void proteus_Ocean_getGridStats(proteus_OceanGridStats* stats);
+
+
+/**
+ * An ocean context, holding the forecast data of one pair of files (and its
+ * configuration) independently of any other context.
+ *
+ * The proteus_Ocean_*() functions above (other than
+ * proteus_Ocean_getDefaultOptions()) operate on the default context. Each has a
+ * proteus_OceanCtx_*() counterpart below, which behaves the same but operates on
+ * the given context.
+ */
+typedef struct proteus_OceanCtx proteus_OceanCtx;
+
+/**
+ * Creates an ocean context, to be initialized with proteus_OceanCtx_init() or
+ * proteus_OceanCtx_initWithOptions().
+ *
+ * Returns
+ * 	the new context, or NULL on failure
+ */
+PROTEUS_API proteus_OceanCtx* proteus_OceanCtx_create(void);
+
+/**
+ * Destroys an ocean context, stopping its updates and freeing its forecast data.
+ * It must not be queried (by any thread) once this is called.
+ *
+ * Parameters
+ * 	ctx [in]: the context to be destroyed (may be NULL; the default context
+ * 	          is never destroyed)
+ */
+PROTEUS_API void proteus_OceanCtx_destroy(proteus_OceanCtx* ctx);
+
+/**
+ * Returns the default ocean context (the one used by the proteus_Ocean_*()
+ * functions).
+ */
+PROTEUS_API proteus_OceanCtx* proteus_OceanCtx_getDefault(void);
+
+PROTEUS_API int proteus_OceanCtx_init(proteus_OceanCtx* ctx, const char* f1File, const char* f2File);
+PROTEUS_API int proteus_OceanCtx_initWithOptions(proteus_OceanCtx* ctx, const char* f1File, const char* f2File, const proteus_OceanOptions* opts);
+PROTEUS_API bool proteus_OceanCtx_get(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, proteus_OceanData* od);
+PROTEUS_API bool proteus_OceanCtx_getAt(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_OceanData* od);
+PROTEUS_API bool proteus_OceanCtx_getFields(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, proteus_OceanData* od, uint32_t fields);
+PROTEUS_API bool proteus_OceanCtx_getFieldsAt(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_OceanData* od, uint32_t fields);
+PROTEUS_API int proteus_OceanCtx_advect(proteus_OceanCtx* ctx, proteus_GeoPos* pos, int n, time_t startTime, double dt, int steps, int method, int threads, bool* drifting);
+PROTEUS_API void proteus_OceanCtx_getGridStats(proteus_OceanCtx* ctx, proteus_OceanGridStats* stats);
+
 
 #ifdef __cplusplus
 }
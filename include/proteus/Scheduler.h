@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _proteus_Scheduler_h_
+#define _proteus_Scheduler_h_
+
+#include <time.h>
+
+#include <proteus/proteus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+
+/**
+ * Background jobs of the library (such as the periodic forecast data updates of
+ * the weather, ocean and wave modules) all run on a single scheduler thread,
+ * which sleeps until the deadline of the next job.
+ */
+
+/**
+ * A clock, returning the current time (as with time(0))
+ */
+typedef time_t (*proteus_SchedulerClock)(void);
+
+/**
+ * Gets the time at which the next scheduled job is due.
+ *
+ * Returns
+ * 	the deadline of the next job, or zero if there are no scheduled jobs
+ */
+PROTEUS_API time_t proteus_Scheduler_getNextTime(void);
+
+/**
+ * Replaces the clock used to schedule jobs (intended for testing).
+ *
+ * While a clock is set, the scheduler thread doesn't run any jobs, and due jobs
+ * only run on calls to proteus_Scheduler_runDue(). Modules initialized while a
+ * clock is set schedule their first jobs relative to its time.
+ *
+ * Parameters
+ * 	clock [in]: the clock to use, or zero to go back to the system clock
+ */
+PROTEUS_API void proteus_Scheduler_setClock(proteus_SchedulerClock clock);
+
+/**
+ * Runs all jobs which are due (according to the scheduler clock) on the calling
+ * thread, including jobs which become due again while running them.
+ *
+ * Returns
+ * 	the number of jobs run
+ */
+PROTEUS_API int proteus_Scheduler_runDue(void);
+
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _proteus_Scheduler_h_
@@ -18,6 +18,7 @@
 #define _proteus_Wave_h_
 
 #include <stdbool.h>
+#include <time.h>
 
 #include <proteus/proteus.h>
 #include <proteus/GeoPos.h>
@@ -35,11 +36,40 @@ typedef struct
 	float waveHeight; // Wave height, in metres
 } proteus_WaveData;
 
+/**
+ * Options for the wave data processing system
+ *
+ * Always initialize with proteus_Wave_getDefaultOptions() before setting
+ * individual options, so that options added in the future get sane defaults.
+ */
+typedef struct
+{
+	bool watchFiles; // Watch the forecast data files for changes (with inotify), and update the wave
+	                 // grids once either of them has been written, rather than only at the scheduled
+	                 // update times. Updates (whether so triggered or scheduled) are skipped if the
+	                 // content hash of the file matches that of data already loaded. (default: false)
+
+	int ingestThreads; // Number of threads used to parse each forecast data file, each parsing byte ranges of
+	                   // the file concurrently (default: 1, i.e. no parallelism). Compressed files are
+	                   // always parsed on a single thread.
+} proteus_WaveOptions;
+
+/**
+ * Fills in the default wave data processing system options.
+ *
+ * Parameters
+ * 	opts [out]: the options to be filled in
+ */
+PROTEUS_API void proteus_Wave_getDefaultOptions(proteus_WaveOptions* opts);
+
 /**
  * Initializes the wave data processing system.
  *
  * Assumes two forecast points, 12 hours apart (used for temporal interpolation).
  *
+ * The files may be gzip compressed (detected by their contents, whatever their
+ * names), in which case they are decompressed as they are parsed.
+ *
  * Parameters
  * 	f1File [in]: the path to the file with the first forecast point data
  * 	f2File [in]: the path to the file with the second forecast point data
@@ -50,6 +80,21 @@ typedef struct
  */
 PROTEUS_API int proteus_Wave_init(const char* f1File, const char* f2File);
 
+/**
+ * Initializes the wave data processing system, as with proteus_Wave_init(),
+ * but using the provided options instead of the defaults.
+ *
+ * Parameters
+ * 	f1File [in]: the path to the file with the first forecast point data
+ * 	f2File [in]: the path to the file with the second forecast point data
+ * 	opts [in]: the options to use
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Wave_initWithOptions(const char* f1File, const char* f2File, const proteus_WaveOptions* opts);
+
 /**
  * Provides wave information, if available, at the given geographical position.
  *
@@ -63,6 +108,66 @@ PROTEUS_API int proteus_Wave_init(const char* f1File, const char* f2File);
  */
 PROTEUS_API bool proteus_Wave_get(const proteus_GeoPos* pos, proteus_WaveData* wd);
 
+/**
+ * Provides wave information, if available, at the given geographical position,
+ * as with proteus_Wave_get(), but at the given time rather than at the current time.
+ *
+ * Times outside of the loaded forecast window are clamped to it, in the same
+ * way as for current time queries.
+ *
+ * Parameters
+ * 	pos [in]: the geographical position to be queried
+ * 	t [in]: the time to be queried
+ * 	wd [out]: the wave data structure to be populated
+ *
+ * Returns
+ * 	true, if wave data is available and valid at the provided position
+ * 	false, if wave data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Wave_getAt(const proteus_GeoPos* pos, time_t t, proteus_WaveData* wd);
+
+
+/**
+ * A wave context, holding the forecast data of one pair of files (and its
+ * configuration) independently of any other context.
+ *
+ * The proteus_Wave_*() functions above (other than
+ * proteus_Wave_getDefaultOptions()) operate on the default context. Each has a
+ * proteus_WaveCtx_*() counterpart below, which behaves the same but operates on
+ * the given context.
+ */
+typedef struct proteus_WaveCtx proteus_WaveCtx;
+
+/**
+ * Creates a wave context, to be initialized with proteus_WaveCtx_init() or
+ * proteus_WaveCtx_initWithOptions().
+ *
+ * Returns
+ * 	the new context, or NULL on failure
+ */
+PROTEUS_API proteus_WaveCtx* proteus_WaveCtx_create(void);
+
+/**
+ * Destroys a wave context, stopping its updates and freeing its forecast data.
+ * It must not be queried (by any thread) once this is called.
+ *
+ * Parameters
+ * 	ctx [in]: the context to be destroyed (may be NULL; the default context
+ * 	          is never destroyed)
+ */
+PROTEUS_API void proteus_WaveCtx_destroy(proteus_WaveCtx* ctx);
+
+/**
+ * Returns the default wave context (the one used by the proteus_Wave_*()
+ * functions).
+ */
+PROTEUS_API proteus_WaveCtx* proteus_WaveCtx_getDefault(void);
+
+PROTEUS_API int proteus_WaveCtx_init(proteus_WaveCtx* ctx, const char* f1File, const char* f2File);
+PROTEUS_API int proteus_WaveCtx_initWithOptions(proteus_WaveCtx* ctx, const char* f1File, const char* f2File, const proteus_WaveOptions* opts);
+PROTEUS_API bool proteus_WaveCtx_get(proteus_WaveCtx* ctx, const proteus_GeoPos* pos, proteus_WaveData* wd);
+PROTEUS_API bool proteus_WaveCtx_getAt(proteus_WaveCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_WaveData* wd);
+
 
 #ifdef __cplusplus
 }
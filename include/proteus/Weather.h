@@ -18,7 +18,9 @@
 #define _proteus_Weather_h_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 #include <proteus/proteus.h>
 #include <proteus/GeoPos.h>
@@ -57,15 +59,99 @@ typedef struct
 	uint8_t cond; // Precipitation conditions (rain, snow, ice pellets, freezing rain)
 } proteus_Weather;
 
+/**
+ * Weather fields that may be requested (see proteus_Weather_getFields())
+ */
+#define PROTEUS_WX_FIELD_WIND (0x0001) // Wind vector (wind)
+#define PROTEUS_WX_FIELD_WIND_GUST (0x0002) // Wind gust speed (windGust)
+#define PROTEUS_WX_FIELD_TEMP (0x0004) // Temperature (temp)
+#define PROTEUS_WX_FIELD_DEWPOINT (0x0008) // Dew point temperature (dewpoint)
+#define PROTEUS_WX_FIELD_PRESSURE (0x0010) // Mean sea level pressure (pressure)
+#define PROTEUS_WX_FIELD_CLOUD (0x0020) // Cloud coverage (cloud)
+#define PROTEUS_WX_FIELD_VISIBILITY (0x0040) // Visibility (visibility)
+#define PROTEUS_WX_FIELD_PRATE (0x0080) // Precipitation rate (prate)
+#define PROTEUS_WX_FIELD_COND (0x0100) // Precipitation conditions (cond)
+
+#define PROTEUS_WX_FIELD_ALL (0x01ff) // All of the above
+
 #define PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00 (0) // 1.00 degree grid
 #define PROTEUS_WEATHER_SOURCE_DATA_GRID_0P50 (1) // 0.50 degree grid
 #define PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25 (2) // 0.25 degree grid
 
+/**
+ * Name of the binary weather grid snapshot file within a forecast data directory
+ */
+#define PROTEUS_WEATHER_SNAPSHOT_FILE_NAME "wx_grid.bin"
+
+/**
+ * Options for the weather processing system
+ *
+ * Always initialize with proteus_Weather_getDefaultOptions() before setting
+ * individual options, so that options added in the future get sane defaults.
+ */
+typedef struct
+{
+	int ingestThreads; // Number of threads used to parse the forecast data files of a
+	                   // forecast point concurrently (default: 1, i.e. no parallelism)
+
+	int timelineSteps; // Maximum number of forecast steps held at once, when initialized
+	                   // with proteus_Weather_initTimeline() (default: 8)
+
+	int blendInterval; // Seconds between refreshes of a grid of forecast data blended for the current
+	                   // time, used by current time queries instead of interpolating between forecast
+	                   // steps. This bounds the staleness of their results. (default: 0, i.e. disabled)
+
+	bool quantize; // Store the weather grids with 16 bits per value rather than 32, roughly halving
+	               // their memory footprint (and the memory traffic of queries), at the cost of
+	               // precision. Values outside the stored range are clamped to it. (default: false)
+	               //
+	               //   field         stored range             max error of a query
+	               //   wind          -128 to 128 m/s          0.002 m/s (per u/v component)
+	               //   windGust      0 to 128 m/s             0.001 m/s
+	               //   temp          150 to 406 K             0.002 degrees C
+	               //   dewpoint      150 to 406 K             0.002 degrees C
+	               //   pressure      800 to 1127 hPa          0.0025 hPa
+	               //   cloud         0 to 128 %               0.001 %
+	               //   visibility    0 to 32767 m             0.25 m
+	               //   prate         0 to 0.0655 kg/m^2/s     0.0018 mm/h
+	               //
+	               // The errors above are those of quantization only, and are doubled for current time
+	               // queries using the time-blended grid (see blendInterval). cond is unaffected.
+
+	bool hugePages; // Back the weather grids with explicit huge pages (MAP_HUGETLB), if any are
+	                // available (otherwise they are only advised to use transparent huge pages).
+	                // (default: false)
+
+	bool watchFiles; // Watch the forecast data directories for changes (with inotify), and update the
+	                 // weather grids once a complete set of forecast data has been written to either
+	                 // of them, rather than only at the scheduled update times. Updates (whether so
+	                 // triggered or scheduled) are skipped if the content hash of the forecast data
+	                 // matches that of forecast data already loaded. Not used in timeline mode.
+	                 // (default: false)
+
+	bool rowMajor; // Store the 0.50 and 0.25 degree weather grids row by row, rather than in tiles of
+	               // 8x8 grid points, which keep the grid points near a position closer together in
+	               // memory. This is mainly for comparing the two layouts. (default: false)
+} proteus_WeatherOptions;
+
+/**
+ * Fills in the default weather processing system options.
+ *
+ * Parameters
+ * 	opts [out]: the options to be filled in
+ */
+PROTEUS_API void proteus_Weather_getDefaultOptions(proteus_WeatherOptions* opts);
+
 /**
  * Initializes the weather processing system.
  *
  * Assumes two forecast points, 3 hours apart (used for temporal interpolation).
  *
+ * If a forecast data directory contains a valid binary snapshot (see
+ * proteus_Weather_writeSnapshot()), it is loaded in place of the CSV files.
+ * Each CSV file may instead be gzip compressed, with a ".gz" suffix added to its
+ * name (e.g. "tmp.csv.gz"), in which case it is decompressed as it is parsed.
+ *
  * Parameters
  * 	sourceDataGrid [in]: the source data grid resolution
  * 	f1Dir [in]: the path to the directory with the first forecast point data
@@ -77,6 +163,144 @@ typedef struct
  */
 PROTEUS_API int proteus_Weather_init(int sourceDataGrid, const char* f1Dir, const char* f2Dir);
 
+/**
+ * Initializes the weather processing system, as with proteus_Weather_init(),
+ * but using the provided options instead of the defaults.
+ *
+ * Parameters
+ * 	sourceDataGrid [in]: the source data grid resolution
+ * 	f1Dir [in]: the path to the directory with the first forecast point data
+ * 	f2Dir [in]: the path to the directory with the second forecast point data
+ * 	opts [in]: the options to use
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Weather_initWithOptions(int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherOptions* opts);
+
+/**
+ * A region of interest, as a longitude/latitude bounding box (in degrees)
+ *
+ * The box spans eastward from west to east, so a box with east < west crosses
+ * the 180 degree line of longitude (e.g. west = 150, east = -120 for the North
+ * Pacific).
+ */
+typedef struct
+{
+	double west;
+	double east;
+	double south;
+	double north;
+
+	double margin; // Added to each side of the box (in degrees)
+} proteus_WeatherRegion;
+
+/**
+ * Initializes the weather processing system, as with
+ * proteus_Weather_initWithOptions(), but only loading and storing the forecast
+ * data of a region (and its margin), which bounds memory use (and the time
+ * taken by updates) roughly in proportion to its area.
+ *
+ * Queries outside of the region (and its margin) fail, just as queries with an
+ * invalid longitude/latitude do.
+ *
+ * Parameters
+ * 	sourceDataGrid [in]: the source data grid resolution
+ * 	f1Dir [in]: the path to the directory with the first forecast point data
+ * 	f2Dir [in]: the path to the directory with the second forecast point data
+ * 	region [in]: the region of interest (or null, for the whole globe)
+ * 	opts [in]: the options to use
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Weather_initRegion(int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherRegion* region, const proteus_WeatherOptions* opts);
+
+/**
+ * Initializes the weather processing system with a timeline of forecast steps,
+ * instead of two forecast points at fixed times.
+ *
+ * Each forecast step is loaded from its own forecast data directory (as with
+ * proteus_Weather_init()), and has its own valid time. Queries interpolate
+ * between the pair of steps bracketing the query time, and times outside of
+ * the range of the steps are clamped to it. In this mode, forecast data isn't
+ * updated automatically: steps are added with proteus_Weather_addStep(), and
+ * evicted either to make room for newer steps (see
+ * proteus_WeatherOptions.timelineSteps) or with proteus_Weather_evictSteps().
+ *
+ * Parameters
+ * 	sourceDataGrid [in]: the source data grid resolution
+ * 	dirs [in]: the paths to the directories with the data of each initial forecast step
+ * 	validTimes [in]: the valid time of each initial forecast step
+ * 	n [in]: the number of initial forecast steps (may be zero, in which case
+ * 	        queries fail until steps are added)
+ * 	opts [in]: the options to use
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Weather_initTimeline(int sourceDataGrid, const char* const* dirs, const time_t* validTimes, int n, const proteus_WeatherOptions* opts);
+
+/**
+ * Loads a forecast step into the timeline (see proteus_Weather_initTimeline()).
+ *
+ * The step replaces any step with the same valid time. If the timeline is
+ * full, the oldest step is evicted. Concurrent queries are never blocked, and
+ * see either the previous or the updated timeline.
+ *
+ * Parameters
+ * 	dir [in]: the path to the directory with the forecast step data
+ * 	validTime [in]: the valid time of the forecast step
+ *
+ * Returns
+ * 	0, on success
+ * 	-3, if not in timeline mode, or if the timeline is full and the step is older than all of its steps
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Weather_addStep(const char* dir, time_t validTime);
+
+/**
+ * Evicts the forecast steps of the timeline which are no longer needed for
+ * queries at or after the given time (see proteus_Weather_initTimeline()).
+ *
+ * Parameters
+ * 	t [in]: the earliest time to be queried from now on
+ *
+ * Returns
+ * 	the number of steps evicted, on success
+ * 	a negative value, on failure
+ */
+PROTEUS_API int proteus_Weather_evictSteps(time_t t);
+
+/**
+ * Provides the valid times of the forecast steps currently held, in order.
+ *
+ * When not in timeline mode, these are the effective valid times of the two
+ * forecast points.
+ *
+ * Parameters
+ * 	validTimes [out]: the valid times of the steps (up to maxSteps of them)
+ * 	maxSteps [in]: the capacity of validTimes
+ *
+ * Returns
+ * 	the number of forecast steps held (which may exceed maxSteps)
+ */
+PROTEUS_API int proteus_Weather_getSteps(time_t* validTimes, int maxSteps);
+
+/**
+ * Provides the time for which current time queries (such as proteus_Weather_get())
+ * are computed, when a time-blended grid is in use (see
+ * proteus_WeatherOptions.blendInterval).
+ *
+ * Returns
+ * 	the time for which the time-blended grid was computed, or 0 if there is none
+ * 	(in which case current time queries use the actual current time)
+ */
+PROTEUS_API time_t proteus_Weather_getBlendTime(void);
+
 /**
  * Provides weather information at the given geographical position.
  *
@@ -94,6 +318,314 @@ PROTEUS_API int proteus_Weather_init(int sourceDataGrid, const char* f1Dir, cons
  */
 PROTEUS_API bool proteus_Weather_get(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly);
 
+/**
+ * Provides selected weather information at the given geographical position.
+ *
+ * Only the requested fields are interpolated and converted, so requesting
+ * fewer fields makes queries cheaper. In particular, the wind vector's angle
+ * is only computed if PROTEUS_WX_FIELD_WIND is requested. Since the gust speed
+ * is never reported lower than the wind speed, requesting only
+ * PROTEUS_WX_FIELD_WIND_GUST still interpolates the wind vector components.
+ *
+ * Requested fields are computed exactly as by proteus_Weather_get().
+ *
+ * Parameters
+ * 	pos [in]: the geographical position to be queried
+ * 	wx [out]: the weather data structure to be populated; fields which
+ * 	          weren't requested are left untouched
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_WX_FIELD_* values)
+ *
+ * Returns
+ * 	true, if weather data is available and valid at the provided position
+ * 	false, if weather data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Weather_getFields(const proteus_GeoPos* pos, proteus_Weather* wx, uint32_t fields);
+
+/**
+ * Provides selected weather information at the given geographical position,
+ * as with proteus_Weather_getFields(), but at the given time rather than at
+ * the current time.
+ *
+ * Times outside of the loaded forecast window are clamped to it, in the same
+ * way as for current time queries. Passing the same time to all queries made
+ * for a simulation tick makes their results consistent with each other, and
+ * avoids reading the clock for each query.
+ *
+ * Parameters
+ * 	pos [in]: the geographical position to be queried
+ * 	t [in]: the time to be queried
+ * 	wx [out]: the weather data structure to be populated; fields which
+ * 	          weren't requested are left untouched
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_WX_FIELD_* values)
+ *
+ * Returns
+ * 	true, if weather data is available and valid at the provided position
+ * 	false, if weather data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Weather_getAt(const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields);
+
+/**
+ * Provides weather information at each of the given geographical positions.
+ *
+ * This is equivalent to calling proteus_Weather_get() for each position, but
+ * is faster for large numbers of positions, as the interpolation is vectorized
+ * (using SSE2/AVX2 where available) across positions.
+ *
+ * All positions are evaluated against the same weather data and at the same
+ * point in time (that of the call). The interpolation performs the same
+ * operations in the same order as proteus_Weather_get(), so results are
+ * identical to those of proteus_Weather_get() made at the same time (i.e. the
+ * tolerance is zero). Separate calls to proteus_Weather_get() may still differ
+ * slightly if the clock advances between them, or if grids are updated.
+ *
+ * Parameters
+ * 	pos [in]: the geographical positions to be queried
+ * 	n [in]: the number of positions
+ * 	wx [out]: the weather data structures to be populated (one per position);
+ * 	          those for positions where weather data is not available are
+ * 	          left untouched
+ * 	valid [out]: if not NULL, set to whether weather data is available and
+ * 	             valid at each position
+ * 	windOnly [in]: whether to supply only wind data (see proteus_Weather_get())
+ *
+ * Returns
+ * 	the number of positions for which weather data was provided
+ */
+PROTEUS_API size_t proteus_Weather_getBatch(const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, bool windOnly);
+
+/**
+ * Provides selected weather information at each of the given geographical
+ * positions, as with proteus_Weather_getBatch(), but only for the requested
+ * fields (see proteus_Weather_getFields()).
+ *
+ * Parameters
+ * 	pos [in]: the geographical positions to be queried
+ * 	n [in]: the number of positions
+ * 	wx [out]: the weather data structures to be populated (one per position);
+ * 	          fields which weren't requested are left untouched
+ * 	valid [out]: if not NULL, set to whether weather data is available and
+ * 	             valid at each position
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_WX_FIELD_* values)
+ *
+ * Returns
+ * 	the number of positions for which weather data was provided
+ */
+PROTEUS_API size_t proteus_Weather_getBatchFields(const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, uint32_t fields);
+
+/**
+ * Provides selected weather information at each of the given geographical
+ * positions, as with proteus_Weather_getBatchFields(), but at the given time
+ * rather than at the current time (see proteus_Weather_getAt()).
+ *
+ * Parameters
+ * 	pos [in]: the geographical positions to be queried
+ * 	n [in]: the number of positions
+ * 	t [in]: the time to be queried
+ * 	wx [out]: the weather data structures to be populated (one per position);
+ * 	          fields which weren't requested are left untouched
+ * 	valid [out]: if not NULL, set to whether weather data is available and
+ * 	             valid at each position
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_WX_FIELD_* values)
+ *
+ * Returns
+ * 	the number of positions for which weather data was provided
+ */
+PROTEUS_API size_t proteus_Weather_getBatchAt(const proteus_GeoPos* pos, size_t n, time_t t, proteus_Weather* wx, bool* valid, uint32_t fields);
+
+/**
+ * A weather query cache (see proteus_Weather_getCached())
+ */
+typedef struct proteus_WeatherCache proteus_WeatherCache;
+
+/**
+ * Weather query cache statistics
+ */
+typedef struct
+{
+	uint64_t hits; // Queries which reused the cached grid cell
+	uint64_t misses; // Queries which had to load a different grid cell
+} proteus_WeatherCacheStats;
+
+/**
+ * Creates a weather query cache.
+ *
+ * A cache must only be used by one thread at a time, and is typically kept per
+ * worker thread, or per object whose position is repeatedly queried (such as a
+ * moving boat).
+ *
+ * Returns
+ * 	the new cache, or NULL on failure
+ */
+PROTEUS_API proteus_WeatherCache* proteus_Weather_createCache(void);
+
+/**
+ * Frees a weather query cache.
+ *
+ * Parameters
+ * 	cache [in]: the cache to be freed (may be NULL)
+ */
+PROTEUS_API void proteus_Weather_freeCache(proteus_WeatherCache* cache);
+
+/**
+ * Provides selected weather information at the given geographical position and
+ * time, as with proteus_Weather_getAt(), using the given cache.
+ *
+ * The cache holds the grid point values of the last grid cell queried through
+ * it, so consecutive queries within the same cell (and between the same
+ * forecast steps) don't need to load them again. Cached values are invalidated
+ * whenever the weather grids are updated. Results are identical to those of
+ * proteus_Weather_getAt().
+ *
+ * Parameters
+ * 	cache [in,out]: the cache to use
+ * 	pos [in]: the geographical position to be queried
+ * 	t [in]: the time to be queried
+ * 	wx [out]: the weather data structure to be populated; fields which
+ * 	          weren't requested are left untouched
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_WX_FIELD_* values)
+ *
+ * Returns
+ * 	true, if weather data is available and valid at the provided position
+ * 	false, if weather data is not available or not valid at the provided position
+ */
+PROTEUS_API bool proteus_Weather_getCached(proteus_WeatherCache* cache, const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields);
+
+/**
+ * Provides the statistics of a weather query cache, accumulated since it was created.
+ *
+ * Parameters
+ * 	cache [in]: the cache
+ * 	stats [out]: the statistics of the cache
+ */
+PROTEUS_API void proteus_Weather_getCacheStats(const proteus_WeatherCache* cache, proteus_WeatherCacheStats* stats);
+
+/**
+ * A segment of a route, along which weather is sampled (see
+ * proteus_Weather_sampleSegment())
+ */
+typedef struct
+{
+	proteus_GeoPos start;
+	proteus_GeoPos end;
+
+	bool greatCircle; // Follow the great circle from start to end (which must not be antipodal), rather than
+	                  // a track along which longitude and latitude change at constant rates (taking the
+	                  // shorter way around)
+
+	time_t startTime; // Time at the start of the segment
+	double speed; // Speed along the segment, in metres/second, setting the time at which each sample is
+	              // reached (or zero, for all samples at the start time)
+} proteus_WeatherSegment;
+
+/**
+ * Provides selected weather information at evenly spaced positions along a
+ * segment, from its start to its end, each at the time it is reached.
+ *
+ * The segment is walked through the weather grid cells, and consecutive samples
+ * within the same cell (and between the same forecast steps) reuse the grid
+ * point values loaded for the first of them, so this is much cheaper than
+ * querying each position separately when samples are more closely spaced than
+ * grid points. Results are those of proteus_Weather_getAt() at the same
+ * positions and times, except that sample times aren't rounded to whole
+ * seconds.
+ *
+ * Parameters
+ * 	seg [in]: the segment to be sampled
+ * 	n [in]: the number of samples (the first at the start and, if more than one,
+ * 	        the last at the end)
+ * 	pos [out]: if not NULL, set to the position of each sample
+ * 	wx [out]: the weather data structures to be populated (one per sample);
+ * 	          fields which weren't requested are left untouched
+ * 	valid [out]: if not NULL, set to whether weather data is available and
+ * 	             valid at each sample
+ * 	fields [in]: the fields to be provided (bitwise OR of PROTEUS_WX_FIELD_* values)
+ *
+ * Returns
+ * 	the number of samples for which weather data was provided, on success
+ * 	-3, if the segment or number of samples is invalid
+ */
+PROTEUS_API int proteus_Weather_sampleSegment(const proteus_WeatherSegment* seg, int n, proteus_GeoPos* pos, proteus_Weather* wx, bool* valid, uint32_t fields);
+
+/**
+ * Converts the CSV data for a forecast point into a binary snapshot file.
+ *
+ * The snapshot is versioned and checksummed, and is loaded by memory-mapping
+ * it instead of parsing CSV files. To be picked up, it must be placed in the
+ * forecast data directory under the name PROTEUS_WEATHER_SNAPSHOT_FILE_NAME.
+ * A snapshot is only valid for the source data grid it was written for, and
+ * for the grid layout of the library version that wrote it. Invalid snapshots
+ * are ignored in favour of the CSV files.
+ *
+ * This does not require proteus_Weather_init() to have been called.
+ *
+ * Parameters
+ * 	sourceDataGrid [in]: the source data grid resolution
+ * 	csvDir [in]: the path to the directory with the forecast point CSV data
+ * 	snapshotFile [in]: the path of the snapshot file to write
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+PROTEUS_API int proteus_Weather_writeSnapshot(int sourceDataGrid, const char* csvDir, const char* snapshotFile);
+
+
+/**
+ * A weather context, holding the forecast data of one source (and its
+ * configuration) independently of any other context.
+ *
+ * The proteus_Weather_*() functions above operate on the default context. Each
+ * of them which initializes, updates or queries forecast data has a
+ * proteus_WeatherCtx_*() counterpart below, which behaves the same but operates
+ * on the given context. Several contexts (e.g. of different source data grid
+ * resolutions, or forecast data directories) may be in use at once, sharing
+ * the library's static data and its scheduler and file watcher threads.
+ * Weather query caches may be used with any context.
+ */
+typedef struct proteus_WeatherCtx proteus_WeatherCtx;
+
+/**
+ * Creates a weather context, to be initialized with one of the
+ * proteus_WeatherCtx_init*() functions.
+ *
+ * Returns
+ * 	the new context, or NULL on failure
+ */
+PROTEUS_API proteus_WeatherCtx* proteus_WeatherCtx_create(void);
+
+/**
+ * Destroys a weather context, stopping its updates and freeing its forecast
+ * data. It must not be queried (by any thread) once this is called.
+ *
+ * Parameters
+ * 	ctx [in]: the context to be destroyed (may be NULL; the default context
+ * 	          is never destroyed)
+ */
+PROTEUS_API void proteus_WeatherCtx_destroy(proteus_WeatherCtx* ctx);
+
+/**
+ * Returns the default weather context (the one used by the proteus_Weather_*()
+ * functions).
+ */
+PROTEUS_API proteus_WeatherCtx* proteus_WeatherCtx_getDefault(void);
+
+PROTEUS_API int proteus_WeatherCtx_init(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* f1Dir, const char* f2Dir);
+PROTEUS_API int proteus_WeatherCtx_initWithOptions(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherOptions* opts);
+PROTEUS_API int proteus_WeatherCtx_initRegion(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherRegion* region, const proteus_WeatherOptions* opts);
+PROTEUS_API int proteus_WeatherCtx_initTimeline(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* const* dirs, const time_t* validTimes, int n, const proteus_WeatherOptions* opts);
+PROTEUS_API int proteus_WeatherCtx_addStep(proteus_WeatherCtx* ctx, const char* dir, time_t validTime);
+PROTEUS_API int proteus_WeatherCtx_evictSteps(proteus_WeatherCtx* ctx, time_t t);
+PROTEUS_API int proteus_WeatherCtx_getSteps(proteus_WeatherCtx* ctx, time_t* validTimes, int maxSteps);
+PROTEUS_API time_t proteus_WeatherCtx_getBlendTime(proteus_WeatherCtx* ctx);
+PROTEUS_API bool proteus_WeatherCtx_get(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly);
+PROTEUS_API bool proteus_WeatherCtx_getFields(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, proteus_Weather* wx, uint32_t fields);
+PROTEUS_API bool proteus_WeatherCtx_getAt(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields);
+PROTEUS_API size_t proteus_WeatherCtx_getBatch(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, bool windOnly);
+PROTEUS_API size_t proteus_WeatherCtx_getBatchFields(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, uint32_t fields);
+PROTEUS_API size_t proteus_WeatherCtx_getBatchAt(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, time_t t, proteus_Weather* wx, bool* valid, uint32_t fields);
+PROTEUS_API bool proteus_WeatherCtx_getCached(proteus_WeatherCtx* ctx, proteus_WeatherCache* cache, const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields);
+PROTEUS_API int proteus_WeatherCtx_sampleSegment(proteus_WeatherCtx* ctx, const proteus_WeatherSegment* seg, int n, proteus_GeoPos* pos, proteus_Weather* wx, bool* valid, uint32_t fields);
+
 
 #ifdef __cplusplus
 }
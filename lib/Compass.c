@@ -23,6 +23,7 @@
 
 #include "proteus/Compass.h"
 #include "ErrLog.h"
+#include "RowParser.h"
 
 #define ERRLOG_ID "proteus_Compass"
 
@@ -45,7 +46,6 @@ typedef struct
 static MagGridPoint* _magGrid = 0;
 
 static void initMagGrid(const char* magGridDataPath);
-static int readMagGridPoint(char* s, float* x, float* y, int* year, float* magDec);
 
 static void insertMagGridPoint(MagGridPoint* magGrid, float lon, float lat, int year, float magDec);
 
@@ -166,8 +166,6 @@ PROTEUS_API double proteus_Compass_magdec(const proteus_GeoPos* pos, time_t t)
 }
 
 
-#define MAG_GRID_PARSE_BUF_SIZE (256)
-
 static void initMagGrid(const char* magGridDataPath)
 {
 	MagGridPoint* magGrid = malloc(MAG_GRID_X * MAG_GRID_Y * sizeof(MagGridPoint));
@@ -179,29 +177,26 @@ static void initMagGrid(const char* magGridDataPath)
 
 	memset(magGrid, 0x00, MAG_GRID_X * MAG_GRID_Y * sizeof(MagGridPoint));
 
-	FILE* fp;
-	char buf[MAG_GRID_PARSE_BUF_SIZE];
-
-	float x, y, magDec;
-	int year;
+	RowReader rr;
+	float cols[4]; // y, x, year, magDec
+	int rc;
 
 
-	fp = fopen(magGridDataPath, "r");
-	if (fp == 0)
+	if (RowReader_open(&rr, magGridDataPath) != 0)
 	{
 		goto fail;
 	}
 
-	while (fgets(buf, MAG_GRID_PARSE_BUF_SIZE, fp) == buf)
+	while ((rc = RowReader_next(&rr, cols, 4)) == 1)
 	{
-		if (readMagGridPoint(buf, &x, &y, &year, &magDec) != 0)
-		{
-			goto fail;
-		}
+		insertMagGridPoint(magGrid, cols[1], cols[0], RowParser_toInt(cols[2]), cols[3]);
+	}
+	RowReader_close(&rr);
 
-		insertMagGridPoint(magGrid, x, y, year, magDec);
+	if (rc != 0)
+	{
+		goto fail;
 	}
-	fclose(fp);
 
 
 	_magGrid = magGrid;
@@ -214,38 +209,6 @@ fail:
 	free(magGrid);
 }
 
-static int readMagGridPoint(char* s, float* x, float* y, int* year, float* magDec)
-{
-	char* t;
-	char* w;
-
-	if ((w = strtok_r(s, ",", &t)) == 0)
-	{
-		return -1;
-	}
-	*y = strtof(w, 0);
-
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -2;
-	}
-	*x = strtof(w, 0);
-
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -3;
-	}
-	*year = strtol(w, 0, 10);
-
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -4;
-	}
-	*magDec = strtof(w, 0);
-
-	return 0;
-}
-
 static void insertMagGridPoint(MagGridPoint* magGrid, float lon, float lat, int year, float magDec)
 {
 	year = year - MAG_DATA_YEAR_START;
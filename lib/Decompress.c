@@ -14,7 +14,10 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <zlib.h>
 
 #include "Decompress.h"
@@ -23,6 +26,23 @@
 #define ERRLOG_ID "proteus_Decompress"
 
 
+#define DECOMPRESS_STREAM_BUF_SIZE (64 * 1024)
+
+
+struct DecompressStream
+{
+	int fd;
+	bool eof; // true once all input has been read
+	bool end; // true once the last member has been fully decompressed
+
+	z_stream zs;
+
+	unsigned char in[DECOMPRESS_STREAM_BUF_SIZE];
+};
+
+static int fillStream(DecompressStream* ds);
+
+
 int Decompress_inflate(uint8_t* out, size_t outlen, const char* in, size_t inlen)
 {
 	z_stream zs;
@@ -64,3 +84,119 @@ zend:
 done:
 	return rc;
 }
+
+bool Decompress_isGzip(int fd)
+{
+	unsigned char magic[2];
+	return (2 == pread(fd, magic, 2, 0) && magic[0] == 0x1f && magic[1] == 0x8b);
+}
+
+DecompressStream* Decompress_openStream(int fd)
+{
+	DecompressStream* ds = malloc(sizeof(DecompressStream));
+	if (!ds)
+	{
+		return 0;
+	}
+
+	ds->fd = fd;
+	ds->eof = false;
+	ds->end = false;
+
+	ds->zs.next_in = ds->in;
+	ds->zs.avail_in = 0;
+
+	ds->zs.zalloc = Z_NULL;
+	ds->zs.zfree = Z_NULL;
+	ds->zs.opaque = 0;
+
+	const int zrc = inflateInit2(&ds->zs, 16 + MAX_WBITS);
+	if (Z_OK != zrc)
+	{
+		ERRLOG1("Failed to inflate init! zlib rc=%d", zrc);
+		free(ds);
+		return 0;
+	}
+
+	return ds;
+}
+
+ssize_t Decompress_readStream(DecompressStream* ds, uint8_t* out, size_t outlen)
+{
+	ds->zs.next_out = out;
+	ds->zs.avail_out = outlen;
+
+	while (ds->zs.avail_out > 0 && !ds->end)
+	{
+		if (ds->zs.avail_in == 0 && !ds->eof && 0 != fillStream(ds))
+		{
+			return -1;
+		}
+
+		const int zrc = inflate(&ds->zs, Z_NO_FLUSH);
+
+		if (zrc == Z_STREAM_END)
+		{
+			// Another member may follow this one.
+			if (ds->zs.avail_in == 0 && !ds->eof && 0 != fillStream(ds))
+			{
+				return -1;
+			}
+
+			if (ds->zs.avail_in == 0)
+			{
+				ds->end = true;
+			}
+			else if (Z_OK != inflateReset(&ds->zs))
+			{
+				return -2;
+			}
+		}
+		else if (zrc == Z_BUF_ERROR && ds->zs.avail_in == 0 && ds->eof)
+		{
+			ERRLOG("Compressed data is truncated!");
+			return -2;
+		}
+		else if (zrc != Z_OK && zrc != Z_BUF_ERROR)
+		{
+			ERRLOG1("Failed to inflate! zlib rc=%d", zrc);
+			return -2;
+		}
+	}
+
+	return (outlen - ds->zs.avail_out);
+}
+
+void Decompress_closeStream(DecompressStream* ds)
+{
+	if (!ds)
+	{
+		return;
+	}
+
+	inflateEnd(&ds->zs);
+	free(ds);
+}
+
+
+static int fillStream(DecompressStream* ds)
+{
+	ssize_t n;
+
+	do
+	{
+		n = read(ds->fd, ds->in, DECOMPRESS_STREAM_BUF_SIZE);
+	}
+	while (n < 0 && errno == EINTR);
+
+	if (n < 0)
+	{
+		return -1;
+	}
+
+	ds->eof = (n == 0);
+	ds->zs.next_in = ds->in;
+	ds->zs.avail_in = n;
+
+	return 0;
+}
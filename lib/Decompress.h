@@ -17,6 +17,7 @@
 #ifndef _Decompress_h_
 #define _Decompress_h_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <unistd.h>
 
@@ -38,4 +39,53 @@
  */
 int Decompress_inflate(uint8_t* out, size_t outlen, const char* in, size_t inlen);
 
+/**
+ * A gzip decompression stream, reading compressed data from a file descriptor
+ * through a fixed size buffer (so neither the compressed nor the decompressed
+ * data is ever held in memory all at once).
+ */
+typedef struct DecompressStream DecompressStream;
+
+/**
+ * Checks whether a file holds gzip compressed data (by the magic number at
+ * its start), leaving the file offset unchanged.
+ *
+ * Returns
+ * 	true, if the file starts with the gzip magic number
+ * 	false, otherwise (including if it couldn't be read)
+ */
+bool Decompress_isGzip(int fd);
+
+/**
+ * Opens a decompression stream reading from a file descriptor (from its current
+ * offset). Concatenated gzip members are decompressed one after another, as
+ * with gunzip.
+ *
+ * The file descriptor remains owned by the caller.
+ *
+ * Returns
+ * 	the stream, on success
+ * 	zero, on failure
+ */
+DecompressStream* Decompress_openStream(int fd);
+
+/**
+ * Reads decompressed data from a stream.
+ *
+ * Parameters
+ * 	ds [in]: the stream
+ * 	out [out]: the buffer where the decompressed data will be stored
+ * 	outlen [in]: the size of the "out" buffer available for writing
+ *
+ * Returns
+ * 	the number of bytes read (only less than outlen at the end of the data)
+ * 	a negative value, on failure (read error or corrupt data)
+ */
+ssize_t Decompress_readStream(DecompressStream* ds, uint8_t* out, size_t outlen);
+
+/**
+ * Closes a stream opened by Decompress_openStream().
+ */
+void Decompress_closeStream(DecompressStream* ds);
+
 #endif // _Decompress_h_
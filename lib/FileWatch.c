@@ -0,0 +1,363 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+
+#include "FileWatch.h"
+#include "ErrLog.h"
+
+#define ERRLOG_ID "proteus_FileWatch"
+#define WATCHER_THREAD_NAME "proteus_Watch"
+
+
+// Plenty for the forecast data files and directories of several contexts of each module
+#define FILE_WATCH_MAX_WATCHES (64)
+
+#define FILE_WATCH_PATH_MAXLEN (4096)
+#define FILE_WATCH_NAME_MAXLEN (256)
+
+#define FILE_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+#define FILE_WATCH_HASH_PRIME (0x100000001b3ULL)
+#define FILE_WATCH_HASH_BUF_SIZE (64 * 1024)
+
+
+typedef struct
+{
+	int id;
+	int wd;
+	char name[FILE_WATCH_NAME_MAXLEN]; // empty if watching a whole directory
+	FileWatchFunc func;
+	void* arg;
+} FileWatch;
+
+static FileWatch _watches[FILE_WATCH_MAX_WATCHES];
+static int _watchCount = 0;
+static int _nextWatchId = 1;
+
+// The watch whose function is currently running (if any)
+static int _runningId = 0;
+
+static int _inotifyFd = -1;
+
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _doneCond = PTHREAD_COND_INITIALIZER; // signalled when a watch function finishes running
+
+static pthread_t _watcherThread;
+static void* watcherMain();
+
+
+static int startWatcher(void);
+static void runWatches(const struct inotify_event* ev);
+static bool isWdInUse(int wd);
+static uint64_t hashBytes(uint64_t hash, const unsigned char* buf, size_t len);
+
+
+int FileWatch_add(const char* path, bool dir, FileWatchFunc func, void* arg)
+{
+	char dirPath[FILE_WATCH_PATH_MAXLEN];
+	const char* name = "";
+
+	if (strlen(path) >= FILE_WATCH_PATH_MAXLEN)
+	{
+		return -3;
+	}
+
+	strcpy(dirPath, path);
+
+	if (!dir)
+	{
+		char* slash = strrchr(dirPath, '/');
+		if (!slash)
+		{
+			name = path;
+			strcpy(dirPath, ".");
+		}
+		else
+		{
+			name = path + (slash - dirPath) + 1;
+			slash[(slash == dirPath) ? 1 : 0] = '\0';
+		}
+
+		if (name[0] == '\0' || strlen(name) >= FILE_WATCH_NAME_MAXLEN)
+		{
+			return -3;
+		}
+	}
+
+	pthread_mutex_lock(&_lock);
+
+	if (_watchCount == FILE_WATCH_MAX_WATCHES)
+	{
+		pthread_mutex_unlock(&_lock);
+		ERRLOG1("Too many watches to watch %s!", path);
+		return -1;
+	}
+
+	if (_inotifyFd == -1 && 0 != startWatcher())
+	{
+		pthread_mutex_unlock(&_lock);
+		return -2;
+	}
+
+	// (Watching the same directory again just gets its existing watch descriptor.)
+	const int wd = inotify_add_watch(_inotifyFd, dirPath, FILE_WATCH_EVENTS);
+	if (wd < 0)
+	{
+		pthread_mutex_unlock(&_lock);
+		ERRLOG2("Failed to watch %s (errno=%d)!", dirPath, errno);
+		return -2;
+	}
+
+	FileWatch* w = _watches + _watchCount++;
+	w->id = _nextWatchId++;
+	w->wd = wd;
+	strcpy(w->name, name);
+	w->func = func;
+	w->arg = arg;
+
+	const int id = w->id;
+
+	pthread_mutex_unlock(&_lock);
+
+	ERRLOG1("Watching %s for changes.", path);
+
+	return id;
+}
+
+void FileWatch_remove(int id)
+{
+	if (id <= 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&_lock);
+
+	for (int i = 0; i < _watchCount; i++)
+	{
+		if (_watches[i].id == id)
+		{
+			const int wd = _watches[i].wd;
+
+			_watches[i] = _watches[--_watchCount];
+
+			if (!isWdInUse(wd))
+			{
+				inotify_rm_watch(_inotifyFd, wd);
+			}
+
+			break;
+		}
+	}
+
+	while (_runningId == id)
+	{
+		pthread_cond_wait(&_doneCond, &_lock);
+	}
+
+	pthread_mutex_unlock(&_lock);
+}
+
+int FileWatch_hashFile(const char* path, uint64_t* hash)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f)
+	{
+		return ((errno == ENOENT) ? -1 : -2);
+	}
+
+	unsigned char buf[FILE_WATCH_HASH_BUF_SIZE];
+	uint64_t h = *hash;
+	uint64_t len = 0;
+	size_t n;
+
+	while ((n = fread(buf, 1, FILE_WATCH_HASH_BUF_SIZE, f)) > 0)
+	{
+		h = hashBytes(h, buf, n);
+		len += n;
+	}
+
+	const bool failed = (0 != ferror(f));
+	fclose(f);
+
+	if (failed)
+	{
+		return -2;
+	}
+
+	// (So that contents split differently across files hash differently.)
+	*hash = hashBytes(h, (const unsigned char*) &len, sizeof(len));
+
+	return 0;
+}
+
+
+static void* watcherMain()
+{
+	// (Aligned for the events read into it.)
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	for (;;)
+	{
+		const ssize_t n = read(_inotifyFd, buf, sizeof(buf));
+		if (n <= 0)
+		{
+			if (n < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			ERRLOG1("watcherMain: read failed with errno=%d", errno);
+			break;
+		}
+
+		for (const char* p = buf; p < buf + n; )
+		{
+			const struct inotify_event* ev = (const struct inotify_event*) p;
+
+			if (ev->mask & IN_Q_OVERFLOW)
+			{
+				ERRLOG("watcherMain: Event queue overflowed, so some changes may have been missed!");
+			}
+			else if (ev->len > 0)
+			{
+				runWatches(ev);
+			}
+
+			p += sizeof(struct inotify_event) + ev->len;
+		}
+	}
+
+	return 0;
+}
+
+// With the lock held.
+static int startWatcher(void)
+{
+	if ((_inotifyFd = inotify_init1(IN_CLOEXEC)) < 0)
+	{
+		ERRLOG1("Failed to init inotify (errno=%d)!", errno);
+		return -1;
+	}
+
+	if (0 != pthread_create(&_watcherThread, 0, &watcherMain, 0))
+	{
+		ERRLOG("Failed to create watcher thread!");
+		close(_inotifyFd);
+		_inotifyFd = -1;
+		return -1;
+	}
+
+#if defined(_GNU_SOURCE) && defined(__GLIBC__)
+	if (0 != pthread_setname_np(_watcherThread, WATCHER_THREAD_NAME))
+	{
+		ERRLOG1("Couldn't set thread name to %s. Continuing anyway.", WATCHER_THREAD_NAME);
+	}
+#endif
+
+	return 0;
+}
+
+// Runs the watch functions of the watches matching an event, one at a time (but not with the lock held).
+static void runWatches(const struct inotify_event* ev)
+{
+	int ids[FILE_WATCH_MAX_WATCHES];
+	int count = 0;
+
+	pthread_mutex_lock(&_lock);
+
+	for (int i = 0; i < _watchCount; i++)
+	{
+		const FileWatch* w = _watches + i;
+		if (w->wd == ev->wd && (w->name[0] == '\0' || 0 == strcmp(w->name, ev->name)))
+		{
+			ids[count++] = w->id;
+		}
+	}
+
+	for (int k = 0; k < count; k++)
+	{
+		// Look the watch up again, as it may have been removed while running the previous one.
+		const FileWatch* w = 0;
+		for (int i = 0; i < _watchCount && !w; i++)
+		{
+			if (_watches[i].id == ids[k])
+			{
+				w = _watches + i;
+			}
+		}
+
+		if (!w)
+		{
+			continue;
+		}
+
+		const FileWatchFunc func = w->func;
+		void* arg = w->arg;
+
+		_runningId = ids[k];
+
+		pthread_mutex_unlock(&_lock);
+		func(arg, ev->name);
+		pthread_mutex_lock(&_lock);
+
+		_runningId = 0;
+		pthread_cond_broadcast(&_doneCond);
+	}
+
+	pthread_mutex_unlock(&_lock);
+}
+
+static bool isWdInUse(int wd)
+{
+	for (int i = 0; i < _watchCount; i++)
+	{
+		if (_watches[i].wd == wd)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// FNV-1a, but over 64-bit words (rather than bytes), with the remaining bytes folded in one at a time.
+static uint64_t hashBytes(uint64_t hash, const unsigned char* buf, size_t len)
+{
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+	{
+		uint64_t w;
+		memcpy(&w, buf + i, sizeof(uint64_t));
+
+		hash = (hash ^ w) * FILE_WATCH_HASH_PRIME;
+		hash ^= (hash >> 32);
+	}
+
+	for (; i < len; i++)
+	{
+		hash = (hash ^ buf[i]) * FILE_WATCH_HASH_PRIME;
+	}
+
+	return hash;
+}
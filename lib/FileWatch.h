@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FileWatch_h_
+#define _FileWatch_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Watches for files being written (closed after writing) or moved into
+ * directories, using inotify, on a single watcher thread (started along with
+ * the first watch).
+ *
+ * Watch functions run on the watcher thread, so they should only note the change
+ * (e.g. by scheduling a job), rather than act on it directly.
+ */
+
+// Seconds to wait after the last change to a set of files before acting on it,
+// so that a set of files being written one after another is only acted on once.
+#define FILE_WATCH_SETTLE_SECONDS (10)
+
+// Initial value of a hash of file contents (see FileWatch_hashFile())
+#define FILE_WATCH_HASH_INIT (0xcbf29ce484222325ULL)
+
+typedef void (*FileWatchFunc)(void* arg, const char* name);
+
+
+/**
+ * Adds a watch.
+ *
+ * Parameters
+ * 	path [in]: the path of the directory to watch, or of a single file to watch
+ * 	           (in which case its directory is watched, for that file only)
+ * 	dir [in]: true if path is that of a directory
+ * 	func [in]: the watch function, passed the name of each file changed
+ * 	arg [in]: the argument passed to the watch function
+ *
+ * Returns
+ * 	the watch ID (always positive), on success
+ * 	a negative value, on failure
+ */
+int FileWatch_add(const char* path, bool dir, FileWatchFunc func, void* arg);
+
+/**
+ * Removes a watch. If its watch function is running, waits for it to finish
+ * (so this must not be called from a watch function). Unknown (or zero) watch
+ * IDs are ignored.
+ */
+void FileWatch_remove(int id);
+
+/**
+ * Folds the contents of a file into a (non-cryptographic) 64-bit hash.
+ *
+ * Parameters
+ * 	path [in]: the path of the file
+ * 	hash [in/out]: the hash to fold the contents into (starting from
+ * 	              FILE_WATCH_HASH_INIT)
+ *
+ * Returns
+ * 	0, on success
+ * 	-1, if the file doesn't exist
+ * 	-2, if the file couldn't be read
+ */
+int FileWatch_hashFile(const char* path, uint64_t* hash);
+
+#endif // _FileWatch_h_
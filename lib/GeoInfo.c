@@ -27,9 +27,10 @@
 #include "proteus/GeoInfo.h"
 #include "Decompress.h"
 #include "ErrLog.h"
+#include "Scheduler.h"
 
 #define ERRLOG_ID "proteus_GeoInfo"
-#define GRID_PRUNER_THREAD_NAME "proteus_GeoInfo"
+#define GRID_PRUNER_JOB_NAME "proteus_GeoInfo grid pruner"
 
 
 #define SQ_DEG_GRID_SIZE (450 * 3600)
@@ -58,8 +59,8 @@ static int getLonLatIndex(int lon, int lat);
 static void loadSquareDegree(SquareDegree* sd, int ilon, int ilat);
 static bool sdGridIsWater(const proteus_GeoPos* pos, const uint8_t* grid);
 
-static pthread_t _gridPrunerThread;
-static void* gridPrunerMain();
+static int _gridPrunerJob = 0; // zero if not scheduled
+static time_t gridPrunerJob(void* arg, time_t deadline);
 
 
 PROTEUS_API int proteus_GeoInfo_init(const char* dataDir)
@@ -74,6 +75,10 @@ PROTEUS_API int proteus_GeoInfo_init(const char* dataDir)
 		return -3;
 	}
 
+	// (Waits for the pruner, if it's running.)
+	Scheduler_cancel(_gridPrunerJob);
+	_gridPrunerJob = 0;
+
 	_dataDir = strdup(dataDir);
 
 	_grids = malloc(NUM_GRIDS * sizeof(SquareDegree));
@@ -97,19 +102,13 @@ PROTEUS_API int proteus_GeoInfo_init(const char* dataDir)
 		}
 	}
 
-	if (0 != pthread_create(&_gridPrunerThread, 0, &gridPrunerMain, 0))
+	if ((_gridPrunerJob = Scheduler_add(Scheduler_now() + GRID_PRUNER_INTERVAL, &gridPrunerJob, 0, GRID_PRUNER_JOB_NAME)) < 0)
 	{
-		ERRLOG("Failed to create grid pruner thread!");
+		_gridPrunerJob = 0;
+		ERRLOG("Failed to schedule grid pruner!");
 		return -1;
 	}
 
-#if defined(_GNU_SOURCE) && defined(__GLIBC__)
-	if (0 != pthread_setname_np(_gridPrunerThread, GRID_PRUNER_THREAD_NAME))
-	{
-		ERRLOG1("Couldn't set thread name to %s. Continuing anyway.", GRID_PRUNER_THREAD_NAME);
-	}
-#endif
-
 	return 0;
 }
 
@@ -279,60 +278,58 @@ static bool sdGridIsWater(const proteus_GeoPos* pos, const uint8_t* grid)
 }
 
 
-static void* gridPrunerMain()
+static time_t gridPrunerJob(void* arg, time_t deadline)
 {
-	for (;;)
-	{
-		sleep(GRID_PRUNER_INTERVAL);
+	(void) arg;
+	(void) deadline;
 
-		ERRLOG("Grid pruner starting...");
+	ERRLOG("Grid pruner starting...");
 
-		unsigned int loadedCount = 0;
-		unsigned int griddedCount = 0;
-		unsigned int retainedCount = 0;
+	unsigned int loadedCount = 0;
+	unsigned int griddedCount = 0;
+	unsigned int retainedCount = 0;
 
-		const time_t curTime = time(0);
+	const time_t curTime = time(0);
 
-		for (int i = 0; i < NUM_GRIDS; i++)
+	for (int i = 0; i < NUM_GRIDS; i++)
+	{
+		SquareDegree* sd = _grids + i;
+		pthread_mutex_t* l = &sd->lock;
+		if (0 != pthread_mutex_lock(l))
 		{
-			SquareDegree* sd = _grids + i;
-			pthread_mutex_t* l = &sd->lock;
-			if (0 != pthread_mutex_lock(l))
-			{
-				ERRLOG("gridPrunerMain: Failed to lock mutex!");
-				break;
-			}
+			ERRLOG("gridPrunerJob: Failed to lock mutex!");
+			break;
+		}
+
+		if (sd->loaded)
+		{
+			loadedCount++;
 
-			if (sd->loaded)
+			if (sd->grid != 0)
 			{
-				loadedCount++;
+				griddedCount++;
 
-				if (sd->grid != 0)
+				if (sd->lastUsed < curTime - GRID_PRUNER_EXPIRY)
 				{
-					griddedCount++;
-
-					if (sd->lastUsed < curTime - GRID_PRUNER_EXPIRY)
-					{
-						free(sd->grid);
-						sd->grid = 0;
-						sd->loaded = false;
-					}
-					else
-					{
-						retainedCount++;
-					}
+					free(sd->grid);
+					sd->grid = 0;
+					sd->loaded = false;
+				}
+				else
+				{
+					retainedCount++;
 				}
-			}
-
-			if (0 != pthread_mutex_unlock(l))
-			{
-				ERRLOG("gridPrunerMain: Failed to unlock mutex!");
-				break;
 			}
 		}
 
-		ERRLOG3("Grid pruner done. loaded=%u, gridded=%u, retained=%u", loadedCount, griddedCount, retainedCount);
+		if (0 != pthread_mutex_unlock(l))
+		{
+			ERRLOG("gridPrunerJob: Failed to unlock mutex!");
+			break;
+		}
 	}
 
-	return 0;
+	ERRLOG3("Grid pruner done. loaded=%u, gridded=%u, retained=%u", loadedCount, griddedCount, retainedCount);
+
+	return Scheduler_now() + GRID_PRUNER_INTERVAL;
 }
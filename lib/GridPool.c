@@ -0,0 +1,190 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "GridPool.h"
+#include "ErrLog.h"
+
+#define ERRLOG_ID "proteus_GridPool"
+
+
+// Mappings of buffers of a huge page or more (or of any size, if MAP_HUGETLB is to be tried) are sized
+// in whole (2 MiB) huge pages, whether or not they end up backed by them, so that all of them may be unmapped alike.
+#define GRID_POOL_HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+#define GRID_POOL_PAGE_SIZE ((size_t) 4096)
+
+
+static void* mapBuffer(const GridPool* pool, bool hugeTlb);
+
+
+int GridPool_init(GridPool* pool, size_t bufSize, int spare, bool hugeTlb)
+{
+	memset(pool, 0, sizeof(GridPool));
+
+	if (bufSize == 0 || spare < 0)
+	{
+		return -3;
+	}
+
+	if (spare > 0 && !(pool->free = malloc(spare * sizeof(void*))))
+	{
+		return -4;
+	}
+
+	if (0 != pthread_mutex_init(&pool->lock, 0))
+	{
+		free(pool->free);
+		pool->free = 0;
+		return -4;
+	}
+
+	pool->bufSize = bufSize;
+	const size_t pageSize = ((hugeTlb || bufSize >= GRID_POOL_HUGE_PAGE_SIZE) ? GRID_POOL_HUGE_PAGE_SIZE : GRID_POOL_PAGE_SIZE);
+	pool->mapLen = (bufSize + pageSize - 1) & ~(pageSize - 1);
+	pool->hugeTlb = hugeTlb;
+	pool->maxFree = spare;
+
+	for (int i = 0; i < spare; i++)
+	{
+		void* buf = mapBuffer(pool, pool->hugeTlb);
+
+		if (!buf && pool->hugeTlb)
+		{
+			ERRLOG1("No huge pages available for %lu byte grid buffers, so using regular pages.", (unsigned long) pool->mapLen);
+			pool->hugeTlb = false;
+			buf = mapBuffer(pool, false);
+		}
+
+		if (!buf)
+		{
+			GridPool_destroy(pool);
+			return -4;
+		}
+
+		pool->free[pool->freeCount++] = buf;
+	}
+
+	return 0;
+}
+
+void GridPool_destroy(GridPool* pool)
+{
+	if (pool->bufSize == 0)
+	{
+		return;
+	}
+
+	for (int i = 0; i < pool->freeCount; i++)
+	{
+		munmap(pool->free[i], pool->mapLen);
+	}
+
+	free(pool->free);
+	pthread_mutex_destroy(&pool->lock);
+
+	memset(pool, 0, sizeof(GridPool));
+}
+
+void* GridPool_get(GridPool* pool)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	void* buf = ((pool->freeCount > 0) ? pool->free[--pool->freeCount] : 0);
+
+	pthread_mutex_unlock(&pool->lock);
+
+	if (!buf)
+	{
+		if (!(buf = mapBuffer(pool, pool->hugeTlb)) && pool->hugeTlb)
+		{
+			buf = mapBuffer(pool, false);
+		}
+
+		if (!buf)
+		{
+			ERRLOG1("Failed to map %lu byte grid buffer!", (unsigned long) pool->mapLen);
+		}
+	}
+
+	return buf;
+}
+
+void GridPool_put(GridPool* pool, void* buf)
+{
+	if (!buf)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+
+	if (pool->freeCount < pool->maxFree)
+	{
+		pool->free[pool->freeCount++] = buf;
+		buf = 0;
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	if (buf)
+	{
+		munmap(buf, pool->mapLen);
+	}
+}
+
+
+static void* mapBuffer(const GridPool* pool, bool hugeTlb)
+{
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+	if (hugeTlb)
+	{
+		flags |= MAP_HUGETLB;
+	}
+#else
+	if (hugeTlb)
+	{
+		return 0;
+	}
+#endif
+
+	char* buf = mmap(0, pool->mapLen, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (buf == MAP_FAILED)
+	{
+		return 0;
+	}
+
+#ifdef MADV_HUGEPAGE
+	if (!hugeTlb)
+	{
+		// Only a hint, so failure (e.g. with THP disabled) doesn't matter.
+		madvise(buf, pool->mapLen, MADV_HUGEPAGE);
+	}
+#endif
+
+	// Pre-fault (after the advice above, so that the pages faulted in can be huge ones).
+	for (size_t i = 0; i < pool->mapLen; i += GRID_POOL_PAGE_SIZE)
+	{
+		buf[i] = 0;
+	}
+
+	return buf;
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GridPool_h_
+#define _GridPool_h_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+
+/**
+ * A pool of equally sized grid buffers, which recycles the buffers of retired
+ * grids as the targets of the next loads, so that steady state forecast updates
+ * don't churn large allocations through the heap (or page fault on first touch).
+ *
+ * Buffers are mapped directly (not from the heap), already populated, and are
+ * page aligned. They are advised to use transparent huge pages, or are backed by
+ * explicit huge pages (MAP_HUGETLB) if requested and available.
+ */
+
+typedef struct
+{
+	pthread_mutex_t lock;
+
+	size_t bufSize; // zero if not initialized
+	size_t mapLen; // size of each mapping (bufSize, rounded up to whole pages)
+	bool hugeTlb; // true if new buffers are mapped with MAP_HUGETLB (if possible)
+
+	int maxFree; // number of free buffers kept for reuse (any more are unmapped)
+	int freeCount;
+	void** free;
+} GridPool;
+
+
+/**
+ * Initializes a grid buffer pool, and pre-faults its spare buffers.
+ *
+ * Parameters
+ * 	pool [out]: the pool to initialize
+ * 	bufSize [in]: the size of each buffer, in bytes
+ * 	spare [in]: the number of buffers mapped up front, which is also the number
+ * 	            of free buffers kept for reuse
+ * 	hugeTlb [in]: true to try MAP_HUGETLB mappings first (falling back to regular
+ * 	              mappings if no huge pages are available)
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+int GridPool_init(GridPool* pool, size_t bufSize, int spare, bool hugeTlb);
+
+/**
+ * Releases all free buffers of a pool. Buffers still in use must not be
+ * returned to the pool afterwards.
+ */
+void GridPool_destroy(GridPool* pool);
+
+/**
+ * Takes a buffer from a pool, mapping a new one if none are free.
+ *
+ * The contents of the buffer are undefined.
+ *
+ * Returns
+ * 	a buffer of the pool's size, or zero on failure
+ */
+void* GridPool_get(GridPool* pool);
+
+/**
+ * Returns a buffer (taken from the same pool) to a pool.
+ */
+void GridPool_put(GridPool* pool, void* buf);
+
+#endif // _GridPool_h_
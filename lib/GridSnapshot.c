@@ -0,0 +1,214 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "GridSnapshot.h"
+#include "ErrLog.h"
+
+#define ERRLOG_ID "proteus_GridSnapshot"
+
+
+#define GRID_SNAPSHOT_MAGIC "PROTSNAP"
+#define GRID_SNAPSHOT_BYTE_ORDER_MARK (0x01020304)
+
+#define GRID_SNAPSHOT_PATH_MAXLEN (4096)
+
+// Maximum length passed to a single crc32() call, since zlib takes the length as a uInt.
+#define GRID_SNAPSHOT_CRC_CHUNK ((size_t) 1 << 30)
+
+
+typedef struct
+{
+	char magic[8];
+	uint32_t byteOrderMark;
+	uint32_t headerSize;
+
+	GridSnapshotInfo info;
+
+	uint32_t payloadCrc;
+	uint64_t payloadLen;
+
+	uint32_t reserved[4];
+} GridSnapshotHeader;
+
+
+static uint32_t computeCrc(const void* data, size_t len);
+
+
+int GridSnapshot_write(const char* path, const GridSnapshotInfo* info, const void* payload, size_t payloadLen)
+{
+	char tmpPath[GRID_SNAPSHOT_PATH_MAXLEN];
+	if (snprintf(tmpPath, GRID_SNAPSHOT_PATH_MAXLEN, "%s.tmp", path) >= GRID_SNAPSHOT_PATH_MAXLEN)
+	{
+		return -3;
+	}
+
+	GridSnapshotHeader hdr;
+	memset(&hdr, 0, sizeof(hdr));
+
+	memcpy(hdr.magic, GRID_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+	hdr.byteOrderMark = GRID_SNAPSHOT_BYTE_ORDER_MARK;
+	hdr.headerSize = sizeof(GridSnapshotHeader);
+	hdr.info = *info;
+	hdr.payloadCrc = computeCrc(payload, payloadLen);
+	hdr.payloadLen = payloadLen;
+
+	FILE* fp = fopen(tmpPath, "wb");
+	if (fp == 0)
+	{
+		ERRLOG1("Failed to open %s for writing!", tmpPath);
+		return -1;
+	}
+
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+			fwrite(payload, 1, payloadLen, fp) != payloadLen ||
+			fflush(fp) != 0 ||
+			fsync(fileno(fp)) != 0)
+	{
+		ERRLOG1("Failed to write snapshot data to %s!", tmpPath);
+		fclose(fp);
+		unlink(tmpPath);
+		return -2;
+	}
+
+	fclose(fp);
+
+	if (rename(tmpPath, path) != 0)
+	{
+		ERRLOG2("Failed to rename %s to %s!", tmpPath, path);
+		unlink(tmpPath);
+		return -2;
+	}
+
+	return 0;
+}
+
+int GridSnapshot_map(GridSnapshot* snap, const char* path, const GridSnapshotInfo* expected)
+{
+	memset(snap, 0, sizeof(GridSnapshot));
+
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return ((errno == ENOENT) ? -1 : -2);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(GridSnapshotHeader))
+	{
+		ERRLOG1("Snapshot %s is too small!", path);
+		close(fd);
+		return -2;
+	}
+
+	const size_t mapLen = (size_t) st.st_size;
+	void* map = mmap(0, mapLen, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
+	{
+		ERRLOG1("Failed to mmap snapshot %s!", path);
+		return -2;
+	}
+
+	// The payload is consumed front to back, so have the kernel read ahead aggressively.
+	// (Advice values aren't flags, so each is given separately.)
+	if (madvise(map, mapLen, MADV_SEQUENTIAL) != 0)
+	{
+		ERRLOG2("madvise(MADV_SEQUENTIAL) failed for snapshot %s (errno=%d). Continuing anyway.", path, errno);
+	}
+
+	if (madvise(map, mapLen, MADV_WILLNEED) != 0)
+	{
+		ERRLOG2("madvise(MADV_WILLNEED) failed for snapshot %s (errno=%d). Continuing anyway.", path, errno);
+	}
+
+	const GridSnapshotHeader* hdr = (const GridSnapshotHeader*) map;
+
+	if (memcmp(hdr->magic, GRID_SNAPSHOT_MAGIC, sizeof(hdr->magic)) != 0 ||
+			hdr->byteOrderMark != GRID_SNAPSHOT_BYTE_ORDER_MARK ||
+			hdr->headerSize != sizeof(GridSnapshotHeader))
+	{
+		ERRLOG1("Snapshot %s has an unrecognized header!", path);
+		goto fail;
+	}
+
+	if (memcmp(&hdr->info, expected, sizeof(GridSnapshotInfo)) != 0)
+	{
+		ERRLOG5("Snapshot %s doesn't match the expected grid (kind=%u, version=%u, grid=%ux%u).",
+				path, hdr->info.kind, hdr->info.version, hdr->info.gridX, hdr->info.gridY);
+		goto fail;
+	}
+
+	if (hdr->payloadLen != mapLen - sizeof(GridSnapshotHeader))
+	{
+		ERRLOG1("Snapshot %s has an unexpected payload length!", path);
+		goto fail;
+	}
+
+	const void* payload = (const uint8_t*) map + sizeof(GridSnapshotHeader);
+	if (computeCrc(payload, hdr->payloadLen) != hdr->payloadCrc)
+	{
+		ERRLOG1("Snapshot %s failed checksum validation!", path);
+		goto fail;
+	}
+
+	snap->map = map;
+	snap->mapLen = mapLen;
+	snap->payload = payload;
+	snap->payloadLen = hdr->payloadLen;
+
+	return 0;
+
+fail:
+	munmap(map, mapLen);
+	return -2;
+}
+
+void GridSnapshot_unmap(GridSnapshot* snap)
+{
+	if (snap->map)
+	{
+		munmap(snap->map, snap->mapLen);
+	}
+
+	memset(snap, 0, sizeof(GridSnapshot));
+}
+
+
+static uint32_t computeCrc(const void* data, size_t len)
+{
+	const uint8_t* p = (const uint8_t*) data;
+	uLong crc = crc32(0L, Z_NULL, 0);
+
+	while (len > 0)
+	{
+		const size_t n = (len > GRID_SNAPSHOT_CRC_CHUNK) ? GRID_SNAPSHOT_CRC_CHUNK : len;
+		crc = crc32(crc, p, (uInt) n);
+
+		p += n;
+		len -= n;
+	}
+
+	return (uint32_t) crc;
+}
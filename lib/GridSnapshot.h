@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GridSnapshot_h_
+#define _GridSnapshot_h_
+
+#include <stdint.h>
+#include <unistd.h>
+
+
+/**
+ * A grid snapshot file is a fixed-size header followed by a raw payload, which
+ * holds grid data exactly as laid out in memory by the owning module.
+ *
+ * Snapshots are written in native byte order. The header carries a byte order
+ * mark, so a snapshot from a foreign-endian host is rejected rather than misread.
+ */
+
+#define GRID_SNAPSHOT_KIND_WEATHER (1)
+
+
+typedef struct
+{
+	uint32_t kind; // GRID_SNAPSHOT_KIND_*
+	uint32_t version; // Payload layout version, as defined by the owning module
+	uint32_t gridX;
+	uint32_t gridY;
+	uint32_t pointSize; // Size of one grid point record in the payload, in bytes
+	uint32_t tileShift; // Log2 of the side of the square tiles of grid points in the payload (zero if stored row by row)
+} GridSnapshotInfo;
+
+typedef struct
+{
+	void* map;
+	size_t mapLen;
+
+	const void* payload;
+	size_t payloadLen;
+} GridSnapshot;
+
+
+/**
+ * Writes a grid snapshot file.
+ *
+ * The file is written to a temporary path and renamed into place, so readers
+ * never observe a partially written snapshot.
+ *
+ * Parameters
+ * 	path [in]: the path of the snapshot file to write
+ * 	info [in]: the snapshot description to be stored in the header
+ * 	payload [in]: the grid data
+ * 	payloadLen [in]: the size of the grid data, in bytes
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+int GridSnapshot_write(const char* path, const GridSnapshotInfo* info, const void* payload, size_t payloadLen);
+
+/**
+ * Maps a grid snapshot file into memory and validates it.
+ *
+ * The header must match all fields of the expected snapshot description, and
+ * the payload checksum must match the one stored in the header.
+ *
+ * Parameters
+ * 	snap [out]: the mapped snapshot
+ * 	path [in]: the path of the snapshot file to map
+ * 	expected [in]: the expected snapshot description
+ *
+ * Returns
+ * 	0, on success
+ * 	-1, if the snapshot file does not exist
+ * 	any other value, on failure (invalid or corrupt snapshot)
+ */
+int GridSnapshot_map(GridSnapshot* snap, const char* path, const GridSnapshotInfo* expected);
+
+/**
+ * Unmaps a grid snapshot previously mapped by GridSnapshot_map().
+ */
+void GridSnapshot_unmap(GridSnapshot* snap);
+
+#endif // _GridSnapshot_h_
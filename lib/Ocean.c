@@ -29,9 +29,14 @@
 #include "ScalarConv_internal.h"
 #include "Constants.h"
 #include "ErrLog.h"
+#include "FileWatch.h"
+#include "GridPool.h"
+#include "RowParser.h"
+#include "Scheduler.h"
 
 #define ERRLOG_ID "proteus_Ocean"
-#define UPDATER_THREAD_NAME "proteus_Ocean"
+#define UPDATE_JOB_NAME "proteus_Ocean update"
+#define RELOAD_JOB_NAME "proteus_Ocean reload"
 
 
 // NOTE: This module currently makes some fixed assumptions about the grid dimensions
@@ -47,60 +52,365 @@
 #define OCEAN_DATA_PHASE_IN_SECONDS (11 * (60 * 60) + (58 * 60))
 
 
+#define OCEAN_POINT_COUNT (OCEAN_GRID_X * OCEAN_GRID_Y)
+#define OCEAN_CELL_COUNT (OCEAN_GRID_X * (OCEAN_GRID_Y - 1))
+#define OCEAN_CELL_CORNERS (4)
+
+// Number of 64-bit words of a bitmap of n points or cells
+#define OCEAN_BITMAP_WORDS(n) (((n) + 63) / 64)
+
+// Size of a grid stored as a struct per point (four floats and a validity flag, padded to 20 bytes), which grid sizes are logged against
+#define OCEAN_GRID_STRUCT_SIZE (((size_t) OCEAN_POINT_COUNT) * 20)
+
+// Fields of the ocean grids
+enum
+{
+	OCEAN_FIELD_CURRENT_U, // m/s
+	OCEAN_FIELD_CURRENT_V, // m/s
+	OCEAN_FIELD_SURFACE_TEMP, // deg C
+	OCEAN_FIELD_SALINITY,
+	OCEAN_FIELD_ICE, // percent
+	OCEAN_FIELD_COUNT
+};
+
+// Fields stored together for each point (all but ice, which has a plane of its own, or is computed from them if quantized)
+#define OCEAN_POINT_FIELDS (OCEAN_FIELD_ICE)
+
+typedef struct
+{
+	// Quantized (16-bit) storage: value = qOffset + (q * qStep), for q in [0, 65535]
+	// NOTE: Keep the error bounds documented for proteus_OceanOptions.quantize in sync.
+	double qOffset;
+	double qStep;
+} OceanFieldInfo;
+
+static const OceanFieldInfo OCEAN_FIELD_INFO[OCEAN_POINT_FIELDS] = {
+	{ -16.0, 1.0 / 2048.0 },
+	{ -16.0, 1.0 / 2048.0 },
+	{ -8.0, 1.0 / 1024.0 },
+	{ 0.0, 1.0 / 1024.0 }
+};
+
+#define OCEAN_QUANTIZED_MAX (65535)
+
+// Each plane of a grid starts on its own cache line.
+#define OCEAN_PLANE_ALIGNMENT (64)
+
+// Number of grid buffers of a context: both grids, and the one being loaded
+#define OCEAN_GRID_BUFFERS (3)
+
+/**
+ * An ocean grid, stored as the values at each grid point (row by row), and a bitmap
+ * of the points with data (water). Each point's current, surface temperature and
+ * salinity values are stored together, and its ice concentration in a plane of its
+ * own, so that ice only queries and scans read nothing else.
+ *
+ * Queries read the values at the corners of the cell containing a position (from
+ * point A at x,y to point D at x+1,y+1, with B at x+1,y and C at x,y+1, wrapping
+ * around in x). Cells are indexed the same way as their A corners. A bitmap marks
+ * the cells with any water corners at all, and another marks the coastal cells among
+ * them, whose land corners take the average of their water corners instead. Queries
+ * of coastal cells work these fills out from the corner values they read anyway (see
+ * getOceanCellFields()), with selects rather than a branch per corner, so no fills
+ * are stored. (Storing ready to interpolate corner values for every cell would spare
+ * queries the coastal bit and the fills, but would take several times the memory of
+ * the points themselves.)
+ *
+ * A quantized grid stores 16-bit values instead (see OceanFieldInfo), and no ice
+ * plane, as ice is computed from the quantized surface temperature and salinity of
+ * each corner instead. It takes about 40% of the space of a struct per point (four
+ * floats and a flag), where storing ice too would take over half.
+ *
+ * The planes and bitmaps follow the OceanGrid itself in its (page aligned) grid pool
+ * buffer, starting with the values and the bitmap of the points (the data of the
+ * points, which an update starts from).
+ */
+typedef struct
+{
+	bool quantized;
+	float* values; // OCEAN_POINT_FIELDS values per point, if not quantized
+	uint16_t* qvalues; // if quantized
+	float* ice; // one value per point, if not quantized (zero otherwise)
+	uint64_t* pointValid; // one bit per point, set for water
+	uint64_t* cellValid; // one bit per cell, set if any of its corners are water
+	uint64_t* cellCoastal; // one bit per cell, set if some (but not all) of its corners are water
+
+	int coastalCount;
+} OceanGrid;
+
+// Space for the OceanGrid at the start of its buffer (keeping its planes aligned)
+#define OCEAN_GRID_HEADER_SIZE ((sizeof(OceanGrid) + OCEAN_PLANE_ALIGNMENT - 1) & ~((size_t) OCEAN_PLANE_ALIGNMENT - 1))
+
+// Watch of a forecast data file of a context, and the job reloading its data once changed
+typedef struct
+{
+	proteus_OceanCtx* ctx;
+	int i; // 0 for the "f1" file, 1 for the "f2" file
+
+	int watch; // zero if not watching
+	int reloadJob; // zero if not scheduled
+} OceanFileWatch;
+
+/**
+ * An ocean context: the forecast data loaded from one pair of files, and everything used
+ * to load and update it.
+ */
+struct proteus_OceanCtx
+{
+	char* f1File;
+	char* f2File;
+
+	OceanGrid* grid0;
+	OceanGrid* grid1;
+	pthread_rwlock_t gridLock;
+	GridPool gridPool; // buffers for both grids, and the one being loaded
+	time_t gridPhaseTime;
+
+	// Whether the grids are quantized (see proteus_OceanOptions.quantize)
+	bool quantize;
+
+	// Number of threads parsing a forecast data file (see proteus_OceanOptions.ingestThreads)
+	int ingestThreads;
+
+	// Hashes of the data loaded into grids 0 and 1 (see FileWatch_hashFile()), or zero if not known
+	uint64_t gridHashes[2];
+
+	int updateJob; // zero if not scheduled
+
+	// Whether the forecast data files are watched for changes
+	bool watchFiles;
+
+	// Watches of the "f1" and "f2" forecast data files
+	OceanFileWatch watches[2];
+};
+
+// The context used by the global API (proteus_Ocean_*())
+static proteus_OceanCtx _defaultCtx = {
+	.gridLock = PTHREAD_RWLOCK_INITIALIZER,
+	.ingestThreads = 1,
+	.watches = { { .ctx = &_defaultCtx, .i = 0 }, { .ctx = &_defaultCtx, .i = 1 } }
+};
+
+
+// Number of particles advected together (in structure-of-arrays form) by proteus_Ocean_advect()
+#define OCEAN_ADVECT_BLOCK_SIZE (8)
+
+// Number of particles claimed at a time by each thread advecting particles
+#define OCEAN_ADVECT_CHUNK_SIZE (256)
+
+// Fewest particles per thread worth starting another thread for
+#define OCEAN_ADVECT_MIN_THREAD_PARTICLES (1024)
+
+#define OCEAN_ADVECT_MAX_THREADS (64)
+#define OCEAN_ADVECT_MAX_STAGES (4)
+
+/**
+ * An explicit Runge-Kutta method, in which each stage evaluates the slope at the start
+ * of the step, plus a[s] of the step along the slope of the previous stage (and a[s]
+ * of the step later), and the step is taken along the slopes of all stages, weighted
+ * by b[s].
+ */
+typedef struct
+{
+	int stages;
+	double a[OCEAN_ADVECT_MAX_STAGES];
+	double b[OCEAN_ADVECT_MAX_STAGES];
+} OceanAdvectMethod;
+
+static const OceanAdvectMethod OCEAN_ADVECT_RK2 = { 2, { 0.0, 0.5 }, { 0.0, 1.0 } };
+static const OceanAdvectMethod OCEAN_ADVECT_RK4 = { 4, { 0.0, 0.5, 0.5, 1.0 }, { 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 } };
+
+// The particles of a proteus_Ocean_advect() call, shared by the threads advecting them
 typedef struct
 {
-	float currentU; // m/s
-	float currentV; // m/s
-	float surfaceTemp; // deg C
-	float salinity;
+	const proteus_OceanCtx* ctx;
+	const OceanAdvectMethod* method;
+
+	proteus_GeoPos* pos;
+	bool* drifting;
+	int n;
+
+	double startTime;
+	double dt;
+	int steps;
+
+	pthread_mutex_t lock;
+	int nextParticle;
+	int driftingCount;
+} OceanAdvectJob;
+
 
-	bool valid;
-} OceanGridPoint;
+static void resetOcean(proteus_OceanCtx* ctx);
 
-static const char* _f1File = 0;
-static const char* _f2File = 0;
+static time_t oceanUpdateJob(void* arg, time_t deadline);
+static time_t getNextOceanUpdateTime(time_t t);
 
-static OceanGridPoint* _oceanGrid0 = 0;
-static OceanGridPoint* _oceanGrid1 = 0;
-static pthread_rwlock_t _oceanGridLock;
-static time_t _oceanGridPhaseTime = 0;
+static void oceanWatchFunc(void* arg, const char* name);
+static time_t oceanReloadJob(void* arg, time_t deadline);
 
-static pthread_t _oceanUpdaterThread;
-static void* oceanUpdaterMain();
 
+static void updateOceanGrid(proteus_OceanCtx* ctx, int grid, const char* oceanDataPath);
 
-static void updateOceanGrid(int grid, const char* oceanDataPath);
-static int readOceanPoint(char* s, float* x, float* y, float* temp, float* u, float* v, float* salinity);
+static void insertOceanRow(void* arg, const float* cols);
+static void insertOceanGridPoint(OceanGrid* oceanGrid, float lon, float lat, float u, float v, float temp, float salinity);
+static OceanGrid* allocOceanGrid(proteus_OceanCtx* ctx);
+static void freeOceanGrid(proteus_OceanCtx* ctx, OceanGrid* oceanGrid);
+static size_t getOceanGridSize(bool quantized);
+static size_t getOceanPointDataSize(bool quantized);
+static size_t getOceanPlaneSize(size_t size);
+static void setOceanGridCells(OceanGrid* oceanGrid);
+static void setOceanPointValue(OceanGrid* oceanGrid, int field, int i, float value);
+static inline void getOceanCellFields(const OceanGrid* oceanGrid, int cellIdx, int firstField, int fieldCount, float* buf);
+static inline double interpOceanField(const float* const* v, int field, double xFrac, double yFrac, double tFrac);
+static inline double interpOceanCell(const float* v, double xFrac, double yFrac);
+static inline bool isOceanCellValid(const OceanGrid* oceanGrid, int cellIdx);
+static inline bool isOceanBitSet(const uint64_t* bitmap, int i);
 
-static void insertOceanGridPoint(OceanGridPoint* oceanGrid, float lon, float lat, float u, float v, float temp, float salinity);
+static inline bool getOceanCell(double lon, double lat, int* cellIdx, double* xFrac, double* yFrac);
+static double getOceanTimeFrac(const proteus_OceanCtx* ctx, double t);
+
+static void* oceanAdvectWorkerMain(void* arg);
+static int advectOceanBlock(const OceanAdvectJob* job, int first, int lanes);
+static void getOceanDriftBlock(const OceanGrid* grid0, const OceanGrid* grid1, double tFrac, const double* lat, const double* lon, bool* ok, double* dLat, double* dLon);
+static double wrapOceanLon(double lon);
 
 static int getXYIndex(int x, int y);
 static bool validLonLat(double lon, double lat);
 
-static void computeOceanDataIce(proteus_OceanData* od);
+static float computeOceanIce(float surfaceTemp, float salinity);
+
 
+PROTEUS_API void proteus_Ocean_getDefaultOptions(proteus_OceanOptions* opts)
+{
+	memset(opts, 0, sizeof(proteus_OceanOptions));
+
+	opts->ingestThreads = 1;
+}
 
 PROTEUS_API int proteus_Ocean_init(const char* f1File, const char* f2File)
 {
-	if (!f1File || !f2File)
+	return proteus_OceanCtx_init(&_defaultCtx, f1File, f2File);
+}
+
+PROTEUS_API int proteus_Ocean_initWithOptions(const char* f1File, const char* f2File, const proteus_OceanOptions* opts)
+{
+	return proteus_OceanCtx_initWithOptions(&_defaultCtx, f1File, f2File, opts);
+}
+
+PROTEUS_API bool proteus_Ocean_get(const proteus_GeoPos* pos, proteus_OceanData* od)
+{
+	return proteus_OceanCtx_getFieldsAt(&_defaultCtx, pos, time(0), od, PROTEUS_OCEAN_FIELD_ALL);
+}
+
+PROTEUS_API bool proteus_Ocean_getAt(const proteus_GeoPos* pos, time_t t, proteus_OceanData* od)
+{
+	return proteus_OceanCtx_getFieldsAt(&_defaultCtx, pos, t, od, PROTEUS_OCEAN_FIELD_ALL);
+}
+
+PROTEUS_API bool proteus_Ocean_getFields(const proteus_GeoPos* pos, proteus_OceanData* od, uint32_t fields)
+{
+	return proteus_OceanCtx_getFieldsAt(&_defaultCtx, pos, time(0), od, fields);
+}
+
+PROTEUS_API bool proteus_Ocean_getFieldsAt(const proteus_GeoPos* pos, time_t t, proteus_OceanData* od, uint32_t fields)
+{
+	return proteus_OceanCtx_getFieldsAt(&_defaultCtx, pos, t, od, fields);
+}
+
+PROTEUS_API int proteus_Ocean_advect(proteus_GeoPos* pos, int n, time_t startTime, double dt, int steps, int method, int threads, bool* drifting)
+{
+	return proteus_OceanCtx_advect(&_defaultCtx, pos, n, startTime, dt, steps, method, threads, drifting);
+}
+
+PROTEUS_API void proteus_Ocean_getGridStats(proteus_OceanGridStats* stats)
+{
+	proteus_OceanCtx_getGridStats(&_defaultCtx, stats);
+}
+
+
+PROTEUS_API proteus_OceanCtx* proteus_OceanCtx_create(void)
+{
+	proteus_OceanCtx* ctx = calloc(1, sizeof(proteus_OceanCtx));
+	if (!ctx)
+	{
+		return 0;
+	}
+
+	if (0 != pthread_rwlock_init(&ctx->gridLock, 0))
+	{
+		ERRLOG("Failed to init rwlock!");
+		free(ctx);
+		return 0;
+	}
+
+	ctx->ingestThreads = 1;
+
+	for (int i = 0; i < 2; i++)
+	{
+		ctx->watches[i].ctx = ctx;
+		ctx->watches[i].i = i;
+	}
+
+	return ctx;
+}
+
+PROTEUS_API void proteus_OceanCtx_destroy(proteus_OceanCtx* ctx)
+{
+	if (!ctx || ctx == &_defaultCtx)
+	{
+		return;
+	}
+
+	resetOcean(ctx);
+
+	pthread_rwlock_destroy(&ctx->gridLock);
+	free(ctx);
+}
+
+PROTEUS_API proteus_OceanCtx* proteus_OceanCtx_getDefault(void)
+{
+	return &_defaultCtx;
+}
+
+PROTEUS_API int proteus_OceanCtx_init(proteus_OceanCtx* ctx, const char* f1File, const char* f2File)
+{
+	proteus_OceanOptions opts;
+	proteus_Ocean_getDefaultOptions(&opts);
+
+	return proteus_OceanCtx_initWithOptions(ctx, f1File, f2File, &opts);
+}
+
+PROTEUS_API int proteus_OceanCtx_initWithOptions(proteus_OceanCtx* ctx, const char* f1File, const char* f2File, const proteus_OceanOptions* opts)
+{
+	if (!ctx || !f1File || !f2File || !opts || opts->ingestThreads < 1)
 	{
 		return -3;
 	}
 
-	_f1File = strdup(f1File);
-	_f2File = strdup(f2File);
+	resetOcean(ctx);
+
+	int rc = 0;
+
+	ctx->watchFiles = opts->watchFiles;
+	ctx->quantize = opts->quantize;
+	ctx->ingestThreads = opts->ingestThreads;
+
+	ctx->f1File = strdup(f1File);
+	ctx->f2File = strdup(f2File);
 
-	if (0 != pthread_rwlock_init(&_oceanGridLock, 0))
+	if (0 != GridPool_init(&ctx->gridPool, getOceanGridSize(ctx->quantize), OCEAN_GRID_BUFFERS, false))
 	{
-		ERRLOG("Failed to init rwlock!");
-		return -4;
+		ERRLOG("Failed to init grid pool!");
+		rc = -4;
+		goto fail;
 	}
 
-	time_t curTime = time(0);
+	const time_t curTime = Scheduler_now();
 	struct tm tres;
 	if (&tres != gmtime_r(&curTime, &tres))
 	{
-		return -2;
+		rc = -2;
+		goto fail;
 	}
 
 	const int hour = tres.tm_hour;
@@ -110,568 +420,1041 @@ PROTEUS_API int proteus_Ocean_init(const char* f1File, const char* f2File)
 	{
 		// In this situation, it's expected that the "f2" data would be "older" than the "f1" data,
 		// so just init both grids to the same data for now.
-		updateOceanGrid(0, _f1File);
-		updateOceanGrid(1, _f1File);
+		updateOceanGrid(ctx, 0, ctx->f1File);
+		updateOceanGrid(ctx, 1, ctx->f1File);
 
 		// Actual phase time doesn't matter when both grids are identical.
-		_oceanGridPhaseTime = curTime;
+		ctx->gridPhaseTime = curTime;
 	}
 	else
 	{
-		updateOceanGrid(0, _f1File);
-		updateOceanGrid(1, _f2File);
+		updateOceanGrid(ctx, 0, ctx->f1File);
+		updateOceanGrid(ctx, 1, ctx->f2File);
 
 		// Next phase time at 0600Z + phase interval.
-		_oceanGridPhaseTime = curTime - (3600 * hour) - (60 * min) + (3600 * 6) + OCEAN_DATA_PHASE_IN_SECONDS;
+		ctx->gridPhaseTime = curTime - (3600 * hour) - (60 * min) + (3600 * 6) + OCEAN_DATA_PHASE_IN_SECONDS;
+	}
+
+	if (!ctx->grid0 || !ctx->grid1)
+	{
+		rc = -1;
+		goto fail;
 	}
 
-	ERRLOG2("Ocean grid phase time: %lu (%ld seconds from now).", _oceanGridPhaseTime, (_oceanGridPhaseTime - curTime));
+	ERRLOG2("Ocean grid phase time: %lu (%ld seconds from now).", ctx->gridPhaseTime, (ctx->gridPhaseTime - curTime));
 
-	if (0 != pthread_create(&_oceanUpdaterThread, 0, &oceanUpdaterMain, 0))
+	if ((ctx->updateJob = Scheduler_add(getNextOceanUpdateTime(curTime), &oceanUpdateJob, ctx, UPDATE_JOB_NAME)) < 0)
 	{
-		return -2;
+		ctx->updateJob = 0;
+		rc = -2;
+		goto fail;
 	}
 
-#if defined(_GNU_SOURCE) && defined(__GLIBC__)
-	if (0 != pthread_setname_np(_oceanUpdaterThread, UPDATER_THREAD_NAME))
+	// (Only one watch, if both forecast points use the same file.)
+	const int files = (!ctx->watchFiles ? 0 : ((0 == strcmp(ctx->f1File, ctx->f2File)) ? 1 : 2));
+
+	for (int i = 0; i < files; i++)
 	{
-		ERRLOG1("Couldn't set thread name to %s. Continuing anyway.", UPDATER_THREAD_NAME);
+		if ((ctx->watches[i].watch = FileWatch_add((i == 0) ? ctx->f1File : ctx->f2File, false, &oceanWatchFunc, &ctx->watches[i])) < 0)
+		{
+			ctx->watches[i].watch = 0;
+			ERRLOG("Failed to watch ocean data file! Ocean grids will only be updated at the scheduled times.");
+		}
 	}
-#endif
 
-	return ((_oceanGrid0 != 0 && _oceanGrid1 != 0) ? 0 : -1);
+	return 0;
+
+fail:
+	ERRLOG1("Init failed: rc=%d", rc);
+
+	resetOcean(ctx);
+	return rc;
 }
 
-PROTEUS_API bool proteus_Ocean_get(const proteus_GeoPos* pos, proteus_OceanData* od)
+PROTEUS_API bool proteus_OceanCtx_get(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, proteus_OceanData* od)
 {
-	if (!validLonLat(pos->lon, pos->lat))
-	{
-		return false;
-	}
+	return proteus_OceanCtx_getFieldsAt(ctx, pos, time(0), od, PROTEUS_OCEAN_FIELD_ALL);
+}
+
+PROTEUS_API bool proteus_OceanCtx_getAt(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_OceanData* od)
+{
+	return proteus_OceanCtx_getFieldsAt(ctx, pos, t, od, PROTEUS_OCEAN_FIELD_ALL);
+}
 
-	int ilon = ((int) floor(pos->lon * 2.5)) + OCEAN_GRID_OFFSET_X;
-	int ilat = ((int) floor(pos->lat * 2.5)) + OCEAN_GRID_OFFSET_Y;
+PROTEUS_API bool proteus_OceanCtx_getFields(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, proteus_OceanData* od, uint32_t fields)
+{
+	return proteus_OceanCtx_getFieldsAt(ctx, pos, time(0), od, fields);
+}
 
-	if (ilat < 0 || ilat >= (OCEAN_GRID_Y - 1))
+PROTEUS_API bool proteus_OceanCtx_getFieldsAt(proteus_OceanCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_OceanData* od, uint32_t fields)
+{
+	int cellIdx;
+	double xFrac;
+	double yFrac;
+
+	if (!getOceanCell(pos->lon, pos->lat, &cellIdx, &xFrac, &yFrac))
 	{
 		return false;
 	}
 
-	if (ilon < 0 || ilon > OCEAN_GRID_X)
+	bool ret = false;
+	if (0 != pthread_rwlock_rdlock(&ctx->gridLock))
 	{
+		ERRLOG("get: Failed to lock for read!");
 		return false;
 	}
 
-	if (ilon == OCEAN_GRID_X)
+	if (!ctx->grid0 || !ctx->grid1)
 	{
-		ilon = 0;
+		// (Not initialized.)
+		goto done;
 	}
 
-	bool ret = false;
-	if (0 != pthread_rwlock_rdlock(&_oceanGridLock))
+	const OceanGrid* grid0 = ctx->grid0;
+	const OceanGrid* grid1 = ctx->grid1;
+
+	if (!isOceanCellValid(grid0, cellIdx) || !isOceanCellValid(grid1, cellIdx))
 	{
-		ERRLOG("get: Failed to lock for read!");
-		return false;
+		// All land
+		goto done;
 	}
 
-	const OceanGridPoint* oceanGridPtA0 = _oceanGrid0 + getXYIndex(ilon, ilat);
-	const OceanGridPoint* oceanGridPtB0 = _oceanGrid0 + getXYIndex(ilon + 1, ilat);
-	const OceanGridPoint* oceanGridPtC0 = _oceanGrid0 + getXYIndex(ilon, ilat + 1);
-	const OceanGridPoint* oceanGridPtD0 = _oceanGrid0 + getXYIndex(ilon + 1, ilat + 1);
+	const double tFrac = getOceanTimeFrac(ctx, (double) t);
+
+
+	// Corner values of the cell in both grids, of the fields from the first one needed (ice, or all of them) to
+	// the last one needed (all but ice, or all of them)
+	const int firstField = ((fields & ~((uint32_t) PROTEUS_OCEAN_FIELD_ICE)) ? 0 : OCEAN_FIELD_ICE);
+	const int lastField = ((fields & PROTEUS_OCEAN_FIELD_ICE) ? OCEAN_FIELD_COUNT : OCEAN_POINT_FIELDS);
+	float cellBuf[2][OCEAN_FIELD_COUNT * OCEAN_CELL_CORNERS];
 
-	const OceanGridPoint* oceanGridPtA1 = _oceanGrid1 + getXYIndex(ilon, ilat);
-	const OceanGridPoint* oceanGridPtB1 = _oceanGrid1 + getXYIndex(ilon + 1, ilat);
-	const OceanGridPoint* oceanGridPtC1 = _oceanGrid1 + getXYIndex(ilon, ilat + 1);
-	const OceanGridPoint* oceanGridPtD1 = _oceanGrid1 + getXYIndex(ilon + 1, ilat + 1);
+	getOceanCellFields(grid0, cellIdx, firstField, lastField - firstField, cellBuf[0]);
+	getOceanCellFields(grid1, cellIdx, firstField, lastField - firstField, cellBuf[1]);
 
-	if (ilon == OCEAN_GRID_X - 1)
+	const float* v[2] = { cellBuf[0], cellBuf[1] };
+
+	if (fields & PROTEUS_OCEAN_FIELD_CURRENT)
 	{
-		oceanGridPtA0 = _oceanGrid0 + getXYIndex(ilon, ilat);
-		oceanGridPtB0 = _oceanGrid0 + getXYIndex(0, ilat);
-		oceanGridPtC0 = _oceanGrid0 + getXYIndex(ilon, ilat + 1);
-		oceanGridPtD0 = _oceanGrid0 + getXYIndex(0, ilat + 1);
+		const double currentU = interpOceanField(v, OCEAN_FIELD_CURRENT_U, xFrac, yFrac, tFrac);
+		const double currentV = interpOceanField(v, OCEAN_FIELD_CURRENT_V, xFrac, yFrac, tFrac);
+
+		if (fabs(currentV) < PROTEUS_EPSILON)
+		{
+			if (currentU < -PROTEUS_EPSILON)
+			{
+				od->current.angle = 270.0;
+			}
+			else if (currentU > PROTEUS_EPSILON)
+			{
+				od->current.angle = 90.0;
+			}
+			else
+			{
+				od->current.angle = 0.0;
+			}
+		}
+		else
+		{
+			od->current.angle = ScalarConv_rad2deg(atan(currentU / currentV));
+
+			if (currentV < 0.0)
+			{
+				od->current.angle += 180.0;
+			}
+			else if (currentU < 0.0)
+			{
+				od->current.angle += 360.0;
+			}
+		}
 
-		oceanGridPtA1 = _oceanGrid1 + getXYIndex(ilon, ilat);
-		oceanGridPtB1 = _oceanGrid1 + getXYIndex(0, ilat);
-		oceanGridPtC1 = _oceanGrid1 + getXYIndex(ilon, ilat + 1);
-		oceanGridPtD1 = _oceanGrid1 + getXYIndex(0, ilat + 1);
+		od->current.mag = sqrt((currentU * currentU) + (currentV * currentV));
 	}
 
+	if (fields & PROTEUS_OCEAN_FIELD_SURFACE_TEMP)
+	{
+		od->surfaceTemp = interpOceanField(v, OCEAN_FIELD_SURFACE_TEMP, xFrac, yFrac, tFrac);
+	}
 
-	uint8_t valid = 0;
+	if (fields & PROTEUS_OCEAN_FIELD_SALINITY)
+	{
+		od->salinity = interpOceanField(v, OCEAN_FIELD_SALINITY, xFrac, yFrac, tFrac);
+	}
 
-	if (oceanGridPtA0->valid)
+	if (fields & PROTEUS_OCEAN_FIELD_ICE)
 	{
-		valid |= 0x01;
+		// (At its offset from the first field gathered.)
+		od->ice = interpOceanField(v, OCEAN_FIELD_ICE - firstField, xFrac, yFrac, tFrac);
 	}
 
-	if (oceanGridPtB0->valid)
+
+	ret = true;
+
+done:
+	if (0 != pthread_rwlock_unlock(&ctx->gridLock))
 	{
-		valid |= 0x02;
+		ERRLOG("get: Failed to unlock rwlock!");
 	}
 
-	if (oceanGridPtC0->valid)
+	return ret;
+}
+
+PROTEUS_API int proteus_OceanCtx_advect(proteus_OceanCtx* ctx, proteus_GeoPos* pos, int n, time_t startTime, double dt, int steps, int method, int threads, bool* drifting)
+{
+	if (!ctx || !pos || n < 1 || !isfinite(dt) || steps < 0 || threads < 1)
 	{
-		valid |= 0x04;
+		return -3;
 	}
 
-	if (oceanGridPtD0->valid)
+	OceanAdvectJob job;
+
+	switch (method)
 	{
-		valid |= 0x08;
+		case PROTEUS_OCEAN_ADVECT_RK2:
+			job.method = &OCEAN_ADVECT_RK2;
+			break;
+		case PROTEUS_OCEAN_ADVECT_RK4:
+			job.method = &OCEAN_ADVECT_RK4;
+			break;
+		default:
+			return -3;
 	}
 
-	if (valid == 0)
+	job.ctx = ctx;
+	job.pos = pos;
+	job.drifting = drifting;
+	job.n = n;
+	job.startTime = (double) startTime;
+	job.dt = dt;
+	job.steps = steps;
+	job.nextParticle = 0;
+	job.driftingCount = 0;
+
+	if (0 != pthread_mutex_init(&job.lock, 0))
 	{
-		goto done;
+		ERRLOG("advect: Failed to init mutex!");
+		return -2;
 	}
 
-	int count = 0;
-	OceanGridPoint avgPt0;
+	// The read lock is held (on behalf of all the threads) until all particles are advected,
+	// so that they're all advected through the same grids.
+	if (0 != pthread_rwlock_rdlock(&ctx->gridLock))
+	{
+		ERRLOG("advect: Failed to lock for read!");
+		pthread_mutex_destroy(&job.lock);
+		return -2;
+	}
 
-	if (valid != 0x0f)
+	if (!ctx->grid0 || !ctx->grid1)
 	{
-		avgPt0.currentU = 0;
-		avgPt0.currentV = 0;
-		avgPt0.surfaceTemp = 0;
-		avgPt0.salinity = 0;
+		// (Not initialized.)
+		if (drifting)
+		{
+			memset(drifting, 0, n * sizeof(bool));
+		}
+	}
+	else
+	{
+		const int maxThreads = (n + OCEAN_ADVECT_MIN_THREAD_PARTICLES - 1) / OCEAN_ADVECT_MIN_THREAD_PARTICLES;
+		if (threads > maxThreads)
+		{
+			threads = maxThreads;
+		}
 
-		if ((valid & 0x01) == 0x01)
+		if (threads > OCEAN_ADVECT_MAX_THREADS)
 		{
-			avgPt0.currentU += oceanGridPtA0->currentU;
-			avgPt0.currentV += oceanGridPtA0->currentV;
-			avgPt0.surfaceTemp += oceanGridPtA0->surfaceTemp;
-			avgPt0.salinity += oceanGridPtA0->salinity;
-			count++;
+			threads = OCEAN_ADVECT_MAX_THREADS;
 		}
-		else
+
+		int started = 0;
+		pthread_t workers[OCEAN_ADVECT_MAX_THREADS];
+
+		for (; threads > 1 && started < threads; started++)
 		{
-			oceanGridPtA0 = &avgPt0;
+			if (0 != pthread_create(&workers[started], 0, &oceanAdvectWorkerMain, &job))
+			{
+				ERRLOG("advect: Failed to create worker thread!");
+				break;
+			}
 		}
 
-		if ((valid & 0x02) == 0x02)
+		if (started == 0)
 		{
-			avgPt0.currentU += oceanGridPtB0->currentU;
-			avgPt0.currentV += oceanGridPtB0->currentV;
-			avgPt0.surfaceTemp += oceanGridPtB0->surfaceTemp;
-			avgPt0.salinity += oceanGridPtB0->salinity;
-			count++;
+			// Few particles (or couldn't start any workers), so just do all the work on this thread.
+			oceanAdvectWorkerMain(&job);
 		}
-		else
+
+		for (int i = 0; i < started; i++)
 		{
-			oceanGridPtB0 = &avgPt0;
+			pthread_join(workers[i], 0);
 		}
+	}
+
+	if (0 != pthread_rwlock_unlock(&ctx->gridLock))
+	{
+		ERRLOG("advect: Failed to unlock rwlock!");
+	}
+
+	pthread_mutex_destroy(&job.lock);
+
+	return job.driftingCount;
+}
 
-		if ((valid & 0x04) == 0x04)
+PROTEUS_API void proteus_OceanCtx_getGridStats(proteus_OceanCtx* ctx, proteus_OceanGridStats* stats)
+{
+	memset(stats, 0, sizeof(proteus_OceanGridStats));
+
+	if (0 != pthread_rwlock_rdlock(&ctx->gridLock))
+	{
+		ERRLOG("getGridStats: Failed to lock for read!");
+		return;
+	}
+
+	if (ctx->grid0 && ctx->grid1)
+	{
+		stats->bytes = getOceanGridSize(ctx->grid0->quantized) + getOceanGridSize(ctx->grid1->quantized);
+		stats->coastalCells = ctx->grid1->coastalCount;
+	}
+
+	if (0 != pthread_rwlock_unlock(&ctx->gridLock))
+	{
+		ERRLOG("getGridStats: Failed to unlock rwlock!");
+	}
+}
+
+static void updateOceanGrid(proteus_OceanCtx* ctx, int grid, const char* oceanDataPath)
+{
+	if (grid == -1 && !ctx->grid1)
+	{
+		// (Only this function replaces grids, so the latest one can be checked without the lock.)
+		ERRLOG1("Ocean grids aren't initialized, so not updating from %s.", oceanDataPath);
+		return;
+	}
+
+	uint64_t contentHash = FILE_WATCH_HASH_INIT;
+	if (!ctx->watchFiles || 0 != FileWatch_hashFile(oceanDataPath, &contentHash))
+	{
+		contentHash = 0;
+	}
+
+	if (grid == -1 && contentHash != 0 && (contentHash == ctx->gridHashes[0] || contentHash == ctx->gridHashes[1]))
+	{
+		ERRLOG1("Ocean data in %s is unchanged, so not updating.", oceanDataPath);
+		return;
+	}
+
+	OceanGrid* oceanGrid = allocOceanGrid(ctx);
+	if (!oceanGrid)
+	{
+		ERRLOG("updateWxGrid: Alloc failed for oceanGrid!");
+		goto fail;
+	}
+
+	// (The data of the points comes first in a grid's buffer, see OceanGrid.)
+	char* pointData = ((char*) oceanGrid) + OCEAN_GRID_HEADER_SIZE;
+
+	if (grid == -1)
+	{
+		// Updating ocean data grids, so copy the latest grid's points to start with sane values (in case new values are unavailable for some reason).
+		// (Only this function replaces grids, so the latest one can be read without the lock.)
+		memcpy(pointData, ((const char*) ctx->grid1) + OCEAN_GRID_HEADER_SIZE, getOceanPointDataSize(ctx->quantize));
+	}
+	else
+	{
+		// Setting up ocean data grid for the first time, so initialize the grid to zeros.
+		memset(pointData, 0, getOceanPointDataSize(ctx->quantize));
+	}
+
+	// (Each row sets a grid point of its own, so rows may be parsed and inserted concurrently.)
+	if (RowReader_readAll(oceanDataPath, 6, ctx->ingestThreads, &insertOceanRow, oceanGrid) != 0)
+	{
+		goto fail;
+	}
+
+	setOceanGridCells(oceanGrid);
+
+	ERRLOG3("Ocean grid holds %lu bytes, with %d coastal cells (%lu bytes at a struct per point).",
+			(unsigned long) getOceanGridSize(oceanGrid->quantized), oceanGrid->coastalCount, (unsigned long) OCEAN_GRID_STRUCT_SIZE);
+
+
+	if (grid != -1)
+	{
+		if (grid == 0)
 		{
-			avgPt0.currentU += oceanGridPtC0->currentU;
-			avgPt0.currentV += oceanGridPtC0->currentV;
-			avgPt0.surfaceTemp += oceanGridPtC0->surfaceTemp;
-			avgPt0.salinity += oceanGridPtC0->salinity;
-			count++;
+			ctx->grid0 = oceanGrid;
 		}
 		else
 		{
-			oceanGridPtC0 = &avgPt0;
+			ctx->grid1 = oceanGrid;
 		}
 
-		if ((valid & 0x08) == 0x08)
+		ctx->gridHashes[grid] = contentHash;
+
+		ERRLOG2("Initialized ocean grid %d (from %s).", grid, oceanDataPath);
+	}
+	else
+	{
+		if (0 != pthread_rwlock_wrlock(&ctx->gridLock))
 		{
-			avgPt0.currentU += oceanGridPtD0->currentU;
-			avgPt0.currentV += oceanGridPtD0->currentV;
-			avgPt0.surfaceTemp += oceanGridPtD0->surfaceTemp;
-			avgPt0.salinity += oceanGridPtD0->salinity;
-			count++;
+			ERRLOG("updateOceanGrid: Failed to lock for write!");
+			goto fail;
 		}
-		else
+
+		// Update, so recycle grid 0 data, grid 0 gets grid 1 data, and grid 1 gets latest data.
+		freeOceanGrid(ctx, ctx->grid0);
+		ctx->grid0 = ctx->grid1;
+		ctx->grid1 = oceanGrid;
+
+		ctx->gridHashes[0] = ctx->gridHashes[1];
+		ctx->gridHashes[1] = contentHash;
+
+		ctx->gridPhaseTime = Scheduler_now() + OCEAN_DATA_PHASE_IN_SECONDS;
+
+		if (0 != pthread_rwlock_unlock(&ctx->gridLock))
 		{
-			oceanGridPtD0 = &avgPt0;
+			ERRLOG("updateOceanGrid: Failed to unlock rwlock!");
 		}
 
-		avgPt0.currentU /= count;
-		avgPt0.currentV /= count;
-		avgPt0.surfaceTemp /= count;
-		avgPt0.salinity /= count;
+		ERRLOG2("Updated ocean grids (latest from %s). Grid phase time: %lu", oceanDataPath, ctx->gridPhaseTime);
 	}
 
+	return;
+
+fail:
+	ERRLOG("Failed to update ocean grid!");
+	freeOceanGrid(ctx, oceanGrid);
+}
+
+static void insertOceanRow(void* arg, const float* cols)
+{
+	// x, y, temp, u, v, salinity
+	insertOceanGridPoint((OceanGrid*) arg, cols[0], cols[1], cols[3], cols[4], cols[2], cols[5]);
+}
 
-	valid = 0;
+static void insertOceanGridPoint(OceanGrid* oceanGrid, float lon, float lat, float u, float v, float temp, float salinity)
+{
+	if (
+			!isfinite(lon) ||
+			!isfinite(lat) ||
+			!isfinite(u) ||
+			!isfinite(v) ||
+			!isfinite(temp) ||
+			!isfinite(salinity))
+	{
+		return;
+	}
 
-	if (oceanGridPtA1->valid)
+	if (lon >= 180.0)
 	{
-		valid |= 0x01;
+		lon -= 360.0;
 	}
 
-	if (oceanGridPtB1->valid)
+	int ilon = ((int) roundf(lon * 2.5f)) + OCEAN_GRID_OFFSET_X;
+	int ilat = ((int) roundf(lat * 2.5f)) + OCEAN_GRID_OFFSET_Y;
+
+	if (ilat < 0 || ilat >= OCEAN_GRID_Y)
 	{
-		valid |= 0x02;
+		ERRLOG4("Failed to insert ocean grid point at %f,%f (%d,%d). Lat out of bounds.", lon, lat, ilon, ilat);
+		return;
 	}
 
-	if (oceanGridPtC1->valid)
+	if (ilon < 0 || ilon > OCEAN_GRID_X)
 	{
-		valid |= 0x04;
+		ERRLOG4("Failed to insert ocean grid point at %f,%f (%d,%d). Lon out of bounds.", lon, lat, ilon, ilat);
+		return;
 	}
 
-	if (oceanGridPtD1->valid)
+	if (ilon == OCEAN_GRID_X)
 	{
-		valid |= 0x08;
+		ilon = 0;
 	}
 
-	if (valid == 0)
+	const int i = getXYIndex(ilon, ilat);
+
+	setOceanPointValue(oceanGrid, OCEAN_FIELD_CURRENT_U, i, u);
+	setOceanPointValue(oceanGrid, OCEAN_FIELD_CURRENT_V, i, v);
+	setOceanPointValue(oceanGrid, OCEAN_FIELD_SURFACE_TEMP, i, temp);
+	setOceanPointValue(oceanGrid, OCEAN_FIELD_SALINITY, i, salinity);
+
+	if (!oceanGrid->quantized)
 	{
-		goto done;
+		setOceanPointValue(oceanGrid, OCEAN_FIELD_ICE, i, computeOceanIce(temp, salinity));
 	}
 
-	count = 0;
-	OceanGridPoint avgPt1;
+	// (Atomically, as other rows may be setting other bits of the same word concurrently.)
+	__atomic_fetch_or(oceanGrid->pointValid + (i / 64), ((uint64_t) 1) << (i % 64), __ATOMIC_RELAXED);
+}
+
+// Sets up the bitmaps of the cells of a grid from its points.
+static void setOceanGridCells(OceanGrid* oceanGrid)
+{
+	memset(oceanGrid->cellValid, 0, OCEAN_BITMAP_WORDS(OCEAN_CELL_COUNT) * sizeof(uint64_t));
+	memset(oceanGrid->cellCoastal, 0, OCEAN_BITMAP_WORDS(OCEAN_CELL_COUNT) * sizeof(uint64_t));
+
+	int count = 0;
 
-	if (valid != 0x0f)
+	for (int idx = 0; idx < OCEAN_CELL_COUNT; idx++)
 	{
-		avgPt1.currentU = 0;
-		avgPt1.currentV = 0;
-		avgPt1.surfaceTemp = 0;
-		avgPt1.salinity = 0;
+		const int x = idx % OCEAN_GRID_X;
+		const int b = ((x == OCEAN_GRID_X - 1) ? idx - x : idx + 1);
 
-		if ((valid & 0x01) == 0x01)
-		{
-			avgPt1.currentU += oceanGridPtA1->currentU;
-			avgPt1.currentV += oceanGridPtA1->currentV;
-			avgPt1.surfaceTemp += oceanGridPtA1->surfaceTemp;
-			avgPt1.salinity += oceanGridPtA1->salinity;
-			count++;
-		}
-		else
-		{
-			oceanGridPtA1 = &avgPt1;
-		}
+		const int waterCount =
+			isOceanBitSet(oceanGrid->pointValid, idx) +
+			isOceanBitSet(oceanGrid->pointValid, b) +
+			isOceanBitSet(oceanGrid->pointValid, idx + OCEAN_GRID_X) +
+			isOceanBitSet(oceanGrid->pointValid, b + OCEAN_GRID_X);
 
-		if ((valid & 0x02) == 0x02)
-		{
-			avgPt1.currentU += oceanGridPtB1->currentU;
-			avgPt1.currentV += oceanGridPtB1->currentV;
-			avgPt1.surfaceTemp += oceanGridPtB1->surfaceTemp;
-			avgPt1.salinity += oceanGridPtB1->salinity;
-			count++;
-		}
-		else
+		if (waterCount == 0)
 		{
-			oceanGridPtB1 = &avgPt1;
+			continue;
 		}
 
-		if ((valid & 0x04) == 0x04)
-		{
-			avgPt1.currentU += oceanGridPtC1->currentU;
-			avgPt1.currentV += oceanGridPtC1->currentV;
-			avgPt1.surfaceTemp += oceanGridPtC1->surfaceTemp;
-			avgPt1.salinity += oceanGridPtC1->salinity;
-			count++;
-		}
-		else
-		{
-			oceanGridPtC1 = &avgPt1;
-		}
+		const uint64_t bit = ((uint64_t) 1) << (idx % 64);
+
+		oceanGrid->cellValid[idx / 64] |= bit;
 
-		if ((valid & 0x08) == 0x08)
+		if (waterCount != OCEAN_CELL_CORNERS)
 		{
-			avgPt1.currentU += oceanGridPtD1->currentU;
-			avgPt1.currentV += oceanGridPtD1->currentV;
-			avgPt1.surfaceTemp += oceanGridPtD1->surfaceTemp;
-			avgPt1.salinity += oceanGridPtD1->salinity;
+			oceanGrid->cellCoastal[idx / 64] |= bit;
 			count++;
 		}
-		else
-		{
-			oceanGridPtD1 = &avgPt1;
-		}
-
-		avgPt1.currentU /= count;
-		avgPt1.currentV /= count;
-		avgPt1.surfaceTemp /= count;
-		avgPt1.salinity /= count;
 	}
 
+	oceanGrid->coastalCount = count;
+}
 
-	const double xFrac = (ilon == 0 && pos->lon == 180.0) ? 0.0 : (pos->lon * 2.5) - ((double) (ilon - OCEAN_GRID_OFFSET_X));
-	const double yFrac = (pos->lat * 2.5) - ((double) (ilat - OCEAN_GRID_OFFSET_Y));
-
-	const long tDiff = _oceanGridPhaseTime - time(0);
-	double tFrac = 1.0 - (((double) tDiff) / ((double) OCEAN_DATA_PHASE_IN_SECONDS));
-	if (tFrac < 0.0)
+// Takes a grid from a context's pool, and points it at its planes.
+static OceanGrid* allocOceanGrid(proteus_OceanCtx* ctx)
+{
+	char* buf = GridPool_get(&ctx->gridPool);
+	if (!buf)
 	{
-		tFrac = 0.0;
+		return 0;
 	}
-	else if (tFrac > 1.0)
+
+	OceanGrid* oceanGrid = (OceanGrid*) buf;
+	const bool quantized = ctx->quantize;
+	const size_t valueSize = (quantized ? sizeof(uint16_t) : sizeof(float));
+
+	char* plane = buf + OCEAN_GRID_HEADER_SIZE;
+
+	oceanGrid->quantized = quantized;
+	oceanGrid->values = (quantized ? 0 : (float*) plane);
+	oceanGrid->qvalues = (quantized ? (uint16_t*) plane : 0);
+	plane += getOceanPlaneSize(OCEAN_POINT_COUNT * OCEAN_POINT_FIELDS * valueSize);
+
+	oceanGrid->ice = (quantized ? 0 : (float*) plane);
+	plane += (quantized ? 0 : getOceanPlaneSize(OCEAN_POINT_COUNT * sizeof(float)));
+
+	oceanGrid->pointValid = (uint64_t*) plane;
+	plane += getOceanPlaneSize(OCEAN_BITMAP_WORDS(OCEAN_POINT_COUNT) * sizeof(uint64_t));
+
+	oceanGrid->cellValid = (uint64_t*) plane;
+	plane += getOceanPlaneSize(OCEAN_BITMAP_WORDS(OCEAN_CELL_COUNT) * sizeof(uint64_t));
+
+	oceanGrid->cellCoastal = (uint64_t*) plane;
+
+	oceanGrid->coastalCount = 0;
+
+	return oceanGrid;
+}
+
+// Returns a grid (if any) to a context's pool.
+static void freeOceanGrid(proteus_OceanCtx* ctx, OceanGrid* oceanGrid)
+{
+	if (!oceanGrid)
 	{
-		tFrac = 1.0;
+		return;
 	}
 
+	GridPool_put(&ctx->gridPool, oceanGrid);
+}
+
+// Size of a grid's buffer (see allocOceanGrid()), which is all that it holds
+static size_t getOceanGridSize(bool quantized)
+{
+	return OCEAN_GRID_HEADER_SIZE +
+		getOceanPointDataSize(quantized) +
+		(2 * getOceanPlaneSize(OCEAN_BITMAP_WORDS(OCEAN_CELL_COUNT) * sizeof(uint64_t)));
+}
 
-	const double currentU0_0 = (oceanGridPtA0->currentU * (1.0 - xFrac)) + (oceanGridPtB0->currentU * xFrac);
-	const double currentU1_0 = (oceanGridPtC0->currentU * (1.0 - xFrac)) + (oceanGridPtD0->currentU * xFrac);
-	const double currentV0_0 = (oceanGridPtA0->currentV * (1.0 - xFrac)) + (oceanGridPtB0->currentV * xFrac);
-	const double currentV1_0 = (oceanGridPtC0->currentV * (1.0 - xFrac)) + (oceanGridPtD0->currentV * xFrac);
+// Size of the data of a grid's points (their values and bitmap), at the start of its buffer after the OceanGrid
+static size_t getOceanPointDataSize(bool quantized)
+{
+	if (quantized)
+	{
+		return getOceanPlaneSize(OCEAN_POINT_COUNT * OCEAN_POINT_FIELDS * sizeof(uint16_t)) +
+			getOceanPlaneSize(OCEAN_BITMAP_WORDS(OCEAN_POINT_COUNT) * sizeof(uint64_t));
+	}
 
-	const double currentU_0 = (currentU0_0 * (1.0 - yFrac)) + (currentU1_0 * yFrac);
-	const double currentV_0 = (currentV0_0 * (1.0 - yFrac)) + (currentV1_0 * yFrac);
+	return getOceanPlaneSize(OCEAN_POINT_COUNT * OCEAN_POINT_FIELDS * sizeof(float)) +
+		getOceanPlaneSize(OCEAN_POINT_COUNT * sizeof(float)) +
+		getOceanPlaneSize(OCEAN_BITMAP_WORDS(OCEAN_POINT_COUNT) * sizeof(uint64_t));
+}
 
-	const double currentU0_1 = (oceanGridPtA1->currentU * (1.0 - xFrac)) + (oceanGridPtB1->currentU * xFrac);
-	const double currentU1_1 = (oceanGridPtC1->currentU * (1.0 - xFrac)) + (oceanGridPtD1->currentU * xFrac);
-	const double currentV0_1 = (oceanGridPtA1->currentV * (1.0 - xFrac)) + (oceanGridPtB1->currentV * xFrac);
-	const double currentV1_1 = (oceanGridPtC1->currentV * (1.0 - xFrac)) + (oceanGridPtD1->currentV * xFrac);
+// Rounds up plane sizes, so that each plane is aligned.
+static size_t getOceanPlaneSize(size_t size)
+{
+	return (size + OCEAN_PLANE_ALIGNMENT - 1) & ~((size_t) OCEAN_PLANE_ALIGNMENT - 1);
+}
 
-	const double currentU_1 = (currentU0_1 * (1.0 - yFrac)) + (currentU1_1 * yFrac);
-	const double currentV_1 = (currentV0_1 * (1.0 - yFrac)) + (currentV1_1 * yFrac);
+static void setOceanPointValue(OceanGrid* oceanGrid, int field, int i, float value)
+{
+	if (field == OCEAN_FIELD_ICE)
+	{
+		// (Only stored if not quantized.)
+		oceanGrid->ice[i] = value;
+		return;
+	}
 
-	const double currentU = (currentU_0 * (1.0 - tFrac)) + (currentU_1 * tFrac);
-	const double currentV = (currentV_0 * (1.0 - tFrac)) + (currentV_1 * tFrac);
+	const size_t n = (((size_t) i) * OCEAN_POINT_FIELDS) + field;
 
-	if (fabs(currentV) < PROTEUS_EPSILON)
+	if (oceanGrid->quantized)
 	{
-		if (currentU < -PROTEUS_EPSILON)
+		// Round to the nearest step, clamping to the range of the quantized values.
+		const double q = floor(((value - OCEAN_FIELD_INFO[field].qOffset) / OCEAN_FIELD_INFO[field].qStep) + 0.5);
+
+		if (!(q > 0.0))
 		{
-			od->current.angle = 270.0;
+			// (Also catches NaN.)
+			oceanGrid->qvalues[n] = 0;
 		}
-		else if (currentU > PROTEUS_EPSILON)
+		else if (q > OCEAN_QUANTIZED_MAX)
 		{
-			od->current.angle = 90.0;
+			oceanGrid->qvalues[n] = OCEAN_QUANTIZED_MAX;
 		}
 		else
 		{
-			od->current.angle = 0.0;
+			oceanGrid->qvalues[n] = (uint16_t) q;
 		}
 	}
 	else
 	{
-		od->current.angle = ScalarConv_rad2deg(atan(currentU / currentV));
+		oceanGrid->values[n] = value;
+	}
+}
+
+// Gets the corner values of consecutive fields of a (valid) cell, at OCEAN_CELL_CORNERS values per field (in
+// the order A, B, C, D). The land corners of a coastal cell take the average of its water corners' values, as
+// worked out here (with selects rather than a branch per corner) from the same values.
+//
+// Quantized values are dequantized in float arithmetic without rounding, as they (and the products of their
+// steps) are exactly representable as floats, given the ranges and steps of OceanFieldInfo. The ice of each
+// corner of a quantized grid is computed from its (dequantized) surface temperature and salinity.
+static inline void getOceanCellFields(const OceanGrid* oceanGrid, int cellIdx, int firstField, int fieldCount, float* buf)
+{
+	const int x = cellIdx % OCEAN_GRID_X;
+	const int b = ((x == OCEAN_GRID_X - 1) ? cellIdx - x : cellIdx + 1);
+	const int corners[OCEAN_CELL_CORNERS] = { cellIdx, b, cellIdx + OCEAN_GRID_X, b + OCEAN_GRID_X };
 
-		if (currentV < 0.0)
+	// (The fields but ice are stored together for each point, and ice in a plane of its own.)
+	const int valueCount = ((firstField + fieldCount > OCEAN_POINT_FIELDS) ? OCEAN_POINT_FIELDS : firstField + fieldCount) - firstField;
+	const bool withIce = (firstField + fieldCount > OCEAN_FIELD_ICE);
+	float* iceBuf = buf + ((OCEAN_FIELD_ICE - firstField) * OCEAN_CELL_CORNERS);
+
+	if (oceanGrid->quantized)
+	{
+		for (int k = 0; k < OCEAN_CELL_CORNERS; k++)
 		{
-			od->current.angle += 180.0;
+			const uint16_t* q = oceanGrid->qvalues + (((size_t) corners[k]) * OCEAN_POINT_FIELDS);
+
+			for (int f = 0; f < valueCount; f++)
+			{
+				buf[(f * OCEAN_CELL_CORNERS) + k] = ((float) OCEAN_FIELD_INFO[firstField + f].qOffset) +
+					(q[firstField + f] * ((float) OCEAN_FIELD_INFO[firstField + f].qStep));
+			}
+
+			if (withIce)
+			{
+				iceBuf[k] = computeOceanIce(
+						((float) OCEAN_FIELD_INFO[OCEAN_FIELD_SURFACE_TEMP].qOffset) +
+							(q[OCEAN_FIELD_SURFACE_TEMP] * ((float) OCEAN_FIELD_INFO[OCEAN_FIELD_SURFACE_TEMP].qStep)),
+						((float) OCEAN_FIELD_INFO[OCEAN_FIELD_SALINITY].qOffset) +
+							(q[OCEAN_FIELD_SALINITY] * ((float) OCEAN_FIELD_INFO[OCEAN_FIELD_SALINITY].qStep)));
+			}
 		}
-		else if (currentU < 0.0)
+	}
+	else
+	{
+		for (int k = 0; k < OCEAN_CELL_CORNERS; k++)
 		{
-			od->current.angle += 360.0;
+			const float* v = oceanGrid->values + (((size_t) corners[k]) * OCEAN_POINT_FIELDS) + firstField;
+
+			for (int f = 0; f < valueCount; f++)
+			{
+				buf[(f * OCEAN_CELL_CORNERS) + k] = v[f];
+			}
+
+			if (withIce)
+			{
+				iceBuf[k] = oceanGrid->ice[corners[k]];
+			}
 		}
 	}
 
-	od->current.mag = sqrt((currentU * currentU) + (currentV * currentV));
+	if (!isOceanBitSet(oceanGrid->cellCoastal, cellIdx))
+	{
+		return;
+	}
 
+	bool water[OCEAN_CELL_CORNERS];
+	int waterCount = 0;
 
-	const double temp0_0 = (oceanGridPtA0->surfaceTemp * (1.0 - xFrac)) + (oceanGridPtB0->surfaceTemp * xFrac);
-	const double temp1_0 = (oceanGridPtC0->surfaceTemp * (1.0 - xFrac)) + (oceanGridPtD0->surfaceTemp * xFrac);
-	const double temp_0 = (temp0_0 * (1.0 - yFrac)) + (temp1_0 * yFrac);
+	for (int k = 0; k < OCEAN_CELL_CORNERS; k++)
+	{
+		water[k] = isOceanBitSet(oceanGrid->pointValid, corners[k]);
+		waterCount += water[k];
+	}
 
-	const double temp0_1 = (oceanGridPtA1->surfaceTemp * (1.0 - xFrac)) + (oceanGridPtB1->surfaceTemp * xFrac);
-	const double temp1_1 = (oceanGridPtC1->surfaceTemp * (1.0 - xFrac)) + (oceanGridPtD1->surfaceTemp * xFrac);
-	const double temp_1 = (temp0_1 * (1.0 - yFrac)) + (temp1_1 * yFrac);
+	// (Summed in corner order, as the average has always been, so that results are unchanged.)
+	for (int f = 0; f < fieldCount; f++)
+	{
+		float* v = buf + (f * OCEAN_CELL_CORNERS);
+		float sum = 0.0f;
 
-	od->surfaceTemp = (temp_0 * (1.0 - tFrac)) + (temp_1 * tFrac);
+		for (int k = 0; k < OCEAN_CELL_CORNERS; k++)
+		{
+			sum += (water[k] ? v[k] : 0.0f);
+		}
 
+		const float fill = sum / waterCount;
 
-	const double salinity0_0 = (oceanGridPtA0->salinity * (1.0 - xFrac)) + (oceanGridPtB0->salinity * xFrac);
-	const double salinity1_0 = (oceanGridPtC0->salinity * (1.0 - xFrac)) + (oceanGridPtD0->salinity * xFrac);
-	const double salinity_0 = (salinity0_0 * (1.0 - yFrac)) + (salinity1_0 * yFrac);
+		for (int k = 0; k < OCEAN_CELL_CORNERS; k++)
+		{
+			v[k] = (water[k] ? v[k] : fill);
+		}
+	}
+}
 
-	const double salinity0_1 = (oceanGridPtA1->salinity * (1.0 - xFrac)) + (oceanGridPtB1->salinity * xFrac);
-	const double salinity1_1 = (oceanGridPtC1->salinity * (1.0 - xFrac)) + (oceanGridPtD1->salinity * xFrac);
-	const double salinity_1 = (salinity0_1 * (1.0 - yFrac)) + (salinity1_1 * yFrac);
+// Interpolates a field within a cell (given its corner values in both grids, at the field's offset), and then between the grids.
+static inline double interpOceanField(const float* const* v, int field, double xFrac, double yFrac, double tFrac)
+{
+	const double v_0 = interpOceanCell(v[0] + (field * OCEAN_CELL_CORNERS), xFrac, yFrac);
+	const double v_1 = interpOceanCell(v[1] + (field * OCEAN_CELL_CORNERS), xFrac, yFrac);
 
-	od->salinity = (salinity_0 * (1.0 - tFrac)) + (salinity_1 * tFrac);
+	return (v_0 * (1.0 - tFrac)) + (v_1 * tFrac);
+}
 
+// Bilinear interpolation between the corner values of a cell
+static inline double interpOceanCell(const float* v, double xFrac, double yFrac)
+{
+	const double v0 = (v[0] * (1.0 - xFrac)) + (v[1] * xFrac);
+	const double v1 = (v[2] * (1.0 - xFrac)) + (v[3] * xFrac);
 
-	computeOceanDataIce(od);
+	return (v0 * (1.0 - yFrac)) + (v1 * yFrac);
+}
 
+static inline bool isOceanCellValid(const OceanGrid* oceanGrid, int cellIdx)
+{
+	return isOceanBitSet(oceanGrid->cellValid, cellIdx);
+}
 
-	ret = true;
+static inline bool isOceanBitSet(const uint64_t* bitmap, int i)
+{
+	return (0 != (bitmap[i / 64] & (((uint64_t) 1) << (i % 64))));
+}
 
-done:
-	if (0 != pthread_rwlock_unlock(&_oceanGridLock))
+// Gets the cell containing a position (indexed the same way as its A corner), and the fractions of the way
+// across it (from its A corner) of the position.
+static inline bool getOceanCell(double lon, double lat, int* cellIdx, double* xFrac, double* yFrac)
+{
+	if (!validLonLat(lon, lat))
 	{
-		ERRLOG("get: Failed to unlock rwlock!");
+		return false;
 	}
 
-	return ret;
-}
+	int ilon = ((int) floor(lon * 2.5)) + OCEAN_GRID_OFFSET_X;
+	const int ilat = ((int) floor(lat * 2.5)) + OCEAN_GRID_OFFSET_Y;
 
-#define OCEAN_GRID_PARSE_BUF_SIZE (256)
-
-static void updateOceanGrid(int grid, const char* oceanDataPath)
-{
-	OceanGridPoint* oceanGrid = malloc(OCEAN_GRID_X * OCEAN_GRID_Y * sizeof(OceanGridPoint));
-	if (!oceanGrid)
+	if (ilat < 0 || ilat >= (OCEAN_GRID_Y - 1))
 	{
-		ERRLOG("updateWxGrid: Alloc failed for oceanGrid!");
-		goto fail;
+		return false;
 	}
 
-	if (grid == -1)
+	if (ilon < 0 || ilon > OCEAN_GRID_X)
 	{
-		// Updating ocean data grids, so copy previous grid to start with sane values (in case new values are unavailable for some reason).
-		memcpy(oceanGrid, _oceanGrid1, OCEAN_GRID_X * OCEAN_GRID_Y * sizeof(OceanGridPoint));
+		return false;
 	}
-	else
+
+	if (ilon == OCEAN_GRID_X)
 	{
-		// Setting up ocean data grid for the first time, so initialize the grid to zeros.
-		memset(oceanGrid, 0, OCEAN_GRID_X * OCEAN_GRID_Y * sizeof(OceanGridPoint));
+		ilon = 0;
 	}
 
-	FILE* fp;
-	char buf[OCEAN_GRID_PARSE_BUF_SIZE];
+	*cellIdx = getXYIndex(ilon, ilat);
+	*xFrac = (ilon == 0 && lon == 180.0) ? 0.0 : (lon * 2.5) - ((double) (ilon - OCEAN_GRID_OFFSET_X));
+	*yFrac = (lat * 2.5) - ((double) (ilat - OCEAN_GRID_OFFSET_Y));
 
-	float x, y;
-	float u, v, temp, salinity;
+	return true;
+}
 
+// Gets the fraction of the way from grid 0 to grid 1 of a point in time (clamped to the loaded forecast window).
+static double getOceanTimeFrac(const proteus_OceanCtx* ctx, double t)
+{
+	const double tFrac = 1.0 - ((((double) ctx->gridPhaseTime) - t) / ((double) OCEAN_DATA_PHASE_IN_SECONDS));
 
-	fp = fopen(oceanDataPath, "r");
-	if (fp == 0)
+	if (tFrac < 0.0)
 	{
-		goto fail;
+		return 0.0;
 	}
-
-	while (fgets(buf, OCEAN_GRID_PARSE_BUF_SIZE, fp) == buf)
+	else if (tFrac > 1.0)
 	{
-		if (readOceanPoint(buf, &x, &y, &temp, &u, &v, &salinity) != 0)
-		{
-			goto fail;
-		}
-
-		insertOceanGridPoint(oceanGrid, x, y, u, v, temp, salinity);
+		return 1.0;
 	}
-	fclose(fp);
 
+	return tFrac;
+}
+
+static void* oceanAdvectWorkerMain(void* arg)
+{
+	OceanAdvectJob* job = (OceanAdvectJob*) arg;
 
-	if (grid != -1)
+	int count = 0;
+
+	for (;;)
 	{
-		if (grid == 0)
-		{
-			_oceanGrid0 = oceanGrid;
-		}
-		else
+		pthread_mutex_lock(&job->lock);
+		const int first = job->nextParticle;
+		if (first < job->n)
 		{
-			_oceanGrid1 = oceanGrid;
+			job->nextParticle += ((job->n - first < OCEAN_ADVECT_CHUNK_SIZE) ? (job->n - first) : OCEAN_ADVECT_CHUNK_SIZE);
 		}
+		const int end = job->nextParticle;
+		pthread_mutex_unlock(&job->lock);
 
-		ERRLOG2("Initialized ocean grid %d (from %s).", grid, oceanDataPath);
-	}
-	else
-	{
-		if (0 != pthread_rwlock_wrlock(&_oceanGridLock))
+		if (first >= end)
 		{
-			ERRLOG("updateOceanGrid: Failed to lock for write!");
-			goto fail;
+			break;
 		}
 
-		// Update, so free grid 0 data, grid 0 gets grid 1 data, and grid 1 gets latest data.
-		free(_oceanGrid0);
-		_oceanGrid0 = _oceanGrid1;
-		_oceanGrid1 = oceanGrid;
-
-		_oceanGridPhaseTime = time(0) + OCEAN_DATA_PHASE_IN_SECONDS;
-
-		if (0 != pthread_rwlock_unlock(&_oceanGridLock))
+		for (int i = first; i < end; i += OCEAN_ADVECT_BLOCK_SIZE)
 		{
-			ERRLOG("updateOceanGrid: Failed to unlock rwlock!");
+			count += advectOceanBlock(job, i, ((end - i < OCEAN_ADVECT_BLOCK_SIZE) ? (end - i) : OCEAN_ADVECT_BLOCK_SIZE));
 		}
-
-		ERRLOG2("Updated ocean grids (latest from %s). Grid phase time: %lu", oceanDataPath, _oceanGridPhaseTime);
 	}
 
-	return;
+	pthread_mutex_lock(&job->lock);
+	job->driftingCount += count;
+	pthread_mutex_unlock(&job->lock);
 
-fail:
-	ERRLOG("Failed to update ocean grid!");
-	free(oceanGrid);
+	return 0;
 }
 
-static int readOceanPoint(char* s, float* x, float* y, float* temp, float* u, float* v, float* salinity)
+// Advects a block of (up to OCEAN_ADVECT_BLOCK_SIZE) particles through all steps, returning the number still drifting.
+static int advectOceanBlock(const OceanAdvectJob* job, int first, int lanes)
 {
-	char* t;
-	char* w;
+	const OceanGrid* grid0 = job->ctx->grid0;
+	const OceanGrid* grid1 = job->ctx->grid1;
+	const OceanAdvectMethod* method = job->method;
+	const double dt = job->dt;
 
-	if ((w = strtok_r(s, ",", &t)) == 0)
-	{
-		return -1;
-	}
-	*x = strtof(w, 0);
+	double lat[OCEAN_ADVECT_BLOCK_SIZE];
+	double lon[OCEAN_ADVECT_BLOCK_SIZE];
+	bool drifting[OCEAN_ADVECT_BLOCK_SIZE];
 
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -2;
-	}
-	*y = strtof(w, 0);
+	// Position at which each stage is evaluated, its slope (in degrees per second), and the weighted sum of the slopes of the step
+	double stageLat[OCEAN_ADVECT_BLOCK_SIZE];
+	double stageLon[OCEAN_ADVECT_BLOCK_SIZE];
+	double dLat[OCEAN_ADVECT_BLOCK_SIZE];
+	double dLon[OCEAN_ADVECT_BLOCK_SIZE];
+	double sumLat[OCEAN_ADVECT_BLOCK_SIZE];
+	double sumLon[OCEAN_ADVECT_BLOCK_SIZE];
 
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -3;
-	}
-	*temp = strtof(w, 0);
+	// Whether the current was available for every stage of the step so far
+	bool ok[OCEAN_ADVECT_BLOCK_SIZE];
 
-	if ((w = strtok_r(0, ",", &t)) == 0)
+	int driftingLanes = 0;
+
+	for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
 	{
-		return -4;
+		if (l < lanes)
+		{
+			const proteus_GeoPos* p = job->pos + first + l;
+			lat[l] = p->lat;
+			lon[l] = p->lon;
+			drifting[l] = ((!job->drifting || job->drifting[first + l]) && validLonLat(p->lon, p->lat));
+		}
+		else
+		{
+			// (Padding lanes, never drifting.)
+			lat[l] = 0.0;
+			lon[l] = 0.0;
+			drifting[l] = false;
+		}
+
+		dLat[l] = 0.0;
+		dLon[l] = 0.0;
+
+		driftingLanes += (drifting[l] ? 1 : 0);
 	}
-	*u = strtof(w, 0);
 
-	if ((w = strtok_r(0, ",", &t)) == 0)
+	for (int step = 0; step < job->steps && driftingLanes > 0; step++)
 	{
-		return -5;
+		const double t = job->startTime + (step * dt);
+
+		for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
+		{
+			ok[l] = drifting[l];
+			sumLat[l] = 0.0;
+			sumLon[l] = 0.0;
+		}
+
+		for (int s = 0; s < method->stages; s++)
+		{
+			const double a = method->a[s] * dt;
+			const double b = method->b[s];
+
+			for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
+			{
+				stageLat[l] = lat[l] + (a * dLat[l]);
+				stageLon[l] = wrapOceanLon(lon[l] + (a * dLon[l]));
+			}
+
+			getOceanDriftBlock(grid0, grid1, getOceanTimeFrac(job->ctx, t + a), stageLat, stageLon, ok, dLat, dLon);
+
+			for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
+			{
+				sumLat[l] += b * dLat[l];
+				sumLon[l] += b * dLon[l];
+			}
+		}
+
+		for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
+		{
+			if (!drifting[l])
+			{
+				continue;
+			}
+
+			const double newLat = lat[l] + (dt * sumLat[l]);
+			const double newLon = wrapOceanLon(lon[l] + (dt * sumLon[l]));
+
+			if (ok[l] && validLonLat(newLon, newLat))
+			{
+				lat[l] = newLat;
+				lon[l] = newLon;
+			}
+			else
+			{
+				drifting[l] = false;
+				driftingLanes--;
+			}
+		}
 	}
-	*v = strtof(w, 0);
 
-	if ((w = strtok_r(0, ",", &t)) == 0)
+	for (int l = 0; l < lanes; l++)
 	{
-		return -6;
+		job->pos[first + l].lat = lat[l];
+		job->pos[first + l].lon = lon[l];
+
+		if (job->drifting)
+		{
+			job->drifting[first + l] = drifting[l];
+		}
 	}
-	*salinity = strtof(w, 0);
 
-	return 0;
+	return driftingLanes;
 }
 
-static void insertOceanGridPoint(OceanGridPoint* oceanGrid, float lon, float lat, float u, float v, float temp, float salinity)
+/**
+ * Gets the slopes (in degrees of latitude and longitude per second) of the paths of a block of particles drifting
+ * with the surface current, at the given positions and point in time, clearing ok for those where the current isn't
+ * available (and giving them zero slopes). Currents are interpolated exactly as by proteus_Ocean_getAt().
+ *
+ * The corner values of each particle's cell are gathered first, so that the interpolation and conversion
+ * to degrees per second run across the block (and can be vectorized).
+ */
+static void getOceanDriftBlock(const OceanGrid* grid0, const OceanGrid* grid1, double tFrac, const double* lat, const double* lon, bool* ok, double* dLat, double* dLon)
 {
-	if (
-			!isfinite(lon) ||
-			!isfinite(lat) ||
-			!isfinite(u) ||
-			!isfinite(v) ||
-			!isfinite(temp) ||
-			!isfinite(salinity))
-	{
-		return;
-	}
+	float u[2 * OCEAN_CELL_CORNERS][OCEAN_ADVECT_BLOCK_SIZE];
+	float v[2 * OCEAN_CELL_CORNERS][OCEAN_ADVECT_BLOCK_SIZE];
+	double xFrac[OCEAN_ADVECT_BLOCK_SIZE];
+	double yFrac[OCEAN_ADVECT_BLOCK_SIZE];
+	double cosLat[OCEAN_ADVECT_BLOCK_SIZE];
 
-	if (lon >= 180.0)
+	for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
 	{
-		lon -= 360.0;
-	}
+		int cellIdx;
 
-	int ilon = ((int) roundf(lon * 2.5f)) + OCEAN_GRID_OFFSET_X;
-	int ilat = ((int) roundf(lat * 2.5f)) + OCEAN_GRID_OFFSET_Y;
+		if (ok[l] && getOceanCell(lon[l], lat[l], &cellIdx, xFrac + l, yFrac + l) &&
+				isOceanCellValid(grid0, cellIdx) && isOceanCellValid(grid1, cellIdx))
+		{
+			// (The current fields, U then V, come first.)
+			float cellBuf[2][2 * OCEAN_CELL_CORNERS];
+			getOceanCellFields(grid0, cellIdx, OCEAN_FIELD_CURRENT_U, 2, cellBuf[0]);
+			getOceanCellFields(grid1, cellIdx, OCEAN_FIELD_CURRENT_U, 2, cellBuf[1]);
+
+			for (int g = 0; g < 2; g++)
+			{
+				for (int k = 0; k < OCEAN_CELL_CORNERS; k++)
+				{
+					u[(g * OCEAN_CELL_CORNERS) + k][l] = cellBuf[g][k];
+					v[(g * OCEAN_CELL_CORNERS) + k][l] = cellBuf[g][OCEAN_CELL_CORNERS + k];
+				}
+			}
+
+			cosLat[l] = cos(ScalarConv_deg2rad(lat[l]));
+		}
+		else
+		{
+			// (No current, at the equator, for lanes without current.)
+			ok[l] = false;
+			xFrac[l] = 0.0;
+			yFrac[l] = 0.0;
+			cosLat[l] = 1.0;
+
+			for (int k = 0; k < 2 * OCEAN_CELL_CORNERS; k++)
+			{
+				u[k][l] = 0.0f;
+				v[k][l] = 0.0f;
+			}
+		}
+	}
 
-	if (ilat < 0 || ilat >= OCEAN_GRID_Y)
+	for (int l = 0; l < OCEAN_ADVECT_BLOCK_SIZE; l++)
 	{
-		ERRLOG4("Failed to insert ocean grid point at %f,%f (%d,%d). Lat out of bounds.", lon, lat, ilon, ilat);
-		return;
+		const double x = xFrac[l];
+		const double y = yFrac[l];
+
+		// (The same operations, in the same order, as interpOceanField().)
+		const double u_0 = (((u[0][l] * (1.0 - x)) + (u[1][l] * x)) * (1.0 - y)) + (((u[2][l] * (1.0 - x)) + (u[3][l] * x)) * y);
+		const double u_1 = (((u[4][l] * (1.0 - x)) + (u[5][l] * x)) * (1.0 - y)) + (((u[6][l] * (1.0 - x)) + (u[7][l] * x)) * y);
+		const double v_0 = (((v[0][l] * (1.0 - x)) + (v[1][l] * x)) * (1.0 - y)) + (((v[2][l] * (1.0 - x)) + (v[3][l] * x)) * y);
+		const double v_1 = (((v[4][l] * (1.0 - x)) + (v[5][l] * x)) * (1.0 - y)) + (((v[6][l] * (1.0 - x)) + (v[7][l] * x)) * y);
+
+		const double currentU = (u_0 * (1.0 - tFrac)) + (u_1 * tFrac);
+		const double currentV = (v_0 * (1.0 - tFrac)) + (v_1 * tFrac);
+
+		// WGS84 spheroid lengths, in metres, of degrees of latitude and longitude (as in proteus_ScalarConv_m2dlat()
+		// and proteus_ScalarConv_m2dlon()), with the cosines of multiples of the latitude derived from its cosine.
+		const double c = cosLat[l];
+		const double c2 = c * c;
+		const double cos2 = (2.0 * c2) - 1.0;
+		const double cos4 = (2.0 * cos2 * cos2) - 1.0;
+		const double cos6 = (2.0 * cos2 * cos4) - cos2;
+		const double cos3 = c * ((4.0 * c2) - 3.0);
+		const double cos5 = c * ((((16.0 * c2) - 20.0) * c2) + 5.0);
+
+		const double mPerDegLat = 111132.92 - (559.82 * cos2) + (1.175 * cos4) - (0.0023 * cos6);
+		const double mPerDegLon = (111412.84 * c) - (93.5 * cos3) + (0.118 * cos5);
+
+		dLat[l] = currentV / mPerDegLat;
+		dLon[l] = currentU / mPerDegLon;
 	}
+}
 
-	if (ilon < 0 || ilon > OCEAN_GRID_X)
+// Wraps a longitude (at most one turn) into the range of [-180, 180).
+static double wrapOceanLon(double lon)
+{
+	if (lon >= 180.0)
 	{
-		ERRLOG4("Failed to insert ocean grid point at %f,%f (%d,%d). Lon out of bounds.", lon, lat, ilon, ilat);
-		return;
+		return lon - 360.0;
 	}
-
-	if (ilon == OCEAN_GRID_X)
+	else if (lon < -180.0)
 	{
-		ilon = 0;
+		return lon + 360.0;
 	}
 
-	OceanGridPoint* p = oceanGrid + getXYIndex(ilon, ilat);
-
-	p->currentU = u;
-	p->currentV = v;
-	p->surfaceTemp = temp;
-	p->salinity = salinity;
-
-	p->valid = true;
+	return lon;
 }
 
 static int getXYIndex(int x, int y)
@@ -684,17 +1467,16 @@ static bool validLonLat(double lon, double lat)
 	return (lon >= -180.0 && lon <= 180.0 && lat >= -90.0 && lat <= 90.0);
 }
 
-static void computeOceanDataIce(proteus_OceanData* od)
+static float computeOceanIce(float surfaceTemp, float salinity)
 {
-	if (od->surfaceTemp > 0.0f)
+	if (surfaceTemp > 0.0f)
 	{
 		// Water will never be frozen above 0 degrees C with Earth's atmospheric pressures, so shortcut here.
-		od->ice = 0.0f;
-		return;
+		return 0.0f;
 	}
 
 	// Constants below determined somewhat empirically in order to provide a reasonable ice concentration estimation.
-	float ice = ((-7500.0f * od->surfaceTemp) / od->salinity) - 300.0f;
+	float ice = ((-7500.0f * surfaceTemp) / salinity) - 300.0f;
 	if (ice > 100.0f)
 	{
 		ice = 100.0f;
@@ -704,43 +1486,105 @@ static void computeOceanDataIce(proteus_OceanData* od)
 		ice = 0.0f;
 	}
 
-	od->ice = ice;
+	return ice;
 }
 
 
-static void* oceanUpdaterMain()
+static time_t oceanUpdateJob(void* arg, time_t deadline)
 {
-	bool update = false;
+	proteus_OceanCtx* ctx = (proteus_OceanCtx*) arg;
 
-	for (;;)
+	const int hour = (int) ((deadline % (24 * 3600)) / 3600);
+	const char* oceanDataPath = ((hour == 18) ? ctx->f1File : ctx->f2File);
+	updateOceanGrid(ctx, -1, oceanDataPath);
+
+	// (Skipping any updates missed, if running late.)
+	const time_t curTime = Scheduler_now();
+	return getNextOceanUpdateTime((curTime > deadline) ? curTime : deadline);
+}
+
+// Returns the first update time after t: once every twelve hours (at 18Z and 06Z).
+static time_t getNextOceanUpdateTime(time_t t)
+{
+	const time_t day = t - (t % (24 * 3600));
+
+	time_t next = day + (6 * 3600);
+	while (next <= t)
 	{
-		time_t curTime = time(0);
-		struct tm tres;
-		if (&tres != gmtime_r(&curTime, &tres))
-		{
-			ERRLOG("gmtime_r failed!");
-			sleep(5);
+		next += 12 * 3600;
+	}
 
-			continue;
-		}
+	return next;
+}
 
-		const int hour = tres.tm_hour;
+static void oceanWatchFunc(void* arg, const char* name)
+{
+	(void) name;
 
-		// Attempt to update once every twelve hours (at 18Z and 06Z).
-		if (hour == 17 || hour == 5)
-		{
-			update = true;
-		}
-		else if (update && (hour == 18 || hour == 6))
-		{
-			const char* oceanDataPath = ((hour == 18) ? _f1File : _f2File);
-			updateOceanGrid(-1, oceanDataPath);
-			update = false;
-		}
+	OceanFileWatch* w = (OceanFileWatch*) arg;
 
-		// TODO: Sleep until we need to update the grids. Polling with a short sleep here is lazy and causes pointless frequent wakeups.
-		sleep(60);
+	// Reload once the data settles, pushing back any reload already pending (in case the file is written again).
+	Scheduler_cancel(w->reloadJob);
+
+	if ((w->reloadJob = Scheduler_add(Scheduler_now() + FILE_WATCH_SETTLE_SECONDS, &oceanReloadJob, w, RELOAD_JOB_NAME)) < 0)
+	{
+		w->reloadJob = 0;
+		ERRLOG1("Failed to schedule reload of ocean data in %s!", ((w->i == 0) ? w->ctx->f1File : w->ctx->f2File));
 	}
+}
+
+static time_t oceanReloadJob(void* arg, time_t deadline)
+{
+	(void) deadline;
+
+	const OceanFileWatch* w = (const OceanFileWatch*) arg;
+	updateOceanGrid(w->ctx, -1, ((w->i == 0) ? w->ctx->f1File : w->ctx->f2File));
 
 	return 0;
 }
+
+static void resetOcean(proteus_OceanCtx* ctx)
+{
+	// (Waits for the watch functions and jobs, if they're running. Watches go first, as they schedule reload jobs.)
+	for (int i = 0; i < 2; i++)
+	{
+		FileWatch_remove(ctx->watches[i].watch);
+		Scheduler_cancel(ctx->watches[i].reloadJob);
+
+		ctx->watches[i].watch = 0;
+		ctx->watches[i].reloadJob = 0;
+	}
+
+	Scheduler_cancel(ctx->updateJob);
+	ctx->updateJob = 0;
+
+	if (0 != pthread_rwlock_wrlock(&ctx->gridLock))
+	{
+		ERRLOG("reset: Failed to lock for write!");
+		return;
+	}
+
+	freeOceanGrid(ctx, ctx->grid0);
+	freeOceanGrid(ctx, ctx->grid1);
+	ctx->grid0 = 0;
+	ctx->grid1 = 0;
+
+	if (0 != pthread_rwlock_unlock(&ctx->gridLock))
+	{
+		ERRLOG("reset: Failed to unlock rwlock!");
+	}
+
+	GridPool_destroy(&ctx->gridPool);
+
+	free(ctx->f1File);
+	free(ctx->f2File);
+	ctx->f1File = 0;
+	ctx->f2File = 0;
+
+	ctx->gridHashes[0] = 0;
+	ctx->gridHashes[1] = 0;
+	ctx->gridPhaseTime = 0;
+	ctx->watchFiles = false;
+	ctx->quantize = false;
+	ctx->ingestThreads = 1;
+}
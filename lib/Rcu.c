@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "Rcu.h"
+#include "ErrLog.h"
+
+#define ERRLOG_ID "proteus_Rcu"
+
+
+#define RCU_CACHE_LINE_SIZE (64)
+
+// How long a writer sleeps between checks of readers still in a critical section.
+#define RCU_SYNC_POLL_NSEC (50 * 1000)
+
+
+typedef struct RcuReader
+{
+	// Global epoch observed when the outermost critical section began, or 0 when quiescent.
+	uint64_t epoch;
+
+	int nesting;
+	bool inUse;
+
+	struct RcuReader* next;
+} RcuReader;
+
+// Each reader slot occupies its own cache line, so readers never share one.
+typedef union
+{
+	RcuReader r;
+	char pad[RCU_CACHE_LINE_SIZE];
+} RcuReaderSlot;
+
+
+// Starts at 1, so that an epoch of 0 always means "quiescent".
+static uint64_t _epoch = 1;
+
+static RcuReader* _readers = 0;
+static pthread_mutex_t _readersLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t _readerKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t _readerKey;
+
+static __thread RcuReader* _threadReader = 0;
+
+// Read-side critical sections of threads without a reader slot (if registering one failed) hold this instead,
+// so that writers still wait for them (see Rcu_synchronize()).
+static pthread_rwlock_t _fallbackLock = PTHREAD_RWLOCK_INITIALIZER;
+static __thread int _fallbackNesting = 0;
+
+
+static RcuReader* registerReader(void);
+static void createReaderKey(void);
+static void releaseReader(void* arg);
+
+
+void Rcu_readLock(void)
+{
+	RcuReader* r = _threadReader;
+	if (!r && (_fallbackNesting > 0 || !(r = registerReader())))
+	{
+		if (_fallbackNesting++ == 0)
+		{
+			// (Only fails if there are too many readers already, so just wait for some to finish.)
+			while (0 != pthread_rwlock_rdlock(&_fallbackLock))
+			{
+				const struct timespec ts = { .tv_sec = 0, .tv_nsec = RCU_SYNC_POLL_NSEC };
+				nanosleep(&ts, 0);
+			}
+		}
+
+		return;
+	}
+
+	if (r->nesting++ == 0)
+	{
+		__atomic_store_n(&r->epoch, __atomic_load_n(&_epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+		// Order the epoch store before any loads of RCU-protected pointers.
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+}
+
+void Rcu_readUnlock(void)
+{
+	if (_fallbackNesting > 0)
+	{
+		if (--_fallbackNesting == 0)
+		{
+			pthread_rwlock_unlock(&_fallbackLock);
+		}
+
+		return;
+	}
+
+	RcuReader* r = _threadReader;
+	if (!r)
+	{
+		return;
+	}
+
+	if (--r->nesting == 0)
+	{
+		__atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+	}
+}
+
+void Rcu_synchronize(void)
+{
+	// Order the caller's pointer publication before the reader slot checks below.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	const uint64_t epoch = __atomic_add_fetch(&_epoch, 1, __ATOMIC_SEQ_CST);
+
+	for (RcuReader* r = __atomic_load_n(&_readers, __ATOMIC_ACQUIRE); r; r = r->next)
+	{
+		for (;;)
+		{
+			const uint64_t e = __atomic_load_n(&r->epoch, __ATOMIC_ACQUIRE);
+			if (e == 0 || e >= epoch)
+			{
+				// Quiescent, or began its critical section after the pointer was published.
+				break;
+			}
+
+			const struct timespec ts = { .tv_sec = 0, .tv_nsec = RCU_SYNC_POLL_NSEC };
+			nanosleep(&ts, 0);
+		}
+	}
+
+	// Wait for any readers without a reader slot, too.
+	if (0 == pthread_rwlock_wrlock(&_fallbackLock))
+	{
+		pthread_rwlock_unlock(&_fallbackLock);
+	}
+	else
+	{
+		ERRLOG("Failed to lock fallback lock for write!");
+	}
+}
+
+
+static RcuReader* registerReader(void)
+{
+	pthread_once(&_readerKeyOnce, &createReaderKey);
+
+	pthread_mutex_lock(&_readersLock);
+
+	// Reuse the slot of a thread that has exited, if there is one.
+	RcuReader* r = _readers;
+	while (r && r->inUse)
+	{
+		r = r->next;
+	}
+
+	if (!r)
+	{
+		RcuReaderSlot* slot = aligned_alloc(RCU_CACHE_LINE_SIZE, sizeof(RcuReaderSlot));
+		if (!slot)
+		{
+			pthread_mutex_unlock(&_readersLock);
+			ERRLOG("Alloc failed for reader slot!");
+			return 0;
+		}
+
+		memset(slot, 0, sizeof(RcuReaderSlot));
+		r = &slot->r;
+
+		r->next = _readers;
+		__atomic_store_n(&_readers, r, __ATOMIC_RELEASE);
+	}
+
+	r->epoch = 0;
+	r->nesting = 0;
+	r->inUse = true;
+
+	pthread_mutex_unlock(&_readersLock);
+
+	pthread_setspecific(_readerKey, r);
+	_threadReader = r;
+
+	return r;
+}
+
+static void createReaderKey(void)
+{
+	if (0 != pthread_key_create(&_readerKey, &releaseReader))
+	{
+		ERRLOG("Failed to create reader thread key!");
+	}
+}
+
+static void releaseReader(void* arg)
+{
+	RcuReader* r = (RcuReader*) arg;
+
+	pthread_mutex_lock(&_readersLock);
+
+	__atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+	r->nesting = 0;
+	r->inUse = false;
+
+	pthread_mutex_unlock(&_readersLock);
+}
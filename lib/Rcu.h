@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _Rcu_h_
+#define _Rcu_h_
+
+/**
+ * Read-copy-update style publication of immutable data.
+ *
+ * Writers publish a new version of the data with an atomic pointer store, then
+ * call Rcu_synchronize() before freeing the version they replaced. Readers
+ * bracket their accesses with Rcu_readLock()/Rcu_readUnlock(), which only ever
+ * write to a per-thread slot on its own cache line, so readers don't contend
+ * with each other and are never blocked by writers.
+ *
+ * Read-side critical sections may be nested, and must not block for long, since
+ * writers wait for them to end.
+ *
+ * Should a thread fail to get a reader slot (i.e. on allocation failure), its
+ * read-side critical sections hold a shared lock instead (which writers wait
+ * for), so it's never left unprotected, though it may then be blocked by writers.
+ */
+
+// Loads an RCU-protected pointer (inside a read-side critical section).
+#define RCU_DEREFERENCE(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+
+// Publishes a new value for an RCU-protected pointer.
+#define RCU_ASSIGN_POINTER(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+
+/**
+ * Begins a read-side critical section on the calling thread.
+ */
+void Rcu_readLock(void);
+
+/**
+ * Ends a read-side critical section on the calling thread.
+ */
+void Rcu_readUnlock(void);
+
+/**
+ * Waits until all read-side critical sections which began before this call
+ * have ended (i.e. for a grace period), after which data unpublished before
+ * this call may be freed.
+ */
+void Rcu_synchronize(void);
+
+#endif // _Rcu_h_
@@ -0,0 +1,504 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "RowParser.h"
+
+
+// Largest mantissa that can still take another decimal digit without overflowing 64 bits.
+#define MANTISSA_DIGIT_LIMIT (1000000000000000000ULL)
+
+// Powers of ten that are exactly representable as doubles.
+static const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define POW10_MAX ((int) (sizeof(POW10) / sizeof(double)) - 1)
+
+
+// Smallest byte range of a file worth parsing on a thread of its own
+#define ROW_READER_MIN_CHUNK_SIZE (ROW_READER_BUF_SIZE)
+
+// Byte ranges a file is split into per thread (so that threads finishing their ranges early take on more)
+#define ROW_READER_CHUNKS_PER_THREAD (4)
+
+#define ROW_READER_MAX_THREADS (64)
+
+// A mapped file being parsed by RowReader_readAll(), shared by the threads parsing it
+typedef struct
+{
+	const char* data;
+	size_t size;
+
+	int ncols;
+	RowReaderFunc func;
+	void* arg;
+
+	int chunks;
+
+	pthread_mutex_t lock;
+	int nextChunk;
+	bool failed;
+} RowReadJob;
+
+
+static int readMappedRows(const char* data, size_t size, int ncols, int threads, RowReaderFunc func, void* arg);
+static void* rowReadWorkerMain(void* arg);
+static size_t getChunkStart(const RowReadJob* job, int chunk);
+
+
+static inline bool isDigit(char c)
+{
+	return ((unsigned int) (c - '0') < 10);
+}
+
+static inline bool matchNoCase(const char* p, const char* end, const char* word)
+{
+	for (; *word; word++, p++)
+	{
+		if (p == end || (*p | 0x20) != *word)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static inline const char* parseFloat(const char* p, const char* end, float* out)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+	{
+		p++;
+	}
+
+	bool neg = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		neg = (*p == '-');
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int exp10 = 0;
+	bool anyDigits = false;
+
+	for (; p < end && isDigit(*p); p++)
+	{
+		anyDigits = true;
+
+		if (mantissa < MANTISSA_DIGIT_LIMIT)
+		{
+			mantissa = (mantissa * 10) + (*p - '0');
+		}
+		else
+		{
+			exp10++;
+		}
+	}
+
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && isDigit(*p); p++)
+		{
+			anyDigits = true;
+
+			if (mantissa < MANTISSA_DIGIT_LIMIT)
+			{
+				mantissa = (mantissa * 10) + (*p - '0');
+				exp10--;
+			}
+		}
+	}
+
+	if (!anyDigits)
+	{
+		if (matchNoCase(p, end, "nan"))
+		{
+			*out = (neg ? -NAN : NAN);
+		}
+		else if (matchNoCase(p, end, "inf"))
+		{
+			*out = (neg ? -INFINITY : INFINITY);
+		}
+		else
+		{
+			*out = 0.0f;
+		}
+
+		return p;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* q = p + 1;
+
+		bool expNeg = false;
+		if (q < end && (*q == '-' || *q == '+'))
+		{
+			expNeg = (*q == '-');
+			q++;
+		}
+
+		if (q < end && isDigit(*q))
+		{
+			int e = 0;
+			for (; q < end && isDigit(*q); q++)
+			{
+				if (e < 10000)
+				{
+					e = (e * 10) + (*q - '0');
+				}
+			}
+
+			exp10 += (expNeg ? -e : e);
+			p = q;
+		}
+	}
+
+	double v = (double) mantissa;
+
+	if (mantissa != 0 && exp10 != 0)
+	{
+		if (exp10 < 0 && exp10 >= -POW10_MAX)
+		{
+			v /= POW10[-exp10];
+		}
+		else if (exp10 > 0 && exp10 <= POW10_MAX)
+		{
+			v *= POW10[exp10];
+		}
+		else
+		{
+			v *= pow(10.0, exp10);
+		}
+	}
+
+	*out = (float) (neg ? -v : v);
+	return p;
+}
+
+
+int RowParser_parseRow(const char** pp, const char* end, float* cols, int ncols)
+{
+	const char* p = *pp;
+	int rc = 0;
+
+	for (int i = 0; i < ncols; i++)
+	{
+		// As with strtok(), empty columns are skipped over.
+		while (p < end && *p == ',')
+		{
+			p++;
+		}
+
+		if (p == end || *p == '\n')
+		{
+			rc = -(i + 1);
+			break;
+		}
+
+		p = parseFloat(p, end, cols + i);
+
+		while (p < end && *p != ',' && *p != '\n')
+		{
+			p++;
+		}
+	}
+
+	const char* nl = memchr(p, '\n', end - p);
+	*pp = (nl ? nl + 1 : end);
+
+	return rc;
+}
+
+
+int RowReader_open(RowReader* rr, const char* path)
+{
+	rr->gz = 0;
+
+	rr->fd = open(path, O_RDONLY);
+	if (rr->fd < 0)
+	{
+		return -1;
+	}
+
+	posix_fadvise(rr->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	if (Decompress_isGzip(rr->fd) && !(rr->gz = Decompress_openStream(rr->fd)))
+	{
+		close(rr->fd);
+		rr->fd = -1;
+		return -1;
+	}
+
+	rr->eof = false;
+	rr->start = 0;
+	rr->len = 0;
+
+	return 0;
+}
+
+int RowReader_next(RowReader* rr, float* cols, int ncols)
+{
+	for (;;)
+	{
+		const char* start = rr->buf + rr->start;
+		const size_t avail = rr->len - rr->start;
+
+		const char* nl = memchr(start, '\n', avail);
+		if (nl || (rr->eof && avail > 0))
+		{
+			const char* p = start;
+			const int rc = RowParser_parseRow(&p, (nl ? nl + 1 : start + avail), cols, ncols);
+
+			rr->start = p - rr->buf;
+			return ((rc == 0) ? 1 : rc);
+		}
+
+		if (rr->eof)
+		{
+			return 0;
+		}
+
+		// Only a partial row is buffered, so move it to the front of the buffer and read more data.
+		if (rr->start > 0)
+		{
+			memmove(rr->buf, start, avail);
+			rr->start = 0;
+			rr->len = avail;
+		}
+
+		if (rr->len == ROW_READER_BUF_SIZE)
+		{
+			// Row is too long to fit in the buffer.
+			return -100;
+		}
+
+		const ssize_t n = (rr->gz ?
+				Decompress_readStream(rr->gz, (uint8_t*) rr->buf + rr->len, ROW_READER_BUF_SIZE - rr->len) :
+				read(rr->fd, rr->buf + rr->len, ROW_READER_BUF_SIZE - rr->len));
+		if (n < 0)
+		{
+			if (!rr->gz && errno == EINTR)
+			{
+				continue;
+			}
+
+			return -101;
+		}
+
+		if (n == 0)
+		{
+			rr->eof = true;
+		}
+		else
+		{
+			rr->len += n;
+		}
+	}
+}
+
+void RowReader_close(RowReader* rr)
+{
+	Decompress_closeStream(rr->gz);
+	rr->gz = 0;
+
+	if (rr->fd >= 0)
+	{
+		close(rr->fd);
+		rr->fd = -1;
+	}
+}
+
+int RowReader_readAll(const char* path, int ncols, int threads, RowReaderFunc func, void* arg)
+{
+	if (threads > 1)
+	{
+		const int fd = open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			return -1;
+		}
+
+		struct stat st;
+		if (0 == fstat(fd, &st) && st.st_size >= 2 * ROW_READER_MIN_CHUNK_SIZE && !Decompress_isGzip(fd))
+		{
+			const size_t size = st.st_size;
+			void* data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+
+			if (data != MAP_FAILED)
+			{
+				madvise(data, size, MADV_WILLNEED);
+
+				const int rc = readMappedRows((const char*) data, size, ncols, threads, func, arg);
+				munmap(data, size);
+
+				return rc;
+			}
+		}
+		else
+		{
+			close(fd);
+		}
+	}
+
+	RowReader rr;
+	float cols[ROW_PARSER_MAX_COLS];
+	int rc;
+
+	if (RowReader_open(&rr, path) != 0)
+	{
+		return -1;
+	}
+
+	while ((rc = RowReader_next(&rr, cols, ncols)) == 1)
+	{
+		func(arg, cols);
+	}
+	RowReader_close(&rr);
+
+	return rc;
+}
+
+
+static int readMappedRows(const char* data, size_t size, int ncols, int threads, RowReaderFunc func, void* arg)
+{
+	RowReadJob job;
+
+	job.data = data;
+	job.size = size;
+	job.ncols = ncols;
+	job.func = func;
+	job.arg = arg;
+	job.nextChunk = 0;
+	job.failed = false;
+
+	if (threads > ROW_READER_MAX_THREADS)
+	{
+		threads = ROW_READER_MAX_THREADS;
+	}
+
+	job.chunks = threads * ROW_READER_CHUNKS_PER_THREAD;
+	if (((size_t) job.chunks) > size / ROW_READER_MIN_CHUNK_SIZE)
+	{
+		job.chunks = size / ROW_READER_MIN_CHUNK_SIZE;
+	}
+
+	if (threads > job.chunks)
+	{
+		threads = job.chunks;
+	}
+
+	if (0 != pthread_mutex_init(&job.lock, 0))
+	{
+		return -1;
+	}
+
+	int started = 0;
+	pthread_t workers[ROW_READER_MAX_THREADS];
+
+	for (; started < threads; started++)
+	{
+		if (0 != pthread_create(&workers[started], 0, &rowReadWorkerMain, &job))
+		{
+			break;
+		}
+	}
+
+	if (started == 0)
+	{
+		// Couldn't start any workers, so just do all the work on this thread.
+		rowReadWorkerMain(&job);
+	}
+
+	for (int i = 0; i < started; i++)
+	{
+		pthread_join(workers[i], 0);
+	}
+
+	pthread_mutex_destroy(&job.lock);
+
+	return (job.failed ? -1 : 0);
+}
+
+static void* rowReadWorkerMain(void* arg)
+{
+	RowReadJob* job = (RowReadJob*) arg;
+
+	float cols[ROW_PARSER_MAX_COLS];
+
+	for (;;)
+	{
+		pthread_mutex_lock(&job->lock);
+		const int chunk = (job->failed ? job->chunks : job->nextChunk++);
+		pthread_mutex_unlock(&job->lock);
+
+		if (chunk >= job->chunks)
+		{
+			break;
+		}
+
+		const char* p = job->data + getChunkStart(job, chunk);
+		const char* end = job->data + getChunkStart(job, chunk + 1);
+
+		while (p < end)
+		{
+			if (RowParser_parseRow(&p, end, cols, job->ncols) != 0)
+			{
+				pthread_mutex_lock(&job->lock);
+				job->failed = true;
+				pthread_mutex_unlock(&job->lock);
+				break;
+			}
+
+			job->func(job->arg, cols);
+		}
+	}
+
+	return 0;
+}
+
+// Gets the offset of the start of a byte range (the start of the first row starting at or after
+// its share of the file), which is also the end of the previous range.
+static size_t getChunkStart(const RowReadJob* job, int chunk)
+{
+	if (chunk == 0)
+	{
+		return 0;
+	}
+
+	if (chunk == job->chunks)
+	{
+		return job->size;
+	}
+
+	const size_t offset = (job->size / job->chunks) * chunk;
+
+	const char* nl = memchr(job->data + offset - 1, '\n', job->size - offset + 1);
+	return (nl ? (size_t) (nl + 1 - job->data) : job->size);
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RowParser_h_
+#define _RowParser_h_
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "Decompress.h"
+
+
+/**
+ * Parser for the comma-separated numeric rows used by all data files.
+ *
+ * Numbers are parsed without any locale lookups ('.' is always the decimal
+ * separator) and the input is never modified, so it may be a read-only mapping.
+ * Values accepted by strtof() in the "C" locale are supported, including "nan"
+ * and "inf". Results may differ from strtof() by at most one unit in the last
+ * place. As with strtof(), a column that isn't a number at all reads as 0.
+ *
+ * Integer-valued columns are parsed as floats too. Callers converting them
+ * back to int get the same (truncated) values strtol() would provide.
+ */
+
+#define ROW_PARSER_MAX_COLS (6)
+
+#define ROW_READER_BUF_SIZE (64 * 1024)
+
+
+typedef struct
+{
+	int fd;
+	DecompressStream* gz; // zero if the file isn't compressed
+	bool eof;
+
+	size_t start;
+	size_t len;
+
+	char buf[ROW_READER_BUF_SIZE];
+} RowReader;
+
+
+/**
+ * Parses one row of comma-separated numeric values.
+ *
+ * Parameters
+ * 	p [in/out]: the position of the row start; on return, the start of the next row
+ * 	end [in]: the end of the input data
+ * 	cols [out]: the parsed column values
+ * 	ncols [in]: the number of columns expected (at most ROW_PARSER_MAX_COLS);
+ * 	            any further columns in the row are ignored
+ *
+ * Returns
+ * 	0, on success
+ * 	-N, if the row ended before column N (1-based) was found
+ */
+int RowParser_parseRow(const char** p, const char* end, float* cols, int ncols);
+
+/**
+ * Opens a file for reading rows.
+ *
+ * Gzip compressed files are detected (by their magic number, whatever their
+ * name) and decompressed as they're read, a buffer at a time.
+ *
+ * Returns
+ * 	0, on success
+ * 	any other value, on failure
+ */
+int RowReader_open(RowReader* rr, const char* path);
+
+/**
+ * Reads and parses the next row (see RowParser_parseRow()).
+ *
+ * Returns
+ * 	1, if a row was read
+ * 	0, at the end of the file
+ * 	a negative value, on failure (malformed row or read error)
+ */
+int RowReader_next(RowReader* rr, float* cols, int ncols);
+
+/**
+ * Closes a file opened by RowReader_open().
+ */
+void RowReader_close(RowReader* rr);
+
+/**
+ * Called with the column values of each row read by RowReader_readAll().
+ */
+typedef void (*RowReaderFunc)(void* arg, const float* cols);
+
+/**
+ * Reads and parses all rows of a file (see RowParser_parseRow()), calling a
+ * function with the column values of each.
+ *
+ * Uncompressed files large enough to be worth it are mapped, split into byte
+ * ranges at row boundaries, and the ranges parsed concurrently on up to the
+ * given number of threads. The function may then be called from several threads
+ * at once (for different rows), and not in the order of the rows, so rows must be
+ * independent of one another. Other files are read a buffer at a time on the
+ * calling thread (as with RowReader_next()), with rows passed in order.
+ *
+ * Parameters
+ * 	path [in]: the path of the file
+ * 	ncols [in]: the number of columns expected (at most ROW_PARSER_MAX_COLS)
+ * 	threads [in]: the maximum number of threads to use
+ * 	func [in]: the function to call for each row
+ * 	arg [in]: the argument passed to the function
+ *
+ * Returns
+ * 	0, on success
+ * 	a negative value, on failure (malformed row or read error), in which case
+ * 	the function may already have been called for some rows
+ */
+int RowReader_readAll(const char* path, int ncols, int threads, RowReaderFunc func, void* arg);
+
+
+// Converts a parsed integer-valued column back to an int, mapping values an
+// int can't represent (including NaN) to 0.
+static inline int RowParser_toInt(float f)
+{
+	return ((f > (float) INT_MIN && f < (float) INT_MAX) ? (int) f : 0);
+}
+
+#endif // _RowParser_h_
@@ -0,0 +1,285 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "proteus_internal.h"
+
+#include "proteus/Scheduler.h"
+#include "ErrLog.h"
+#include "Scheduler.h"
+
+#define ERRLOG_ID "proteus_Scheduler"
+#define SCHEDULER_THREAD_NAME "proteus_Sched"
+
+
+// Plenty for the jobs of several contexts of each module
+#define SCHEDULER_MAX_JOBS (64)
+
+
+typedef struct
+{
+	int id;
+	time_t deadline;
+	SchedulerJobFunc func;
+	void* arg;
+	const char* name;
+} SchedulerJob;
+
+// Scheduled jobs, sorted by deadline (earliest first)
+static SchedulerJob _jobs[SCHEDULER_MAX_JOBS];
+static int _jobCount = 0;
+static int _nextJobId = 1;
+
+// The job currently running (if any), and whether it was cancelled while running
+static int _runningId = 0;
+static bool _runningCancelled = false;
+
+static proteus_SchedulerClock _clock = 0;
+
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _queueCond = PTHREAD_COND_INITIALIZER; // signalled when the earliest deadline or the clock changes
+static pthread_cond_t _doneCond = PTHREAD_COND_INITIALIZER; // signalled when a job finishes running
+
+static pthread_t _schedulerThread;
+static bool _schedulerThreadStarted = false;
+static void* schedulerMain();
+
+
+static time_t now(void);
+static void insertJob(const SchedulerJob* job);
+static void removeJob(int i);
+static int runDueJobs(void);
+
+
+int Scheduler_add(time_t deadline, SchedulerJobFunc func, void* arg, const char* name)
+{
+	pthread_mutex_lock(&_lock);
+
+	// (A running job is out of the queue, but needs its slot back once done.)
+	if (_jobCount + ((_runningId != 0) ? 1 : 0) == SCHEDULER_MAX_JOBS)
+	{
+		pthread_mutex_unlock(&_lock);
+		ERRLOG1("Too many jobs to schedule %s!", name);
+		return -1;
+	}
+
+	if (!_schedulerThreadStarted)
+	{
+		if (0 != pthread_create(&_schedulerThread, 0, &schedulerMain, 0))
+		{
+			pthread_mutex_unlock(&_lock);
+			ERRLOG("Failed to create scheduler thread!");
+			return -2;
+		}
+
+		_schedulerThreadStarted = true;
+
+#if defined(_GNU_SOURCE) && defined(__GLIBC__)
+		if (0 != pthread_setname_np(_schedulerThread, SCHEDULER_THREAD_NAME))
+		{
+			ERRLOG1("Couldn't set thread name to %s. Continuing anyway.", SCHEDULER_THREAD_NAME);
+		}
+#endif
+	}
+
+	const SchedulerJob job = { .id = _nextJobId++, .deadline = deadline, .func = func, .arg = arg, .name = name };
+	insertJob(&job);
+
+	pthread_cond_signal(&_queueCond);
+	pthread_mutex_unlock(&_lock);
+
+	ERRLOG2("Scheduled %s at %lu.", name, deadline);
+
+	return job.id;
+}
+
+void Scheduler_cancel(int id)
+{
+	if (id <= 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&_lock);
+
+	for (int i = 0; i < _jobCount; i++)
+	{
+		if (_jobs[i].id == id)
+		{
+			removeJob(i);
+			break;
+		}
+	}
+
+	if (_runningId == id)
+	{
+		// Don't let the job reschedule itself once done.
+		_runningCancelled = true;
+
+		while (_runningId == id)
+		{
+			pthread_cond_wait(&_doneCond, &_lock);
+		}
+	}
+
+	pthread_mutex_unlock(&_lock);
+}
+
+time_t Scheduler_now(void)
+{
+	pthread_mutex_lock(&_lock);
+	const time_t t = now();
+	pthread_mutex_unlock(&_lock);
+
+	return t;
+}
+
+
+PROTEUS_API time_t proteus_Scheduler_getNextTime(void)
+{
+	pthread_mutex_lock(&_lock);
+	const time_t t = ((_jobCount > 0) ? _jobs[0].deadline : 0);
+	pthread_mutex_unlock(&_lock);
+
+	return t;
+}
+
+PROTEUS_API void proteus_Scheduler_setClock(proteus_SchedulerClock clock)
+{
+	pthread_mutex_lock(&_lock);
+	_clock = clock;
+	pthread_cond_signal(&_queueCond);
+	pthread_mutex_unlock(&_lock);
+}
+
+PROTEUS_API int proteus_Scheduler_runDue(void)
+{
+	pthread_mutex_lock(&_lock);
+	const int count = runDueJobs();
+	pthread_mutex_unlock(&_lock);
+
+	return count;
+}
+
+
+static void* schedulerMain()
+{
+	pthread_mutex_lock(&_lock);
+
+	for (;;)
+	{
+		if (_clock)
+		{
+			// Jobs only run on proteus_Scheduler_runDue() calls while a clock is set.
+			pthread_cond_wait(&_queueCond, &_lock);
+			continue;
+		}
+
+		runDueJobs();
+
+		if (_jobCount == 0)
+		{
+			pthread_cond_wait(&_queueCond, &_lock);
+			continue;
+		}
+
+		// Sleep until the earliest deadline (or until that changes).
+		const struct timespec waitUntilTime = { .tv_sec = _jobs[0].deadline, .tv_nsec = 0 };
+		const int rc = pthread_cond_timedwait(&_queueCond, &_lock, &waitUntilTime);
+
+		if (rc != 0 && rc != ETIMEDOUT)
+		{
+			ERRLOG1("schedulerMain: pthread_cond_timedwait failed with rc=%d", rc);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&_lock);
+
+	return 0;
+}
+
+static time_t now(void)
+{
+	return (_clock ? _clock() : time(0));
+}
+
+static void insertJob(const SchedulerJob* job)
+{
+	int i = _jobCount;
+	for (; i > 0 && _jobs[i - 1].deadline > job->deadline; i--)
+	{
+		_jobs[i] = _jobs[i - 1];
+	}
+
+	_jobs[i] = *job;
+	_jobCount++;
+}
+
+static void removeJob(int i)
+{
+	for (; i < _jobCount - 1; i++)
+	{
+		_jobs[i] = _jobs[i + 1];
+	}
+
+	_jobCount--;
+}
+
+// Runs due jobs one at a time (across all callers), with the lock held (but not while running each job).
+static int runDueJobs(void)
+{
+	int count = 0;
+
+	for (;;)
+	{
+		while (_runningId != 0)
+		{
+			pthread_cond_wait(&_doneCond, &_lock);
+		}
+
+		if (_jobCount == 0 || _jobs[0].deadline > now())
+		{
+			break;
+		}
+
+		SchedulerJob job = _jobs[0];
+		removeJob(0);
+
+		_runningId = job.id;
+		_runningCancelled = false;
+
+		pthread_mutex_unlock(&_lock);
+		const time_t next = job.func(job.arg, job.deadline);
+		pthread_mutex_lock(&_lock);
+
+		if (next != 0 && !_runningCancelled)
+		{
+			job.deadline = next;
+			insertJob(&job);
+		}
+
+		_runningId = 0;
+		pthread_cond_broadcast(&_doneCond);
+
+		count++;
+	}
+
+	return count;
+}
@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _Scheduler_h_
+#define _Scheduler_h_
+
+#include <time.h>
+
+
+/**
+ * A queue of jobs ordered by their (absolute) deadlines, run one at a time on a
+ * single scheduler thread (started along with the first job), which sleeps until
+ * the earliest deadline rather than polling.
+ *
+ * A job function is passed the deadline it was scheduled for, and returns its
+ * next deadline (or zero, if it's done), so periodic jobs just keep rescheduling
+ * themselves.
+ */
+
+typedef time_t (*SchedulerJobFunc)(void* arg, time_t deadline);
+
+
+/**
+ * Schedules a job.
+ *
+ * Parameters
+ * 	deadline [in]: the time at which the job is first due
+ * 	func [in]: the job function
+ * 	arg [in]: the argument passed to the job function
+ * 	name [in]: the name of the job (for logging)
+ *
+ * Returns
+ * 	the job ID (always positive), on success
+ * 	a negative value, on failure
+ */
+int Scheduler_add(time_t deadline, SchedulerJobFunc func, void* arg, const char* name);
+
+/**
+ * Cancels a job. If the job is running, waits for it to finish (so this must
+ * not be called from the job itself). Unknown (or zero) job IDs are ignored.
+ */
+void Scheduler_cancel(int id);
+
+/**
+ * Returns the current time, according to the scheduler clock.
+ */
+time_t Scheduler_now(void);
+
+#endif // _Scheduler_h_
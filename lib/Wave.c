@@ -29,9 +29,14 @@
 #include "proteus/ScalarConv.h"
 #include "Constants.h"
 #include "ErrLog.h"
+#include "FileWatch.h"
+#include "GridPool.h"
+#include "RowParser.h"
+#include "Scheduler.h"
 
 #define ERRLOG_ID "proteus_Wave"
-#define UPDATER_THREAD_NAME "proteus_Wave"
+#define UPDATE_JOB_NAME "proteus_Wave update"
+#define RELOAD_JOB_NAME "proteus_Wave reload"
 
 
 // NOTE: This module currently makes some fixed assumptions about the grid dimensions
@@ -52,48 +57,182 @@ typedef struct
 	float waveHeight; // m
 } WaveGridPoint;
 
-static const char* _f1File = 0;
-static const char* _f2File = 0;
+// Watch of a forecast data file of a context, and the job reloading its data once changed
+typedef struct
+{
+	proteus_WaveCtx* ctx;
+	int i; // 0 for the "f1" file, 1 for the "f2" file
+
+	int watch; // zero if not watching
+	int reloadJob; // zero if not scheduled
+} WaveFileWatch;
+
+/**
+ * A wave context: the forecast data loaded from one pair of files, and everything used
+ * to load and update it.
+ */
+struct proteus_WaveCtx
+{
+	char* f1File;
+	char* f2File;
+
+	WaveGridPoint* grid0;
+	WaveGridPoint* grid1;
+	pthread_rwlock_t gridLock;
+	GridPool gridPool; // buffers for both grids, and the one being loaded
+	time_t gridPhaseTime;
+
+	// Hashes of the data loaded into grids 0 and 1 (see FileWatch_hashFile()), or zero if not known
+	uint64_t gridHashes[2];
+
+	int updateJob; // zero if not scheduled
+
+	// Whether the forecast data files are watched for changes
+	bool watchFiles;
 
-static WaveGridPoint* _waveGrid0 = 0;
-static WaveGridPoint* _waveGrid1 = 0;
-static pthread_rwlock_t _waveGridLock;
-static time_t _waveGridPhaseTime = 0;
+	// Number of threads parsing a forecast data file (see proteus_WaveOptions.ingestThreads)
+	int ingestThreads;
 
-static pthread_t _waveUpdaterThread;
-static void* waveUpdaterMain();
+	// Watches of the "f1" and "f2" forecast data files
+	WaveFileWatch watches[2];
+};
 
+// The context used by the global API (proteus_Wave_*())
+static proteus_WaveCtx _defaultCtx = {
+	.gridLock = PTHREAD_RWLOCK_INITIALIZER,
+	.ingestThreads = 1,
+	.watches = { { .ctx = &_defaultCtx, .i = 0 }, { .ctx = &_defaultCtx, .i = 1 } }
+};
 
-static void updateWaveGrid(int grid, const char* waveDataPath);
-static int readWavePoint(char* s, float* x, float* y, float* waveHeight);
 
+static void resetWave(proteus_WaveCtx* ctx);
+
+static time_t waveUpdateJob(void* arg, time_t deadline);
+static time_t getNextWaveUpdateTime(time_t t);
+
+static void waveWatchFunc(void* arg, const char* name);
+static time_t waveReloadJob(void* arg, time_t deadline);
+
+
+static void updateWaveGrid(proteus_WaveCtx* ctx, int grid, const char* waveDataPath);
+
+static void insertWaveRow(void* arg, const float* cols);
 static void insertWaveGridPoint(WaveGridPoint* waveGrid, float lon, float lat, float waveHeight);
 
 static int getXYIndex(int x, int y);
 static bool validLonLat(double lon, double lat);
 
 
+PROTEUS_API void proteus_Wave_getDefaultOptions(proteus_WaveOptions* opts)
+{
+	memset(opts, 0, sizeof(proteus_WaveOptions));
+
+	opts->ingestThreads = 1;
+}
+
 PROTEUS_API int proteus_Wave_init(const char* f1File, const char* f2File)
 {
-	if (!f1File || !f2File)
+	return proteus_WaveCtx_init(&_defaultCtx, f1File, f2File);
+}
+
+PROTEUS_API int proteus_Wave_initWithOptions(const char* f1File, const char* f2File, const proteus_WaveOptions* opts)
+{
+	return proteus_WaveCtx_initWithOptions(&_defaultCtx, f1File, f2File, opts);
+}
+
+PROTEUS_API bool proteus_Wave_get(const proteus_GeoPos* pos, proteus_WaveData* wd)
+{
+	return proteus_WaveCtx_getAt(&_defaultCtx, pos, time(0), wd);
+}
+
+PROTEUS_API bool proteus_Wave_getAt(const proteus_GeoPos* pos, time_t t, proteus_WaveData* wd)
+{
+	return proteus_WaveCtx_getAt(&_defaultCtx, pos, t, wd);
+}
+
+
+PROTEUS_API proteus_WaveCtx* proteus_WaveCtx_create(void)
+{
+	proteus_WaveCtx* ctx = calloc(1, sizeof(proteus_WaveCtx));
+	if (!ctx)
+	{
+		return 0;
+	}
+
+	if (0 != pthread_rwlock_init(&ctx->gridLock, 0))
+	{
+		ERRLOG("Failed to init rwlock!");
+		free(ctx);
+		return 0;
+	}
+
+	ctx->ingestThreads = 1;
+
+	for (int i = 0; i < 2; i++)
+	{
+		ctx->watches[i].ctx = ctx;
+		ctx->watches[i].i = i;
+	}
+
+	return ctx;
+}
+
+PROTEUS_API void proteus_WaveCtx_destroy(proteus_WaveCtx* ctx)
+{
+	if (!ctx || ctx == &_defaultCtx)
+	{
+		return;
+	}
+
+	resetWave(ctx);
+
+	pthread_rwlock_destroy(&ctx->gridLock);
+	free(ctx);
+}
+
+PROTEUS_API proteus_WaveCtx* proteus_WaveCtx_getDefault(void)
+{
+	return &_defaultCtx;
+}
+
+PROTEUS_API int proteus_WaveCtx_init(proteus_WaveCtx* ctx, const char* f1File, const char* f2File)
+{
+	proteus_WaveOptions opts;
+	proteus_Wave_getDefaultOptions(&opts);
+
+	return proteus_WaveCtx_initWithOptions(ctx, f1File, f2File, &opts);
+}
+
+PROTEUS_API int proteus_WaveCtx_initWithOptions(proteus_WaveCtx* ctx, const char* f1File, const char* f2File, const proteus_WaveOptions* opts)
+{
+	if (!ctx || !f1File || !f2File || !opts || opts->ingestThreads < 1)
 	{
 		return -3;
 	}
 
-	_f1File = strdup(f1File);
-	_f2File = strdup(f2File);
+	resetWave(ctx);
 
-	if (0 != pthread_rwlock_init(&_waveGridLock, 0))
+	int rc = 0;
+
+	ctx->watchFiles = opts->watchFiles;
+	ctx->ingestThreads = opts->ingestThreads;
+
+	ctx->f1File = strdup(f1File);
+	ctx->f2File = strdup(f2File);
+
+	if (0 != GridPool_init(&ctx->gridPool, WAVE_GRID_X * WAVE_GRID_Y * sizeof(WaveGridPoint), 3, false))
 	{
-		ERRLOG("Failed to init rwlock!");
-		return -4;
+		ERRLOG("Failed to init grid pool!");
+		rc = -4;
+		goto fail;
 	}
 
-	time_t curTime = time(0);
+	const time_t curTime = Scheduler_now();
 	struct tm tres;
 	if (&tres != gmtime_r(&curTime, &tres))
 	{
-		return -2;
+		rc = -2;
+		goto fail;
 	}
 
 	const int hour = tres.tm_hour;
@@ -103,39 +242,63 @@ PROTEUS_API int proteus_Wave_init(const char* f1File, const char* f2File)
 	{
 		// In this situation, it's expected that the "f2" data would be "older" than the "f1" data,
 		// so just init both grids to the same data for now.
-		updateWaveGrid(0, _f1File);
-		updateWaveGrid(1, _f1File);
+		updateWaveGrid(ctx, 0, ctx->f1File);
+		updateWaveGrid(ctx, 1, ctx->f1File);
 
 		// Actual phase time doesn't matter when both grids are identical.
-		_waveGridPhaseTime = curTime;
+		ctx->gridPhaseTime = curTime;
 	}
 	else
 	{
-		updateWaveGrid(0, _f1File);
-		updateWaveGrid(1, _f2File);
+		updateWaveGrid(ctx, 0, ctx->f1File);
+		updateWaveGrid(ctx, 1, ctx->f2File);
 
 		// Next phase time at 0600Z + phase interval.
-		_waveGridPhaseTime = curTime - (3600 * hour) - (60 * min) + (3600 * 6) + WAVE_DATA_PHASE_IN_SECONDS;
+		ctx->gridPhaseTime = curTime - (3600 * hour) - (60 * min) + (3600 * 6) + WAVE_DATA_PHASE_IN_SECONDS;
 	}
 
-	ERRLOG2("Wave grid phase time: %lu (%ld seconds from now).", _waveGridPhaseTime, (_waveGridPhaseTime - curTime));
+	if (!ctx->grid0 || !ctx->grid1)
+	{
+		rc = -1;
+		goto fail;
+	}
 
-	if (0 != pthread_create(&_waveUpdaterThread, 0, &waveUpdaterMain, 0))
+	ERRLOG2("Wave grid phase time: %lu (%ld seconds from now).", ctx->gridPhaseTime, (ctx->gridPhaseTime - curTime));
+
+	if ((ctx->updateJob = Scheduler_add(getNextWaveUpdateTime(curTime), &waveUpdateJob, ctx, UPDATE_JOB_NAME)) < 0)
 	{
-		return -2;
+		ctx->updateJob = 0;
+		rc = -2;
+		goto fail;
 	}
 
-#if defined(_GNU_SOURCE) && defined(__GLIBC__)
-	if (0 != pthread_setname_np(_waveUpdaterThread, UPDATER_THREAD_NAME))
+	// (Only one watch, if both forecast points use the same file.)
+	const int files = (!ctx->watchFiles ? 0 : ((0 == strcmp(ctx->f1File, ctx->f2File)) ? 1 : 2));
+
+	for (int i = 0; i < files; i++)
 	{
-		ERRLOG1("Couldn't set thread name to %s. Continuing anyway.", UPDATER_THREAD_NAME);
+		if ((ctx->watches[i].watch = FileWatch_add((i == 0) ? ctx->f1File : ctx->f2File, false, &waveWatchFunc, &ctx->watches[i])) < 0)
+		{
+			ctx->watches[i].watch = 0;
+			ERRLOG("Failed to watch wave data file! Wave grids will only be updated at the scheduled times.");
+		}
 	}
-#endif
 
-	return ((_waveGrid0 != 0 && _waveGrid1 != 0) ? 0 : -1);
+	return 0;
+
+fail:
+	ERRLOG1("Init failed: rc=%d", rc);
+
+	resetWave(ctx);
+	return rc;
 }
 
-PROTEUS_API bool proteus_Wave_get(const proteus_GeoPos* pos, proteus_WaveData* wd)
+PROTEUS_API bool proteus_WaveCtx_get(proteus_WaveCtx* ctx, const proteus_GeoPos* pos, proteus_WaveData* wd)
+{
+	return proteus_WaveCtx_getAt(ctx, pos, time(0), wd);
+}
+
+PROTEUS_API bool proteus_WaveCtx_getAt(proteus_WaveCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_WaveData* wd)
 {
 	if (!validLonLat(pos->lon, pos->lat))
 	{
@@ -161,33 +324,39 @@ PROTEUS_API bool proteus_Wave_get(const proteus_GeoPos* pos, proteus_WaveData* w
 	}
 
 	bool ret = false;
-	if (0 != pthread_rwlock_rdlock(&_waveGridLock))
+	if (0 != pthread_rwlock_rdlock(&ctx->gridLock))
 	{
 		ERRLOG("get: Failed to lock for read!");
 		return false;
 	}
 
-	const WaveGridPoint* waveGridPtA0 = _waveGrid0 + getXYIndex(ilon, ilat);
-	const WaveGridPoint* waveGridPtB0 = _waveGrid0 + getXYIndex(ilon + 1, ilat);
-	const WaveGridPoint* waveGridPtC0 = _waveGrid0 + getXYIndex(ilon, ilat + 1);
-	const WaveGridPoint* waveGridPtD0 = _waveGrid0 + getXYIndex(ilon + 1, ilat + 1);
+	if (!ctx->grid0 || !ctx->grid1)
+	{
+		// (Not initialized.)
+		goto done;
+	}
+
+	const WaveGridPoint* waveGridPtA0 = ctx->grid0 + getXYIndex(ilon, ilat);
+	const WaveGridPoint* waveGridPtB0 = ctx->grid0 + getXYIndex(ilon + 1, ilat);
+	const WaveGridPoint* waveGridPtC0 = ctx->grid0 + getXYIndex(ilon, ilat + 1);
+	const WaveGridPoint* waveGridPtD0 = ctx->grid0 + getXYIndex(ilon + 1, ilat + 1);
 
-	const WaveGridPoint* waveGridPtA1 = _waveGrid1 + getXYIndex(ilon, ilat);
-	const WaveGridPoint* waveGridPtB1 = _waveGrid1 + getXYIndex(ilon + 1, ilat);
-	const WaveGridPoint* waveGridPtC1 = _waveGrid1 + getXYIndex(ilon, ilat + 1);
-	const WaveGridPoint* waveGridPtD1 = _waveGrid1 + getXYIndex(ilon + 1, ilat + 1);
+	const WaveGridPoint* waveGridPtA1 = ctx->grid1 + getXYIndex(ilon, ilat);
+	const WaveGridPoint* waveGridPtB1 = ctx->grid1 + getXYIndex(ilon + 1, ilat);
+	const WaveGridPoint* waveGridPtC1 = ctx->grid1 + getXYIndex(ilon, ilat + 1);
+	const WaveGridPoint* waveGridPtD1 = ctx->grid1 + getXYIndex(ilon + 1, ilat + 1);
 
 	if (ilon == WAVE_GRID_X - 1)
 	{
-		waveGridPtA0 = _waveGrid0 + getXYIndex(ilon, ilat);
-		waveGridPtB0 = _waveGrid0 + getXYIndex(0, ilat);
-		waveGridPtC0 = _waveGrid0 + getXYIndex(ilon, ilat + 1);
-		waveGridPtD0 = _waveGrid0 + getXYIndex(0, ilat + 1);
+		waveGridPtA0 = ctx->grid0 + getXYIndex(ilon, ilat);
+		waveGridPtB0 = ctx->grid0 + getXYIndex(0, ilat);
+		waveGridPtC0 = ctx->grid0 + getXYIndex(ilon, ilat + 1);
+		waveGridPtD0 = ctx->grid0 + getXYIndex(0, ilat + 1);
 
-		waveGridPtA1 = _waveGrid1 + getXYIndex(ilon, ilat);
-		waveGridPtB1 = _waveGrid1 + getXYIndex(0, ilat);
-		waveGridPtC1 = _waveGrid1 + getXYIndex(ilon, ilat + 1);
-		waveGridPtD1 = _waveGrid1 + getXYIndex(0, ilat + 1);
+		waveGridPtA1 = ctx->grid1 + getXYIndex(ilon, ilat);
+		waveGridPtB1 = ctx->grid1 + getXYIndex(0, ilat);
+		waveGridPtC1 = ctx->grid1 + getXYIndex(ilon, ilat + 1);
+		waveGridPtD1 = ctx->grid1 + getXYIndex(0, ilat + 1);
 	}
 
 
@@ -350,7 +519,7 @@ PROTEUS_API bool proteus_Wave_get(const proteus_GeoPos* pos, proteus_WaveData* w
 	const double xFrac = (ilon == 0 && pos->lon == 180.0) ? 0.0 : pos->lon - ((double) (ilon - WAVE_GRID_OFFSET_X));
 	const double yFrac = pos->lat - ((double) (ilat - WAVE_GRID_OFFSET_Y));
 
-	const long tDiff = _waveGridPhaseTime - time(0);
+	const long tDiff = ctx->gridPhaseTime - t;
 	double tFrac = 1.0 - (((double) tDiff) / ((double) WAVE_DATA_PHASE_IN_SECONDS));
 	if (tFrac < 0.0)
 	{
@@ -376,7 +545,7 @@ PROTEUS_API bool proteus_Wave_get(const proteus_GeoPos* pos, proteus_WaveData* w
 	ret = true;
 
 done:
-	if (0 != pthread_rwlock_unlock(&_waveGridLock))
+	if (0 != pthread_rwlock_unlock(&ctx->gridLock))
 	{
 		ERRLOG("get: Failed to unlock rwlock!");
 	}
@@ -384,11 +553,28 @@ done:
 	return ret;
 }
 
-#define WAVE_GRID_PARSE_BUF_SIZE (256)
-
-static void updateWaveGrid(int grid, const char* waveDataPath)
+static void updateWaveGrid(proteus_WaveCtx* ctx, int grid, const char* waveDataPath)
 {
-	WaveGridPoint* waveGrid = malloc(WAVE_GRID_X * WAVE_GRID_Y * sizeof(WaveGridPoint));
+	if (grid == -1 && !ctx->grid1)
+	{
+		// (Only this function replaces grids, so the latest one can be checked without the lock.)
+		ERRLOG1("Wave grids aren't initialized, so not updating from %s.", waveDataPath);
+		return;
+	}
+
+	uint64_t contentHash = FILE_WATCH_HASH_INIT;
+	if (!ctx->watchFiles || 0 != FileWatch_hashFile(waveDataPath, &contentHash))
+	{
+		contentHash = 0;
+	}
+
+	if (grid == -1 && contentHash != 0 && (contentHash == ctx->gridHashes[0] || contentHash == ctx->gridHashes[1]))
+	{
+		ERRLOG1("Wave data in %s is unchanged, so not updating.", waveDataPath);
+		return;
+	}
+
+	WaveGridPoint* waveGrid = GridPool_get(&ctx->gridPool);
 	if (!waveGrid)
 	{
 		ERRLOG("updateWxGrid: Alloc failed for waveGrid!");
@@ -398,7 +584,7 @@ static void updateWaveGrid(int grid, const char* waveDataPath)
 	if (grid == -1)
 	{
 		// Updating wave data grids, so copy previous grid to start with sane values (in case new values are unavailable for some reason).
-		memcpy(waveGrid, _waveGrid1, WAVE_GRID_X * WAVE_GRID_Y * sizeof(WaveGridPoint));
+		memcpy(waveGrid, ctx->grid1, WAVE_GRID_X * WAVE_GRID_Y * sizeof(WaveGridPoint));
 	}
 	else
 	{
@@ -406,98 +592,65 @@ static void updateWaveGrid(int grid, const char* waveDataPath)
 		memset(waveGrid, 0xf0, WAVE_GRID_X * WAVE_GRID_Y * sizeof(WaveGridPoint));
 	}
 
-	FILE* fp;
-	char buf[WAVE_GRID_PARSE_BUF_SIZE];
-
-	float x, y;
-	float waveHeight;
-
-
-	fp = fopen(waveDataPath, "r");
-	if (fp == 0)
+	// (Each row sets a grid point of its own, so rows may be parsed and inserted concurrently.)
+	if (RowReader_readAll(waveDataPath, 3, ctx->ingestThreads, &insertWaveRow, waveGrid) != 0)
 	{
 		goto fail;
 	}
 
-	while (fgets(buf, WAVE_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWavePoint(buf, &x, &y, &waveHeight) != 0)
-		{
-			goto fail;
-		}
-
-		insertWaveGridPoint(waveGrid, x, y, waveHeight);
-	}
-	fclose(fp);
-
 
 	if (grid != -1)
 	{
 		if (grid == 0)
 		{
-			_waveGrid0 = waveGrid;
+			ctx->grid0 = waveGrid;
 		}
 		else
 		{
-			_waveGrid1 = waveGrid;
+			ctx->grid1 = waveGrid;
 		}
 
+		ctx->gridHashes[grid] = contentHash;
+
 		ERRLOG2("Initialized wave grid %d (from %s).", grid, waveDataPath);
 	}
 	else
 	{
-		if (0 != pthread_rwlock_wrlock(&_waveGridLock))
+		if (0 != pthread_rwlock_wrlock(&ctx->gridLock))
 		{
 			ERRLOG("updateWaveGrid: Failed to lock for write!");
 			goto fail;
 		}
 
-		// Update, so free grid 0 data, grid 0 gets grid 1 data, and grid 1 gets latest data.
-		free(_waveGrid0);
-		_waveGrid0 = _waveGrid1;
-		_waveGrid1 = waveGrid;
+		// Update, so recycle grid 0 data, grid 0 gets grid 1 data, and grid 1 gets latest data.
+		GridPool_put(&ctx->gridPool, ctx->grid0);
+		ctx->grid0 = ctx->grid1;
+		ctx->grid1 = waveGrid;
+
+		ctx->gridHashes[0] = ctx->gridHashes[1];
+		ctx->gridHashes[1] = contentHash;
 
-		_waveGridPhaseTime = time(0) + WAVE_DATA_PHASE_IN_SECONDS;
+		ctx->gridPhaseTime = Scheduler_now() + WAVE_DATA_PHASE_IN_SECONDS;
 
-		if (0 != pthread_rwlock_unlock(&_waveGridLock))
+		if (0 != pthread_rwlock_unlock(&ctx->gridLock))
 		{
 			ERRLOG("updateWaveGrid: Failed to unlock rwlock!");
 		}
 
-		ERRLOG2("Updated wave grids (latest from %s). Grid phase time: %lu", waveDataPath, _waveGridPhaseTime);
+		ERRLOG2("Updated wave grids (latest from %s). Grid phase time: %lu", waveDataPath, ctx->gridPhaseTime);
 	}
 
 	return;
 
 fail:
 	ERRLOG("Failed to update wave grid!");
-	free(waveGrid);
+	GridPool_put(&ctx->gridPool, waveGrid);
 }
 
-static int readWavePoint(char* s, float* x, float* y, float* waveHeight)
+static void insertWaveRow(void* arg, const float* cols)
 {
-	char* t;
-	char* w;
-
-	if ((w = strtok_r(s, ",", &t)) == 0)
-	{
-		return -1;
-	}
-	*x = strtof(w, 0);
-
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -2;
-	}
-	*y = strtof(w, 0);
-
-	if ((w = strtok_r(0, ",", &t)) == 0)
-	{
-		return -3;
-	}
-	*waveHeight = strtof(w, 0);
-
-	return 0;
+	// x, y, waveHeight
+	insertWaveGridPoint((WaveGridPoint*) arg, cols[0], cols[1], cols[2]);
 }
 
 static void insertWaveGridPoint(WaveGridPoint* waveGrid, float lon, float lat, float waveHeight)
@@ -543,39 +696,107 @@ static bool validLonLat(double lon, double lat)
 }
 
 
-static void* waveUpdaterMain()
+static time_t waveUpdateJob(void* arg, time_t deadline)
+{
+	proteus_WaveCtx* ctx = (proteus_WaveCtx*) arg;
+
+	const int hour = (int) ((deadline % (24 * 3600)) / 3600);
+	const char* waveDataPath = ((hour == 18) ? ctx->f1File : ctx->f2File);
+	updateWaveGrid(ctx, -1, waveDataPath);
+
+	// (Skipping any updates missed, if running late.)
+	const time_t curTime = Scheduler_now();
+	return getNextWaveUpdateTime((curTime > deadline) ? curTime : deadline);
+}
+
+// Returns the first update time after t: once every twelve hours (at 18Z and 06Z).
+static time_t getNextWaveUpdateTime(time_t t)
 {
-	bool update = false;
+	const time_t day = t - (t % (24 * 3600));
 
-	for (;;)
+	time_t next = day + (6 * 3600);
+	while (next <= t)
 	{
-		time_t curTime = time(0);
-		struct tm tres;
-		if (&tres != gmtime_r(&curTime, &tres))
-		{
-			ERRLOG("gmtime_r failed!");
-			sleep(5);
+		next += 12 * 3600;
+	}
 
-			continue;
-		}
+	return next;
+}
 
-		const int hour = tres.tm_hour;
+static void waveWatchFunc(void* arg, const char* name)
+{
+	(void) name;
 
-		// Attempt to update once every twelve hours (at 18Z and 06Z).
-		if (hour == 17 || hour == 5)
-		{
-			update = true;
-		}
-		else if (update && (hour == 18 || hour == 6))
-		{
-			const char* waveDataPath = ((hour == 18) ? _f1File : _f2File);
-			updateWaveGrid(-1, waveDataPath);
-			update = false;
-		}
+	WaveFileWatch* w = (WaveFileWatch*) arg;
+
+	// Reload once the data settles, pushing back any reload already pending (in case the file is written again).
+	Scheduler_cancel(w->reloadJob);
 
-		// TODO: Sleep until we need to update the grids. Polling with a short sleep here is lazy and causes pointless frequent wakeups.
-		sleep(60);
+	if ((w->reloadJob = Scheduler_add(Scheduler_now() + FILE_WATCH_SETTLE_SECONDS, &waveReloadJob, w, RELOAD_JOB_NAME)) < 0)
+	{
+		w->reloadJob = 0;
+		ERRLOG1("Failed to schedule reload of wave data in %s!", ((w->i == 0) ? w->ctx->f1File : w->ctx->f2File));
 	}
+}
+
+static time_t waveReloadJob(void* arg, time_t deadline)
+{
+	(void) deadline;
+
+	const WaveFileWatch* w = (const WaveFileWatch*) arg;
+	updateWaveGrid(w->ctx, -1, ((w->i == 0) ? w->ctx->f1File : w->ctx->f2File));
 
 	return 0;
 }
+
+static void resetWave(proteus_WaveCtx* ctx)
+{
+	// (Waits for the watch functions and jobs, if they're running. Watches go first, as they schedule reload jobs.)
+	for (int i = 0; i < 2; i++)
+	{
+		FileWatch_remove(ctx->watches[i].watch);
+		Scheduler_cancel(ctx->watches[i].reloadJob);
+
+		ctx->watches[i].watch = 0;
+		ctx->watches[i].reloadJob = 0;
+	}
+
+	Scheduler_cancel(ctx->updateJob);
+	ctx->updateJob = 0;
+
+	if (0 != pthread_rwlock_wrlock(&ctx->gridLock))
+	{
+		ERRLOG("reset: Failed to lock for write!");
+		return;
+	}
+
+	if (ctx->grid0)
+	{
+		GridPool_put(&ctx->gridPool, ctx->grid0);
+		ctx->grid0 = 0;
+	}
+
+	if (ctx->grid1)
+	{
+		GridPool_put(&ctx->gridPool, ctx->grid1);
+		ctx->grid1 = 0;
+	}
+
+	if (0 != pthread_rwlock_unlock(&ctx->gridLock))
+	{
+		ERRLOG("reset: Failed to unlock rwlock!");
+	}
+
+	GridPool_destroy(&ctx->gridPool);
+
+	free(ctx->f1File);
+	free(ctx->f2File);
+	ctx->f1File = 0;
+	ctx->f2File = 0;
+
+	ctx->gridHashes[0] = 0;
+	ctx->gridHashes[1] = 0;
+	ctx->gridPhaseTime = 0;
+	ctx->watchFiles = false;
+	ctx->ingestThreads = 1;
+}
@@ -14,9 +14,9 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <errno.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,19 +30,60 @@
 #include "ScalarConv_internal.h"
 #include "Constants.h"
 #include "ErrLog.h"
+#include "FileWatch.h"
+#include "GridPool.h"
+#include "GridSnapshot.h"
+#include "Rcu.h"
+#include "RowParser.h"
+#include "Scheduler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+// Kernel compiled for AVX2, selected at runtime if the CPU supports it
+#define WX_HAVE_AVX_KERNEL
+#endif
 
 #define ERRLOG_ID "proteus_Weather"
-#define UPDATER_THREAD_NAME "proteus_Weather"
+#define UPDATE_JOB_NAME "proteus_Weather update"
+#define BLEND_JOB_NAME "proteus_Weather blend"
+#define RELOAD_JOB_NAME "proteus_Weather reload"
 
 
-// NOTE: This module currently makes some fixed assumptions about the time between forecast points (for interpolation).
+// NOTE: Unless initialized with a timeline of forecast steps, this module makes some fixed assumptions
+//       about the time between forecast points (for interpolation).
 
 // 2 hours, 58 minutes
 #define WX_DATA_PHASE_IN_SECONDS (2 * (60 * 60) + (58 * 60))
 
+// Number of forecast steps held when not initialized with a timeline (i.e. the two forecast points)
+#define WX_PHASE_STEPS (2)
+
 #define WX_GRID_FILE_PATH_MAXLEN (4096 - 64)
 
+// Version of the binary snapshot payload layout (the data of a WxGrid, i.e. all of its planes).
+// This must be incremented whenever the fields or the grid layout change.
+#define WX_SNAPSHOT_VERSION (4)
+
 
+/**
+ * Grid points are stored either row by row, or (for the larger grids) in square tiles of
+ * (1 << tileShift) by (1 << tileShift) points, themselves stored row by row. With tiles of
+ * 8x8 points, the four points of most cells are within 32 bytes of each other in a plane
+ * (rather than a whole row of the grid apart), so queries touch fewer cache lines and pages.
+ *
+ * Tiles at the east and north edges of the grid are padded, so tilesX and tilesY must be
+ * the number of tiles needed to cover storeX and storeY.
+ *
+ * Only a window of storeX by storeY points of the grid may be stored (when initialized with
+ * a region), starting at the point (originX, originY) and wrapping around at longitude 180.
+ * Grid coordinates are global (0 to gridX-1, 0 to gridY-1), whereas stored points are
+ * indexed by their coordinates within the window.
+ */
 typedef struct
 {
 	int gridX;
@@ -50,16 +91,35 @@ typedef struct
 	int offsetX;
 	int offsetY;
 	float scale;
+
+	int originX;
+	int originY;
+	int storeX; // gridX, if the window spans all longitudes (in which case originX is zero)
+	int storeY;
+
+	int tileShift; // zero if not tiled
+	int tilesX;
+	int tilesY;
 } WxGridConfig;
 
-static WxGridConfig GRID_CONFIG[] = {
+// Tiles of 8x8 points
+#define WX_GRID_TILE_SHIFT (3)
+
+static const WxGridConfig GRID_CONFIG[] = {
 	{
-		// 1P00
+		// 1P00 (small enough to be stored row by row)
 		.gridX = 360,
 		.gridY = 181,
 		.offsetX = 180,
 		.offsetY = 90,
-		.scale = 1.0f
+		.scale = 1.0f,
+		.originX = 0,
+		.originY = 0,
+		.storeX = 360,
+		.storeY = 181,
+		.tileShift = 0,
+		.tilesX = 0,
+		.tilesY = 0
 	},
 	{
 		// 0P50
@@ -67,7 +127,14 @@ static WxGridConfig GRID_CONFIG[] = {
 		.gridY = 361,
 		.offsetX = 360,
 		.offsetY = 180,
-		.scale = 2.0f
+		.scale = 2.0f,
+		.originX = 0,
+		.originY = 0,
+		.storeX = 720,
+		.storeY = 361,
+		.tileShift = WX_GRID_TILE_SHIFT,
+		.tilesX = 90,
+		.tilesY = 46
 	},
 	{
 		// 0P25
@@ -75,70 +142,548 @@ static WxGridConfig GRID_CONFIG[] = {
 		.gridY = 721,
 		.offsetX = 720,
 		.offsetY = 360,
-		.scale = 4.0f
+		.scale = 4.0f,
+		.originX = 0,
+		.originY = 0,
+		.storeX = 1440,
+		.storeY = 721,
+		.tileShift = WX_GRID_TILE_SHIFT,
+		.tilesX = 180,
+		.tilesY = 91
 	}
 };
 
 
+// Weather grid fields (wind fields first, so that they can be interpolated alone)
+enum
+{
+	WX_FIELD_WIND_U = 0, // m/s
+	WX_FIELD_WIND_V, // m/s
+	WX_FIELD_WIND_GUST, // m/s
+	WX_FIELD_TEMP, // K
+	WX_FIELD_DEWPOINT, // K
+	WX_FIELD_PRESSURE, // Pa
+	WX_FIELD_CLOUD, // %
+	WX_FIELD_VISIBILITY, // m
+	WX_FIELD_PRATE, // kg/m^2/s
+	WX_FIELD_COUNT
+};
+
+typedef struct
+{
+	double interpSign; // applied after spatial interpolation (wind vectors point "from" rather than "to")
+	uint32_t requiredBy; // the PROTEUS_WX_FIELD_* values which need this field to be interpolated
+
+	// Quantized (16-bit) storage: value = qOffset + (q * qStep), for q in [0, 65535]
+	// NOTE: Keep the error bounds documented for proteus_WeatherOptions.quantize in sync.
+	double qOffset;
+	double qStep;
+} WxFieldInfo;
+
+static const WxFieldInfo WX_FIELD_INFO[WX_FIELD_COUNT] = {
+	{ -1.0, PROTEUS_WX_FIELD_WIND | PROTEUS_WX_FIELD_WIND_GUST, -128.0, 1.0 / 256.0 },
+	{ -1.0, PROTEUS_WX_FIELD_WIND | PROTEUS_WX_FIELD_WIND_GUST, -128.0, 1.0 / 256.0 },
+	{ 1.0, PROTEUS_WX_FIELD_WIND_GUST, 0.0, 1.0 / 512.0 },
+	{ 1.0, PROTEUS_WX_FIELD_TEMP, 150.0, 1.0 / 256.0 },
+	{ 1.0, PROTEUS_WX_FIELD_DEWPOINT, 150.0, 1.0 / 256.0 },
+	{ 1.0, PROTEUS_WX_FIELD_PRESSURE, 80000.0, 0.5 },
+	{ 1.0, PROTEUS_WX_FIELD_CLOUD, 0.0, 1.0 / 512.0 },
+	{ 1.0, PROTEUS_WX_FIELD_VISIBILITY, 0.0, 0.5 },
+	{ 1.0, PROTEUS_WX_FIELD_PRATE, 0.0, 0.000001 }
+};
+
+#define WX_QUANTIZED_MAX (65535)
+
+// Fields provided by the legacy query functions, which take a "windOnly" flag
+#define WX_FIELDS_FOR_WIND_ONLY(windOnly) ((windOnly) ? (PROTEUS_WX_FIELD_WIND | PROTEUS_WX_FIELD_WIND_GUST) : PROTEUS_WX_FIELD_ALL)
+
+// Each plane of a grid starts on its own cache line.
+#define WX_PLANE_ALIGNMENT (64)
+
+/**
+ * A weather grid, stored as one plane per field (structure of arrays), followed by
+ * a plane of precipitation condition bits. Queries only touch the planes of the
+ * fields they need, so wind-only queries read 12 of the 37 bytes of each point.
+ *
+ * A quantized grid stores its field values as 16-bit integers instead (see
+ * WxFieldInfo), using 19 bytes per point. Grids are only ever loaded (from CSV
+ * data or snapshots) unquantized, then quantized as a whole.
+ *
+ * All planes are laid out back-to-back in a single allocation, so the data of a
+ * whole grid can be copied or snapshotted at once. That allocation starts with
+ * the WxGrid itself (see WX_GRID_HEADER_SIZE), and is normally a buffer of one
+ * of the grid pools, so that retired grids are recycled for loading new ones.
+ */
 typedef struct
 {
-	float windU; // m/s
-	float windV; // m/s
-	float windGust; // m/s
+	bool quantized;
+	float* planes[WX_FIELD_COUNT]; // if not quantized
+	uint16_t* qplanes[WX_FIELD_COUNT]; // if quantized
+	uint8_t* cond;
 
-	float temp; // K
-	float dewpoint; // K
-	float pressure; // Pa
-	float cloud; // %
-	float visibility; // m
-	float prate; // kg/m^2/s
+	void* data;
+	size_t dataSize;
 
-	uint8_t cond;
-} WxGridPoint;
+	GridPool* pool; // pool of the grid's buffer, or zero if allocated from the heap
+
+	uint64_t contentHash; // hash of the forecast data loaded (see hashWxData()), or zero if not known
+} WxGrid;
+
+// Space for the WxGrid at the start of its allocation (keeping its planes aligned)
+#define WX_GRID_HEADER_SIZE ((sizeof(WxGrid) + WX_PLANE_ALIGNMENT - 1) & ~((size_t) WX_PLANE_ALIGNMENT - 1))
+
+
+// A forecast step: a weather grid, and the time at which its data is valid
+typedef struct
+{
+	WxGrid* grid;
+	time_t validTime;
+} WxStep;
+
+// An immutable set of forecast steps (in order of valid time), published to readers via RCU.
+typedef struct
+{
+	uint64_t seq; // unique to each generation (unlike its address, which may be reused)
+
+	WxGrid* blend; // grid of the forecast steps' data blended for the blend time (if any), for current time queries
+	time_t blendTime;
+
+	int stepCount;
+	WxStep steps[];
+} WxGeneration;
+
+// (Shared by all contexts, so that sequence numbers are unique across them.)
+static uint64_t _wxGenSeq = 0;
+
+// The pair of forecast steps to interpolate between for a point in time
+typedef struct
+{
+	const WxGrid* grid0;
+	const WxGrid* grid1;
+	double tFrac;
+} WxSpan;
+
+
+// Points of the grid cell used to interpolate at a position (see getWxCell()).
+enum
+{
+	WX_CELL_A = 0,
+	WX_CELL_B,
+	WX_CELL_C,
+	WX_CELL_D,
+	WX_CELL_POINTS
+};
+
+// Cell points on both grids (A0, B0, C0, D0, A1, B1, C1, D1), as used by the batch kernels
+#define WX_CELL_CORNERS (2 * WX_CELL_POINTS)
+
+typedef struct
+{
+	int idx[WX_CELL_POINTS];
+	double xFrac;
+	double yFrac;
+} WxCell;
+
+// The cell last walked to along a segment (see walkWxCell())
+typedef struct
+{
+	WxCell cell;
+	int ilon; // integral coordinates of the cell's "A" point on the weather grids
+	int ilat;
+	bool inCell; // false if not in a (stored) cell yet
+} WxCellWalk;
+
+// Mean radius of the Earth, in metres (for distances along segments)
+#define WX_EARTH_RADIUS (6371008.8)
+
+// Evenly spaced samples along a segment, walked from its start to its end (see nextWxSegmentSample())
+typedef struct
+{
+	const proteus_WeatherSegment* seg;
+	int n;
+	int i; // the next sample
+
+	bool timed; // true if sample times follow the speed along the segment
+	double dist; // distance of the last sample from the start, in metres (if timed)
+
+	// Along a track: the longitude (taking the shorter way around) and latitude spanned by each step
+	double stepLon;
+	double stepLat;
+
+	// Along a great circle: the unit vectors of the last two samples, and the angle spanned by each step
+	double v0[3];
+	double v1[3];
+	double stepAngle;
+	double twoCosStep;
+} WxSegmentPath;
+
+
+/**
+ * A weather query cache, holding the cell point values of the last cell queried.
+ *
+ * Values are only valid for the generation, cell and pair of forecast steps
+ * they were loaded for, and are loaded lazily for each field.
+ */
+struct proteus_WeatherCache
+{
+	uint64_t genSeq; // zero if nothing is cached (generation sequence numbers start at one)
+	const WxGrid* grid0;
+	const WxGrid* grid1;
+	int cellIdx; // index of the cell's "A" point
+
+	uint32_t loadedFields; // bit (1 << k) set if values of field k are loaded
+	double v[WX_FIELD_COUNT][WX_CELL_CORNERS]; // (dequantized, if the grids are quantized)
+
+	proteus_WeatherCacheStats stats;
+};
+
+
+// Number of positions interpolated together by proteus_Weather_getBatch().
+#define WX_BATCH_BLOCK_SIZE (8)
+
+typedef void (*WxInterpKernel)(double v[WX_CELL_CORNERS][WX_BATCH_BLOCK_SIZE], const double* xFrac, const double* yFrac, double tFrac, double sign, double* out);
+
+// Selected once (see initWxInterpKernel()), on first use
+static WxInterpKernel _wxInterpKernel = 0;
+static pthread_once_t _wxInterpKernelOnce = PTHREAD_ONCE_INIT;
+
+
+// Watch of a forecast data directory of a context, and the job reloading its data once changed
+typedef struct
+{
+	proteus_WeatherCtx* ctx;
+	int i; // 0 for the "f1" directory, 1 for the "f2" directory
+
+	int watch; // zero if not watching
+	int reloadJob; // zero if not scheduled
+} WxDirWatch;
 
+/**
+ * A weather context: the forecast data loaded from one source, and everything used to
+ * load and update it. Static data (grid configurations, field tables, the interpolation
+ * kernel) and the scheduler and file watcher threads are shared by all contexts.
+ */
+struct proteus_WeatherCtx
+{
+	char* f1Dir;
+	char* f2Dir;
+
+	WxGeneration* gen;
 
-static char* _f1Dir = 0;
-static char* _f2Dir = 0;
+	// Maximum number of forecast steps held in timeline mode (zero otherwise)
+	int timelineSteps;
 
-static WxGridPoint* _wxGrid0 = 0;
-static WxGridPoint* _wxGrid1 = 0;
-static pthread_rwlock_t _wxGridLock;
-static time_t _wxGridPhaseTime = 0;
+	// Serializes the publication of new generations, once initialized.
+	pthread_mutex_t publishLock;
 
-static WxGridConfig* _gridConf = 0;
+	const WxGridConfig* gridConf; // zero if not initialized
 
+	// Configuration of the grid as stored by this context (its window, if initialized with a
+	// region, and its layout), fixed at init
+	WxGridConfig conf;
 
-static void resetWx(bool stopThread);
+	int ingestThreads;
+	bool quantize;
 
-static pthread_t _wxUpdaterThread;
-static void* wxUpdaterMain();
+	// Pools of grid buffers, for unquantized and quantized grids
+	GridPool gridPools[2];
 
-static bool _wxUpdaterThreadStop = false;
-static pthread_mutex_t _wxUpdaterThreadRunLock;
-static pthread_cond_t _wxUpdaterThreadCond;
+	// Pool of buffers of pending precipitation condition bit operations, for parallel ingestion
+	// (see loadWxGridCsv()), not initialized if ingestion is serial
+	GridPool condOpsPool;
 
+	// Scheduler jobs (zero if not scheduled)
+	int updateJob;
+	int blendJob;
+
+	// Seconds between refreshes of the time-blended grid (zero if disabled)
+	int blendInterval;
+
+	// Whether the forecast data directories are watched for changes
+	bool watchFiles;
+
+	// Watches of the "f1" and "f2" forecast data directories
+	WxDirWatch watches[2];
+};
 
-static void updateWxGrid(int grid, const char* wxDataDirPath);
-static int readWxPointF(char* s, float* x, float* y, float* f);
-static int readWxPointI(char* s, float* x, float* y, int* n);
+// The context used by the global API (proteus_Weather_*())
+static proteus_WeatherCtx _defaultCtx = {
+	.publishLock = PTHREAD_MUTEX_INITIALIZER,
+	.ingestThreads = 1,
+	.watches = { { .ctx = &_defaultCtx, .i = 0 }, { .ctx = &_defaultCtx, .i = 1 } }
+};
 
-static void insertWxGridUgrd(WxGridPoint* wxGrid, float lon, float lat, float ugrd);
-static void insertWxGridVgrd(WxGridPoint* wxGrid, float lon, float lat, float vgrd);
-static void insertWxGridGust(WxGridPoint* wxGrid, float lon, float lat, float gust);
-static void insertWxGridTmp(WxGridPoint* wxGrid, float lon, float lat, float tmp);
-static void insertWxGridDpt(WxGridPoint* wxGrid, float lon, float lat, float dpt);
-static void insertWxGridPres(WxGridPoint* wxGrid, float lon, float lat, float pres);
-static void insertWxGridCld(WxGridPoint* wxGrid, float lon, float lat, float cld);
-static void insertWxGridVis(WxGridPoint* wxGrid, float lon, float lat, float vis);
-static void insertWxGridPrate(WxGridPoint* wxGrid, float lon, float lat, float prate);
-static void insertWxGridCond(WxGridPoint* wxGrid, float lon, float lat, int value, uint8_t wxCond);
 
-static int getLonLatIndexForInsert(float lon, float lat);
-static int getXYIndex(int x, int y);
+static void resetWx(proteus_WeatherCtx* ctx);
+
+static time_t wxUpdateJob(void* arg, time_t deadline);
+static time_t getNextWxUpdateTime(time_t t);
+
+static time_t wxBlendJob(void* arg, time_t deadline);
+static void startWxBlendJob(proteus_WeatherCtx* ctx);
+
+static void startWxWatches(proteus_WeatherCtx* ctx);
+static void wxWatchFunc(void* arg, const char* name);
+static time_t wxReloadJob(void* arg, time_t deadline);
+static bool isWxDataComplete(const char* wxDataDirPath);
+static uint64_t hashWxData(const char* wxDataDirPath);
+
+
+static void updateWxGrid(proteus_WeatherCtx* ctx, int grid, const char* wxDataDirPath);
+static WxGrid* loadWxGrid(proteus_WeatherCtx* ctx, const char* wxDataDirPath, const WxGrid* baseGrid);
+static WxGeneration* allocWxGeneration(int stepCount);
+static void publishWxGeneration(proteus_WeatherCtx* ctx, WxGeneration* gen);
+static void refreshWxBlend(proteus_WeatherCtx* ctx);
+static WxGrid* blendWxGrid(proteus_WeatherCtx* ctx, const WxGeneration* gen, time_t t);
+static int initWxGridPools(proteus_WeatherCtx* ctx, bool hugePages);
+static WxGrid* allocWxGrid(GridPool* pools, const WxGridConfig* conf, bool quantized);
+static void setWxGridData(WxGrid* wxGrid, const WxGridConfig* conf, bool quantized, void* data);
+static size_t getWxGridPlaneSize(const WxGridConfig* conf, bool quantized);
+static size_t getWxGridDataSize(const WxGridConfig* conf, bool quantized);
+static void freeWxGrid(WxGrid* wxGrid);
+static WxGrid* quantizeWxGrid(proteus_WeatherCtx* ctx, const WxGrid* wxGrid);
+static void copyWxGridValues(WxGrid* dst, const WxGrid* src, const WxGridConfig* conf);
+static double getWxGridValue(const WxGrid* wxGrid, int field, size_t i);
+static void setWxGridValue(WxGrid* wxGrid, int field, size_t i, double value);
+static void getWxCellValues(const WxGrid* wxGrid, int field, const int* idx, double* v);
+static int loadWxGridSnapshot(WxGrid* wxGrid, const WxGridConfig* conf, const char* wxDataDirPath);
+static int loadWxGridCsv(WxGrid* wxGrid, const WxGridConfig* conf, const char* wxDataDirPath, int threads, GridPool* condOpsPool);
+static void getWxSnapshotInfo(const WxGridConfig* conf, GridSnapshotInfo* info);
+static void copyWxGridWindow(WxGrid* wxGrid, const WxGridConfig* conf, const WxGrid* src, const WxGridConfig* srcConf);
+static const WxGridConfig* getWxFullGridConfig(const WxGridConfig* conf);
+
+static void insertWxGridField(WxGrid* wxGrid, const WxGridConfig* conf, int field, float lon, float lat, float value);
+static void insertWxGridCond(WxGrid* wxGrid, const WxGridConfig* conf, float lon, float lat, int value, uint8_t wxCond);
+
+static bool getWxCell(const WxGridConfig* conf, const proteus_GeoPos* pos, WxCell* cell);
+static void setWxCellFrac(const WxGridConfig* conf, const proteus_GeoPos* pos, int ilon, int ilat, WxCell* cell);
+static bool walkWxCell(const WxGridConfig* conf, const proteus_GeoPos* pos, WxCellWalk* walk);
+static void getWxSpan(const WxGeneration* gen, time_t t, WxSpan* span);
+static int getWxSpanStep(const WxGeneration* gen, time_t t);
+static void setWxSpan(const WxGeneration* gen, int step, double t, WxSpan* span);
+static void getWxCurrentSpan(const WxGeneration* gen, WxSpan* span);
+static bool getWx(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, bool currentTime, time_t t, proteus_Weather* wx, uint32_t fields);
+static size_t getWxBatch(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, bool currentTime, time_t t, proteus_Weather* wx, bool* valid, uint32_t fields);
+static bool initWxSegmentPath(WxSegmentPath* path, const proteus_WeatherSegment* seg, int n);
+static void getWxUnitVector(const proteus_GeoPos* pos, double* v);
+static void nextWxSegmentSample(WxSegmentPath* path, proteus_GeoPos* pos);
+static double interpWxField(const WxSpan* span, const WxCell* cell, int field);
+static double interpWxCorners(const double* v, const WxCell* cell, double tFrac, int field);
+static double interpWxCellPoints(const double* v, const WxCell* cell, int field);
+static void setWx(proteus_Weather* wx, const WxSpan* span, const WxCell* cell, const double* f, uint32_t fields);
+static WxInterpKernel selectWxInterpKernel(void);
+static void initWxInterpKernel(void);
+
+static int getLonLatIndexForInsert(const WxGridConfig* conf, float lon, float lat);
+static int getXYIndex(const WxGridConfig* conf, int x, int y);
+static size_t getGridPoints(const WxGridConfig* conf);
 static bool validLonLat(double lon, double lat);
+static bool validWxRegion(const proteus_WeatherRegion* region);
+static void initWxGridConfig(WxGridConfig* conf, const WxGridConfig* full, const proteus_WeatherRegion* region, bool rowMajor);
+static void setWxRegionConfig(WxGridConfig* conf, const WxGridConfig* full, const proteus_WeatherRegion* region);
+
+
+typedef struct
+{
+	const char* fileName;
+	bool intValues;
+
+	// Set for value fields
+	int field;
+
+	// Set for precipitation condition fields
+	uint8_t cond;
+} WxCsvField;
+
+static const WxCsvField WX_CSV_FIELDS[] = {
+	{ .fileName = "ugrd.csv", .intValues = false, .field = WX_FIELD_WIND_U },
+	{ .fileName = "vgrd.csv", .intValues = false, .field = WX_FIELD_WIND_V },
+	{ .fileName = "gust.csv", .intValues = false, .field = WX_FIELD_WIND_GUST },
+	{ .fileName = "tmp.csv", .intValues = false, .field = WX_FIELD_TEMP },
+	{ .fileName = "dpt.csv", .intValues = false, .field = WX_FIELD_DEWPOINT },
+	{ .fileName = "pres.csv", .intValues = false, .field = WX_FIELD_PRESSURE },
+	{ .fileName = "cld.csv", .intValues = true, .field = WX_FIELD_CLOUD },
+	{ .fileName = "vis.csv", .intValues = false, .field = WX_FIELD_VISIBILITY },
+	{ .fileName = "prate.csv", .intValues = false, .field = WX_FIELD_PRATE },
+	{ .fileName = "rain.csv", .intValues = true, .field = -1, .cond = PROTEUS_WX_COND_RAIN },
+	{ .fileName = "snow.csv", .intValues = true, .field = -1, .cond = PROTEUS_WX_COND_SNOW },
+	{ .fileName = "icep.csv", .intValues = true, .field = -1, .cond = PROTEUS_WX_COND_ICEP },
+	{ .fileName = "frzr.csv", .intValues = true, .field = -1, .cond = PROTEUS_WX_COND_FRZR }
+};
+
+#define WX_CSV_FIELD_COUNT ((int) (sizeof(WX_CSV_FIELDS) / sizeof(WxCsvField)))
+
+// Pending precipitation condition bit operations, used during parallel ingestion
+#define WX_COND_OP_NONE (0)
+#define WX_COND_OP_SET (1)
+#define WX_COND_OP_CLEAR (2)
+
+typedef struct
+{
+	WxGrid* wxGrid;
+	const WxGridConfig* conf;
+	const char* wxDataDirPath;
+
+	uint8_t* condOps[WX_CSV_FIELD_COUNT];
+
+	pthread_mutex_t lock;
+	int nextField;
+	bool failed;
+} WxIngestJob;
 
+static void* wxIngestWorkerMain(void* arg);
+static int loadWxGridCsvField(WxIngestJob* job, int field);
+static int getWxCsvCondFieldCount(void);
+static bool getWxCsvFieldPath(char* filePath, const char* wxDataDirPath, int field);
+
+
+PROTEUS_API void proteus_Weather_getDefaultOptions(proteus_WeatherOptions* opts)
+{
+	memset(opts, 0, sizeof(proteus_WeatherOptions));
+
+	opts->ingestThreads = 1;
+	opts->timelineSteps = 8;
+	opts->blendInterval = 0;
+}
 
 PROTEUS_API int proteus_Weather_init(int sourceDataGrid, const char* f1Dir, const char* f2Dir)
+{
+	return proteus_WeatherCtx_init(&_defaultCtx, sourceDataGrid, f1Dir, f2Dir);
+}
+
+PROTEUS_API int proteus_Weather_initWithOptions(int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherOptions* opts)
+{
+	return proteus_WeatherCtx_initWithOptions(&_defaultCtx, sourceDataGrid, f1Dir, f2Dir, opts);
+}
+
+PROTEUS_API int proteus_Weather_initRegion(int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherRegion* region, const proteus_WeatherOptions* opts)
+{
+	return proteus_WeatherCtx_initRegion(&_defaultCtx, sourceDataGrid, f1Dir, f2Dir, region, opts);
+}
+
+PROTEUS_API int proteus_Weather_initTimeline(int sourceDataGrid, const char* const* dirs, const time_t* validTimes, int n, const proteus_WeatherOptions* opts)
+{
+	return proteus_WeatherCtx_initTimeline(&_defaultCtx, sourceDataGrid, dirs, validTimes, n, opts);
+}
+
+PROTEUS_API int proteus_Weather_addStep(const char* dir, time_t validTime)
+{
+	return proteus_WeatherCtx_addStep(&_defaultCtx, dir, validTime);
+}
+
+PROTEUS_API int proteus_Weather_evictSteps(time_t t)
+{
+	return proteus_WeatherCtx_evictSteps(&_defaultCtx, t);
+}
+
+PROTEUS_API int proteus_Weather_getSteps(time_t* validTimes, int maxSteps)
+{
+	return proteus_WeatherCtx_getSteps(&_defaultCtx, validTimes, maxSteps);
+}
+
+PROTEUS_API time_t proteus_Weather_getBlendTime(void)
+{
+	return proteus_WeatherCtx_getBlendTime(&_defaultCtx);
+}
+
+PROTEUS_API bool proteus_Weather_get(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly)
+{
+	return getWx(&_defaultCtx, pos, true, 0, wx, WX_FIELDS_FOR_WIND_ONLY(windOnly));
+}
+
+PROTEUS_API bool proteus_Weather_getFields(const proteus_GeoPos* pos, proteus_Weather* wx, uint32_t fields)
+{
+	return getWx(&_defaultCtx, pos, true, 0, wx, fields);
+}
+
+PROTEUS_API bool proteus_Weather_getAt(const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields)
+{
+	return getWx(&_defaultCtx, pos, false, t, wx, fields);
+}
+
+PROTEUS_API size_t proteus_Weather_getBatch(const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, bool windOnly)
+{
+	return getWxBatch(&_defaultCtx, pos, n, true, 0, wx, valid, WX_FIELDS_FOR_WIND_ONLY(windOnly));
+}
+
+PROTEUS_API size_t proteus_Weather_getBatchFields(const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, uint32_t fields)
+{
+	return getWxBatch(&_defaultCtx, pos, n, true, 0, wx, valid, fields);
+}
+
+PROTEUS_API size_t proteus_Weather_getBatchAt(const proteus_GeoPos* pos, size_t n, time_t t, proteus_Weather* wx, bool* valid, uint32_t fields)
+{
+	return getWxBatch(&_defaultCtx, pos, n, false, t, wx, valid, fields);
+}
+
+PROTEUS_API bool proteus_Weather_getCached(proteus_WeatherCache* cache, const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields)
+{
+	return proteus_WeatherCtx_getCached(&_defaultCtx, cache, pos, t, wx, fields);
+}
+
+PROTEUS_API int proteus_Weather_sampleSegment(const proteus_WeatherSegment* seg, int n, proteus_GeoPos* pos, proteus_Weather* wx, bool* valid, uint32_t fields)
+{
+	return proteus_WeatherCtx_sampleSegment(&_defaultCtx, seg, n, pos, wx, valid, fields);
+}
+
+
+PROTEUS_API proteus_WeatherCtx* proteus_WeatherCtx_create(void)
+{
+	proteus_WeatherCtx* ctx = calloc(1, sizeof(proteus_WeatherCtx));
+	if (!ctx)
+	{
+		return 0;
+	}
+
+	if (0 != pthread_mutex_init(&ctx->publishLock, 0))
+	{
+		free(ctx);
+		return 0;
+	}
+
+	ctx->ingestThreads = 1;
+
+	for (int i = 0; i < 2; i++)
+	{
+		ctx->watches[i].ctx = ctx;
+		ctx->watches[i].i = i;
+	}
+
+	return ctx;
+}
+
+PROTEUS_API void proteus_WeatherCtx_destroy(proteus_WeatherCtx* ctx)
+{
+	if (!ctx || ctx == &_defaultCtx)
+	{
+		return;
+	}
+
+	resetWx(ctx);
+
+	pthread_mutex_destroy(&ctx->publishLock);
+	free(ctx);
+}
+
+PROTEUS_API proteus_WeatherCtx* proteus_WeatherCtx_getDefault(void)
+{
+	return &_defaultCtx;
+}
+
+PROTEUS_API int proteus_WeatherCtx_init(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* f1Dir, const char* f2Dir)
+{
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+
+	return proteus_WeatherCtx_initWithOptions(ctx, sourceDataGrid, f1Dir, f2Dir, &opts);
+}
+
+PROTEUS_API int proteus_WeatherCtx_initWithOptions(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherOptions* opts)
+{
+	return proteus_WeatherCtx_initRegion(ctx, sourceDataGrid, f1Dir, f2Dir, 0, opts);
+}
+
+PROTEUS_API int proteus_WeatherCtx_initRegion(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* f1Dir, const char* f2Dir, const proteus_WeatherRegion* region, const proteus_WeatherOptions* opts)
 {
 	if (sourceDataGrid < PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00 ||
 			sourceDataGrid > PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25)
@@ -157,40 +702,57 @@ PROTEUS_API int proteus_Weather_init(int sourceDataGrid, const char* f1Dir, cons
 		return -3;
 	}
 
+	if (!opts || opts->ingestThreads < 1 || opts->blendInterval < 0)
+	{
+		return -3;
+	}
+
+	if (region && !validWxRegion(region))
+	{
+		return -3;
+	}
+
 
-	if (_gridConf)
+	if (ctx->gridConf)
 	{
 		// We have an active configuration, so reset before continuing.
-		resetWx(true);
+		resetWx(ctx);
 	}
 
 	int rc;
 
-	_f1Dir = strdup(f1Dir);
-	_f2Dir = strdup(f2Dir);
+	ctx->f1Dir = strdup(f1Dir);
+	ctx->f2Dir = strdup(f2Dir);
 
-	if (0 != pthread_rwlock_init(&_wxGridLock, 0))
+	ctx->gen = allocWxGeneration(WX_PHASE_STEPS);
+	if (!ctx->gen)
 	{
-		ERRLOG("Failed to init rwlock!");
+		ERRLOG("Failed to alloc weather grid generation!");
 		return -4;
 	}
 
-	if (0 != pthread_mutex_init(&_wxUpdaterThreadRunLock, 0))
+	initWxGridConfig(&ctx->conf, &GRID_CONFIG[sourceDataGrid], region, opts->rowMajor);
+	ctx->gridConf = &ctx->conf;
+
+	if (region)
 	{
-		ERRLOG("Failed to init mutex!");
-		return -4;
+		ERRLOG4("Storing a window of %dx%d weather grid points, from grid point (%d, %d).",
+				ctx->conf.storeX, ctx->conf.storeY, ctx->conf.originX, ctx->conf.originY);
 	}
 
-	if (0 != pthread_cond_init(&_wxUpdaterThreadCond, 0))
+	ctx->ingestThreads = opts->ingestThreads;
+	ctx->blendInterval = opts->blendInterval;
+	ctx->quantize = opts->quantize;
+	ctx->watchFiles = opts->watchFiles;
+
+	if (0 != initWxGridPools(ctx, opts->hugePages))
 	{
-		ERRLOG("Failed to init cond!");
-		return -4;
+		rc = -4;
+		goto fail;
 	}
 
-	_gridConf = &GRID_CONFIG[sourceDataGrid];
-
 
-	const time_t curTime = time(0);
+	const time_t curTime = Scheduler_now();
 	struct tm tres;
 	if (&tres != gmtime_r(&curTime, &tres))
 	{
@@ -201,804 +763,2195 @@ PROTEUS_API int proteus_Weather_init(int sourceDataGrid, const char* f1Dir, cons
 	const int hour = tres.tm_hour;
 	const int min = tres.tm_min;
 
+	time_t phaseTime;
+
 	if (((hour + 2) % 6) < 3)
 	{
 		// In this situation, it's expected that the "f2" data would be "older" than the "f1" data,
 		// so just init both grids to the same data for now.
-		updateWxGrid(0, _f1Dir);
-		updateWxGrid(1, _f1Dir);
+		updateWxGrid(ctx, 0, ctx->f1Dir);
+		updateWxGrid(ctx, 1, ctx->f1Dir);
 
 		// Actual phase time doesn't matter when both grids are identical.
-		_wxGridPhaseTime = curTime;
+		phaseTime = curTime;
 	}
 	else
 	{
-		updateWxGrid(0, _f1Dir);
-		updateWxGrid(1, _f2Dir);
+		updateWxGrid(ctx, 0, ctx->f1Dir);
+		updateWxGrid(ctx, 1, ctx->f2Dir);
 
 		// Next phase time at {0115Z, 0715Z, 1315Z, 1915Z} + WX_DATA_PHASE_IN_SECONDS.
-		_wxGridPhaseTime = curTime - (3600 * ((hour - 1) % 3)) - (60 * min) + (60 * 15) + WX_DATA_PHASE_IN_SECONDS;
+		phaseTime = curTime - (3600 * ((hour - 1) % 3)) - (60 * min) + (60 * 15) + WX_DATA_PHASE_IN_SECONDS;
 	}
 
-	if (!_wxGrid0 || !_wxGrid1)
+	// Grid 1 data is fully phased in at the phase time.
+	ctx->gen->steps[0].validTime = phaseTime - WX_DATA_PHASE_IN_SECONDS;
+	ctx->gen->steps[1].validTime = phaseTime;
+
+	if (!ctx->gen->steps[0].grid || !ctx->gen->steps[1].grid)
 	{
 		rc = -1;
 		goto fail;
 	}
 
-	if (0 != pthread_create(&_wxUpdaterThread, 0, &wxUpdaterMain, 0))
+	if ((ctx->updateJob = Scheduler_add(getNextWxUpdateTime(curTime), &wxUpdateJob, ctx, UPDATE_JOB_NAME)) < 0)
 	{
+		ctx->updateJob = 0;
 		rc = -2;
 		goto fail;
 	}
 
-#if defined(_GNU_SOURCE) && defined(__GLIBC__)
-	if (0 != pthread_setname_np(_wxUpdaterThread, UPDATER_THREAD_NAME))
+	ERRLOG2("Weather grid phase time: %lu (%ld seconds from now).", phaseTime, (phaseTime - curTime));
+
+	if (ctx->blendInterval > 0)
 	{
-		ERRLOG1("Couldn't set thread name to %s. Continuing anyway.", UPDATER_THREAD_NAME);
+		startWxBlendJob(ctx);
 	}
-#endif
 
-	ERRLOG2("Weather grid phase time: %lu (%ld seconds from now).", _wxGridPhaseTime, (_wxGridPhaseTime - curTime));
+	if (ctx->watchFiles)
+	{
+		startWxWatches(ctx);
+	}
 
 	return 0;
 
 fail:
 	ERRLOG1("Init failed: rc=%d", rc);
 
-	resetWx(false);
+	resetWx(ctx);
 	return rc;
 }
 
-PROTEUS_API bool proteus_Weather_get(const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly)
+PROTEUS_API int proteus_WeatherCtx_initTimeline(proteus_WeatherCtx* ctx, int sourceDataGrid, const char* const* dirs, const time_t* validTimes, int n, const proteus_WeatherOptions* opts)
 {
-	if (!_gridConf)
+	if (sourceDataGrid < PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00 ||
+			sourceDataGrid > PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25)
 	{
-		return false;
+		return -3;
 	}
 
-	if (!validLonLat(pos->lon, pos->lat))
+	if (!opts || opts->ingestThreads < 1 || opts->timelineSteps < 1 || opts->blendInterval < 0)
 	{
-		return false;
+		return -3;
 	}
 
-	// Integral coordinates on the weather grids (corresponding to the "A" points below)
-	// Values of "ilon" and "ilat" are assumed valid because of lon/lat check above.
-	int ilon = ((int) floor(pos->lon * _gridConf->scale)) + _gridConf->offsetX;
-	int ilat = ((int) floor(pos->lat * _gridConf->scale)) + _gridConf->offsetY;
-
-	// Wraparound at longitude 180
-	if (ilon == _gridConf->gridX)
+	if (n < 0 || n > opts->timelineSteps || (n > 0 && (!dirs || !validTimes)))
 	{
-		ilon = 0;
+		return -3;
 	}
 
-	if (0 != pthread_rwlock_rdlock(&_wxGridLock))
+	for (int i = 0; i < n; i++)
 	{
-		ERRLOG("get: Failed to lock for read!");
-		return false;
+		if (!dirs[i] || strlen(dirs[i]) >= WX_GRID_FILE_PATH_MAXLEN)
+		{
+			return -3;
+		}
 	}
 
-	/**
-	 * From a weather grid, four grid points (A, B, C, D) are chosen for interpolation:
-	 *
-	 * ilat+1 -- C-----------D
-	 *           |           |   ^
-	 *           |           |   |
-	 *           |           |   N
-	 *           |           |     E --->
-	 *   ilat -- A-----------B
-	 *
-	 *           |           |
-	 *           ilon        ilon+1
-	 *
-	 * This is performed on both separate grids (representing separate forecast hours)
-	 * to arrive at eight points, which are then used for the trilinear interpolation
-	 * to compute the final weather data for a given point at the present time.
-	 */
 
-	// Grid points {A,B,C,D}0 from weather grid 0
-	const WxGridPoint* wxGridPtA0 = _wxGrid0 + getXYIndex(ilon, ilat);
-	const WxGridPoint* wxGridPtB0 = _wxGrid0 + getXYIndex(ilon + 1, ilat);
-	const WxGridPoint* wxGridPtC0 = _wxGrid0 + getXYIndex(ilon, ilat + 1);
-	const WxGridPoint* wxGridPtD0 = _wxGrid0 + getXYIndex(ilon + 1, ilat + 1);
+	if (ctx->gridConf)
+	{
+		// We have an active configuration, so reset before continuing.
+		resetWx(ctx);
+	}
 
-	// Grid points {A,B,C,D}1 from weather grid 1
-	const WxGridPoint* wxGridPtA1 = _wxGrid1 + getXYIndex(ilon, ilat);
-	const WxGridPoint* wxGridPtB1 = _wxGrid1 + getXYIndex(ilon + 1, ilat);
-	const WxGridPoint* wxGridPtC1 = _wxGrid1 + getXYIndex(ilon, ilat + 1);
-	const WxGridPoint* wxGridPtD1 = _wxGrid1 + getXYIndex(ilon + 1, ilat + 1);
+	int rc;
 
-	if (ilon == _gridConf->gridX - 1)
+	ctx->gen = allocWxGeneration(0);
+	if (!ctx->gen)
 	{
-		// Just west of the 180 degree line of longitude, so B and D points wrap around to ilon=0.
+		ERRLOG("Failed to alloc weather grid generation!");
+		return -4;
+	}
 
-		wxGridPtA0 = _wxGrid0 + getXYIndex(ilon, ilat);
-		wxGridPtB0 = _wxGrid0 + getXYIndex(0, ilat);
-		wxGridPtC0 = _wxGrid0 + getXYIndex(ilon, ilat + 1);
-		wxGridPtD0 = _wxGrid0 + getXYIndex(0, ilat + 1);
+	initWxGridConfig(&ctx->conf, &GRID_CONFIG[sourceDataGrid], 0, opts->rowMajor);
+	ctx->gridConf = &ctx->conf;
+	ctx->ingestThreads = opts->ingestThreads;
+	ctx->timelineSteps = opts->timelineSteps;
+	ctx->blendInterval = opts->blendInterval;
+	ctx->quantize = opts->quantize;
 
-		wxGridPtA1 = _wxGrid1 + getXYIndex(ilon, ilat);
-		wxGridPtB1 = _wxGrid1 + getXYIndex(0, ilat);
-		wxGridPtC1 = _wxGrid1 + getXYIndex(ilon, ilat + 1);
-		wxGridPtD1 = _wxGrid1 + getXYIndex(0, ilat + 1);
+	if (0 != initWxGridPools(ctx, opts->hugePages))
+	{
+		rc = -4;
+		goto fail;
 	}
 
-	if (ilat == _gridConf->gridY - 1)
+	for (int i = 0; i < n; i++)
 	{
-		// At the north pole, so C and D points are forced to be the same as A and B, respectively.
+		if ((rc = proteus_WeatherCtx_addStep(ctx, dirs[i], validTimes[i])) != 0)
+		{
+			goto fail;
+		}
+	}
 
-		wxGridPtC0 = wxGridPtA0;
-		wxGridPtD0 = wxGridPtB0;
+	ERRLOG2("Initialized weather timeline with %d of up to %d forecast steps.", n, ctx->timelineSteps);
 
-		wxGridPtC1 = wxGridPtA1;
-		wxGridPtD1 = wxGridPtB1;
+	if (ctx->blendInterval > 0)
+	{
+		startWxBlendJob(ctx);
 	}
 
-	const double xFrac = (ilon == 0 && pos->lon == 180.0) ? 0.0 : (pos->lon * _gridConf->scale) - ((double) (ilon - _gridConf->offsetX));
-	const double yFrac = (pos->lat * _gridConf->scale) - ((double) (ilat - _gridConf->offsetY));
+	return 0;
 
-	const long tDiff = _wxGridPhaseTime - time(0);
-	double tFrac = 1.0 - (((double) tDiff) / ((double) WX_DATA_PHASE_IN_SECONDS));
-	if (tFrac < 0.0)
+fail:
+	ERRLOG1("Timeline init failed: rc=%d", rc);
+
+	resetWx(ctx);
+	return rc;
+}
+
+PROTEUS_API int proteus_WeatherCtx_addStep(proteus_WeatherCtx* ctx, const char* dir, time_t validTime)
+{
+	if (!ctx->gridConf || ctx->timelineSteps == 0)
 	{
-		tFrac = 0.0;
+		return -3;
 	}
-	else if (tFrac > 1.0)
+
+	if (!dir || strlen(dir) >= WX_GRID_FILE_PATH_MAXLEN)
 	{
-		tFrac = 1.0;
+		return -3;
+	}
+
+	// Loaded before taking the lock, so that other timeline updates aren't held up while parsing.
+	WxGrid* wxGrid = loadWxGrid(ctx, dir, 0);
+	if (!wxGrid)
+	{
+		ERRLOG1("addStep: Failed to load forecast step from %s!", dir);
+		return -1;
 	}
 
+	pthread_mutex_lock(&ctx->publishLock);
 
-	const double windU0_0 = (wxGridPtA0->windU * (1.0 - xFrac)) + (wxGridPtB0->windU * xFrac);
-	const double windU1_0 = (wxGridPtC0->windU * (1.0 - xFrac)) + (wxGridPtD0->windU * xFrac);
-	const double windV0_0 = (wxGridPtA0->windV * (1.0 - xFrac)) + (wxGridPtB0->windV * xFrac);
-	const double windV1_0 = (wxGridPtC0->windV * (1.0 - xFrac)) + (wxGridPtD0->windV * xFrac);
+	const WxGeneration* oldGen = ctx->gen;
 
-	const double windU_0 = -1.0 * ((windU0_0 * (1.0 - yFrac)) + (windU1_0 * yFrac));
-	const double windV_0 = -1.0 * ((windV0_0 * (1.0 - yFrac)) + (windV1_0 * yFrac));
+	// Position of the new step, which replaces any step with the same valid time.
+	int pos = 0;
+	while (pos < oldGen->stepCount && oldGen->steps[pos].validTime < validTime)
+	{
+		pos++;
+	}
 
-	const double windU0_1 = (wxGridPtA1->windU * (1.0 - xFrac)) + (wxGridPtB1->windU * xFrac);
-	const double windU1_1 = (wxGridPtC1->windU * (1.0 - xFrac)) + (wxGridPtD1->windU * xFrac);
-	const double windV0_1 = (wxGridPtA1->windV * (1.0 - xFrac)) + (wxGridPtB1->windV * xFrac);
-	const double windV1_1 = (wxGridPtC1->windV * (1.0 - xFrac)) + (wxGridPtD1->windV * xFrac);
+	const bool replace = (pos < oldGen->stepCount && oldGen->steps[pos].validTime == validTime);
+	const int count = oldGen->stepCount + (replace ? 0 : 1);
 
-	const double windU_1 = -1.0 * ((windU0_1 * (1.0 - yFrac)) + (windU1_1 * yFrac));
-	const double windV_1 = -1.0 * ((windV0_1 * (1.0 - yFrac)) + (windV1_1 * yFrac));
+	// The oldest steps are evicted to make room.
+	const int evict = ((count > ctx->timelineSteps) ? (count - ctx->timelineSteps) : 0);
+	if (pos < evict)
+	{
+		// The new step would be evicted right away.
+		pthread_mutex_unlock(&ctx->publishLock);
+		freeWxGrid(wxGrid);
+		return -3;
+	}
 
-	const double windU = (windU_0 * (1.0 - tFrac)) + (windU_1 * tFrac);
-	const double windV = (windV_0 * (1.0 - tFrac)) + (windV_1 * tFrac);
+	WxGeneration* gen = allocWxGeneration(count - evict);
+	if (!gen)
+	{
+		ERRLOG("addStep: Alloc failed for generation!");
+		pthread_mutex_unlock(&ctx->publishLock);
+		freeWxGrid(wxGrid);
+		return -4;
+	}
 
-	if (fabs(windV) < PROTEUS_EPSILON)
+	for (int i = evict, k = 0; i < count; i++, k++)
 	{
-		if (windU < -PROTEUS_EPSILON)
+		if (i < pos)
 		{
-			wx->wind.angle = 270.0;
+			gen->steps[k] = oldGen->steps[i];
 		}
-		else if (windU > PROTEUS_EPSILON)
+		else if (i == pos)
 		{
-			wx->wind.angle = 90.0;
+			gen->steps[k].grid = wxGrid;
+			gen->steps[k].validTime = validTime;
 		}
 		else
 		{
-			wx->wind.angle = 0.0;
-		}
-	}
-	else
-	{
-		wx->wind.angle = ScalarConv_rad2deg(atan(windU / windV));
-
-		if (windV < 0.0)
-		{
-			wx->wind.angle += 180.0;
-		}
-		else if (windU < 0.0)
-		{
-			wx->wind.angle += 360.0;
+			gen->steps[k] = oldGen->steps[i - (replace ? 0 : 1)];
 		}
 	}
 
-	wx->wind.mag = sqrt((windU * windU) + (windV * windV));
+	publishWxGeneration(ctx, gen);
 
+	pthread_mutex_unlock(&ctx->publishLock);
 
-	const double wgust0_0 = (wxGridPtA0->windGust * (1.0 - xFrac)) + (wxGridPtB0->windGust * xFrac);
-	const double wgust1_0 = (wxGridPtC0->windGust * (1.0 - xFrac)) + (wxGridPtD0->windGust * xFrac);
-	const double wgust_0 = (wgust0_0 * (1.0 - yFrac)) + (wgust1_0 * yFrac);
+	ERRLOG2("Added weather forecast step valid at %lu (from %s).", validTime, dir);
 
-	const double wgust0_1 = (wxGridPtA1->windGust * (1.0 - xFrac)) + (wxGridPtB1->windGust * xFrac);
-	const double wgust1_1 = (wxGridPtC1->windGust * (1.0 - xFrac)) + (wxGridPtD1->windGust * xFrac);
-	const double wgust_1 = (wgust0_1 * (1.0 - yFrac)) + (wgust1_1 * yFrac);
+	refreshWxBlend(ctx);
 
-	wx->windGust = (wgust_0 * (1.0 - tFrac)) + (wgust_1 * tFrac);
+	return 0;
+}
 
-	// In the unlikely event that the gust speed here is less than the wind vector's magnitude,
-	// set the gust speed to the wind vector magnitude's value.
-	if (wx->windGust < wx->wind.mag)
+PROTEUS_API int proteus_WeatherCtx_evictSteps(proteus_WeatherCtx* ctx, time_t t)
+{
+	if (!ctx->gridConf || ctx->timelineSteps == 0)
 	{
-		wx->windGust = wx->wind.mag;
+		return -3;
 	}
 
+	pthread_mutex_lock(&ctx->publishLock);
+
+	const WxGeneration* oldGen = ctx->gen;
 
-	if (windOnly)
+	// Steps before the last one valid at or before the given time aren't needed for later queries.
+	int evict = 0;
+	while (evict + 1 < oldGen->stepCount && oldGen->steps[evict + 1].validTime <= t)
 	{
-		goto done;
+		evict++;
 	}
 
+	if (evict > 0)
+	{
+		WxGeneration* gen = allocWxGeneration(oldGen->stepCount - evict);
+		if (!gen)
+		{
+			ERRLOG("evictSteps: Alloc failed for generation!");
+			pthread_mutex_unlock(&ctx->publishLock);
+			return -4;
+		}
 
-	const double temp0_0 = (wxGridPtA0->temp * (1.0 - xFrac)) + (wxGridPtB0->temp * xFrac);
-	const double temp1_0 = (wxGridPtC0->temp * (1.0 - xFrac)) + (wxGridPtD0->temp * xFrac);
-	const double temp_0 = (temp0_0 * (1.0 - yFrac)) + (temp1_0 * yFrac);
-
-	const double temp0_1 = (wxGridPtA1->temp * (1.0 - xFrac)) + (wxGridPtB1->temp * xFrac);
-	const double temp1_1 = (wxGridPtC1->temp * (1.0 - xFrac)) + (wxGridPtD1->temp * xFrac);
-	const double temp_1 = (temp0_1 * (1.0 - yFrac)) + (temp1_1 * yFrac);
-
-	wx->temp = (temp_0 * (1.0 - tFrac)) + (temp_1 * tFrac) - 273.15;
-
-
-	const double dewpoint0_0 = (wxGridPtA0->dewpoint * (1.0 - xFrac)) + (wxGridPtB0->dewpoint * xFrac);
-	const double dewpoint1_0 = (wxGridPtC0->dewpoint * (1.0 - xFrac)) + (wxGridPtD0->dewpoint * xFrac);
-	const double dewpoint_0 = (dewpoint0_0 * (1.0 - yFrac)) + (dewpoint1_0 * yFrac);
+		memcpy(gen->steps, oldGen->steps + evict, gen->stepCount * sizeof(WxStep));
 
-	const double dewpoint0_1 = (wxGridPtA1->dewpoint * (1.0 - xFrac)) + (wxGridPtB1->dewpoint * xFrac);
-	const double dewpoint1_1 = (wxGridPtC1->dewpoint * (1.0 - xFrac)) + (wxGridPtD1->dewpoint * xFrac);
-	const double dewpoint_1 = (dewpoint0_1 * (1.0 - yFrac)) + (dewpoint1_1 * yFrac);
+		publishWxGeneration(ctx, gen);
+	}
 
-	wx->dewpoint = (dewpoint_0 * (1.0 - tFrac)) + (dewpoint_1 * tFrac) - 273.15;
+	pthread_mutex_unlock(&ctx->publishLock);
 
+	if (evict > 0)
+	{
+		refreshWxBlend(ctx);
+	}
 
-	const double pressure0_0 = (wxGridPtA0->pressure * (1.0 - xFrac)) + (wxGridPtB0->pressure * xFrac);
-	const double pressure1_0 = (wxGridPtC0->pressure * (1.0 - xFrac)) + (wxGridPtD0->pressure * xFrac);
-	const double pressure_0 = (pressure0_0 * (1.0 - yFrac)) + (pressure1_0 * yFrac);
+	return evict;
+}
 
-	const double pressure0_1 = (wxGridPtA1->pressure * (1.0 - xFrac)) + (wxGridPtB1->pressure * xFrac);
-	const double pressure1_1 = (wxGridPtC1->pressure * (1.0 - xFrac)) + (wxGridPtD1->pressure * xFrac);
-	const double pressure_1 = (pressure0_1 * (1.0 - yFrac)) + (pressure1_1 * yFrac);
+PROTEUS_API int proteus_WeatherCtx_getSteps(proteus_WeatherCtx* ctx, time_t* validTimes, int maxSteps)
+{
+	if (!ctx->gridConf)
+	{
+		return 0;
+	}
 
-	wx->pressure = ((pressure_0 * (1.0 - tFrac)) + (pressure_1 * tFrac)) / 100.0;
+	Rcu_readLock();
+	const WxGeneration* gen = RCU_DEREFERENCE(ctx->gen);
 
+	const int count = gen->stepCount;
+	for (int i = 0; i < count && i < maxSteps; i++)
+	{
+		validTimes[i] = gen->steps[i].validTime;
+	}
 
-	const double cloud0_0 = (wxGridPtA0->cloud * (1.0 - xFrac)) + (wxGridPtB0->cloud * xFrac);
-	const double cloud1_0 = (wxGridPtC0->cloud * (1.0 - xFrac)) + (wxGridPtD0->cloud * xFrac);
-	const double cloud_0 = (cloud0_0 * (1.0 - yFrac)) + (cloud1_0 * yFrac);
+	Rcu_readUnlock();
+	return count;
+}
 
-	const double cloud0_1 = (wxGridPtA1->cloud * (1.0 - xFrac)) + (wxGridPtB1->cloud * xFrac);
-	const double cloud1_1 = (wxGridPtC1->cloud * (1.0 - xFrac)) + (wxGridPtD1->cloud * xFrac);
-	const double cloud_1 = (cloud0_1 * (1.0 - yFrac)) + (cloud1_1 * yFrac);
+PROTEUS_API time_t proteus_WeatherCtx_getBlendTime(proteus_WeatherCtx* ctx)
+{
+	if (!ctx->gridConf)
+	{
+		return 0;
+	}
 
-	wx->cloud = (cloud_0 * (1.0 - tFrac)) + (cloud_1 * tFrac);
+	Rcu_readLock();
+	const WxGeneration* gen = RCU_DEREFERENCE(ctx->gen);
+	const time_t blendTime = (gen->blend ? gen->blendTime : 0);
+	Rcu_readUnlock();
 
+	return blendTime;
+}
 
-	const double visibility0_0 = (wxGridPtA0->visibility * (1.0 - xFrac)) + (wxGridPtB0->visibility * xFrac);
-	const double visibility1_0 = (wxGridPtC0->visibility * (1.0 - xFrac)) + (wxGridPtD0->visibility * xFrac);
-	const double visibility_0 = (visibility0_0 * (1.0 - yFrac)) + (visibility1_0 * yFrac);
+PROTEUS_API bool proteus_WeatherCtx_get(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, proteus_Weather* wx, bool windOnly)
+{
+	return getWx(ctx, pos, true, 0, wx, WX_FIELDS_FOR_WIND_ONLY(windOnly));
+}
 
-	const double visibility0_1 = (wxGridPtA1->visibility * (1.0 - xFrac)) + (wxGridPtB1->visibility * xFrac);
-	const double visibility1_1 = (wxGridPtC1->visibility * (1.0 - xFrac)) + (wxGridPtD1->visibility * xFrac);
-	const double visibility_1 = (visibility0_1 * (1.0 - yFrac)) + (visibility1_1 * yFrac);
+PROTEUS_API bool proteus_WeatherCtx_getFields(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, proteus_Weather* wx, uint32_t fields)
+{
+	return getWx(ctx, pos, true, 0, wx, fields);
+}
 
-	wx->visibility = (visibility_0 * (1.0 - tFrac)) + (visibility_1 * tFrac);
+PROTEUS_API bool proteus_WeatherCtx_getAt(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields)
+{
+	return getWx(ctx, pos, false, t, wx, fields);
+}
 
+PROTEUS_API size_t proteus_WeatherCtx_getBatch(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, bool windOnly)
+{
+	return getWxBatch(ctx, pos, n, true, 0, wx, valid, WX_FIELDS_FOR_WIND_ONLY(windOnly));
+}
 
-	const double prate0_0 = (wxGridPtA0->prate * (1.0 - xFrac)) + (wxGridPtB0->prate * xFrac);
-	const double prate1_0 = (wxGridPtC0->prate * (1.0 - xFrac)) + (wxGridPtD0->prate * xFrac);
-	const double prate_0 = (prate0_0 * (1.0 - yFrac)) + (prate1_0 * yFrac);
+PROTEUS_API size_t proteus_WeatherCtx_getBatchFields(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, proteus_Weather* wx, bool* valid, uint32_t fields)
+{
+	return getWxBatch(ctx, pos, n, true, 0, wx, valid, fields);
+}
 
-	const double prate0_1 = (wxGridPtA1->prate * (1.0 - xFrac)) + (wxGridPtB1->prate * xFrac);
-	const double prate1_1 = (wxGridPtC1->prate * (1.0 - xFrac)) + (wxGridPtD1->prate * xFrac);
-	const double prate_1 = (prate0_1 * (1.0 - yFrac)) + (prate1_1 * yFrac);
+PROTEUS_API size_t proteus_WeatherCtx_getBatchAt(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, time_t t, proteus_Weather* wx, bool* valid, uint32_t fields)
+{
+	return getWxBatch(ctx, pos, n, false, t, wx, valid, fields);
+}
 
-	wx->prate = ((prate_0 * (1.0 - tFrac)) + (prate_1 * tFrac)) * 3600.0;
+// Queries either at the given time, or at the current time (using the time-blended grid, if there is one).
+static bool getWx(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, bool currentTime, time_t t, proteus_Weather* wx, uint32_t fields)
+{
+	if (!ctx->gridConf)
+	{
+		return false;
+	}
 
+	if (!validLonLat(pos->lon, pos->lat))
+	{
+		return false;
+	}
 
-	if (xFrac < 0.5 && yFrac < 0.5)
+	WxCell cell;
+	if (!getWxCell(ctx->gridConf, pos, &cell))
 	{
-		wx->cond = (tFrac < 0.5) ? wxGridPtA0->cond : wxGridPtA1->cond;
+		// Outside of the region loaded
+		return false;
 	}
-	else if (xFrac > 0.5 && yFrac < 0.5)
+
+	Rcu_readLock();
+	const WxGeneration* gen = RCU_DEREFERENCE(ctx->gen);
+
+	if (gen->stepCount == 0)
 	{
-		wx->cond = (tFrac < 0.5) ? wxGridPtB0->cond : wxGridPtB1->cond;
+		// No forecast steps loaded (yet) in timeline mode
+		Rcu_readUnlock();
+		return false;
 	}
-	else if (xFrac < 0.5 && yFrac > 0.5)
+
+	WxSpan span;
+	if (currentTime)
 	{
-		wx->cond = (tFrac < 0.5) ? wxGridPtC0->cond : wxGridPtC1->cond;
+		getWxCurrentSpan(gen, &span);
 	}
 	else
 	{
-		wx->cond = (tFrac < 0.5) ? wxGridPtD0->cond : wxGridPtD1->cond;
+		getWxSpan(gen, t, &span);
 	}
 
+	double f[WX_FIELD_COUNT];
 
-done:
-	if (0 != pthread_rwlock_unlock(&_wxGridLock))
+	for (int k = 0; k < WX_FIELD_COUNT; k++)
 	{
-		ERRLOG("get: Failed to unlock rwlock!");
+		if (fields & WX_FIELD_INFO[k].requiredBy)
+		{
+			f[k] = interpWxField(&span, &cell, k);
+		}
 	}
 
+	setWx(wx, &span, &cell, f, fields);
+
+	Rcu_readUnlock();
 	return true;
 }
 
-
-#define WX_GRID_PARSE_BUF_SIZE (256)
-
-static void updateWxGrid(int grid, const char* wxDataDirPath)
+static size_t getWxBatch(proteus_WeatherCtx* ctx, const proteus_GeoPos* pos, size_t n, bool currentTime, time_t t, proteus_Weather* wx, bool* valid, uint32_t fields)
 {
-	WxGridPoint* wxGrid = malloc(_gridConf->gridX * _gridConf->gridY * sizeof(WxGridPoint));
-	if (!wxGrid)
+	if (!ctx->gridConf)
 	{
-		ERRLOG("updateWxGrid: Alloc failed for wxGrid!");
-		goto fail;
+		goto none;
 	}
 
-	if (grid == -1)
-	{
-		// Updating weather grids, so copy previous grid to start with sane values (in case new values are unavailable for some reason).
-		memcpy(wxGrid, _wxGrid1, _gridConf->gridX * _gridConf->gridY * sizeof(WxGridPoint));
-	}
-	else
-	{
-		// Setting up weather grid for the first time, so initialize the grid to zeros.
-		memset(wxGrid, 0, _gridConf->gridX * _gridConf->gridY * sizeof(WxGridPoint));
-	}
+	pthread_once(&_wxInterpKernelOnce, &initWxInterpKernel);
 
-	FILE* fp;
-	char buf[WX_GRID_PARSE_BUF_SIZE];
-	char filePath[WX_GRID_FILE_PATH_MAXLEN + 64];
+	size_t count = 0;
 
-	float x, y;
-	int n;
-	float f;
+	WxCell cells[WX_BATCH_BLOCK_SIZE];
+	size_t cellPos[WX_BATCH_BLOCK_SIZE];
 
+	double xFrac[WX_BATCH_BLOCK_SIZE];
+	double yFrac[WX_BATCH_BLOCK_SIZE];
+	double v[WX_CELL_CORNERS][WX_BATCH_BLOCK_SIZE];
+	double f[WX_FIELD_COUNT][WX_BATCH_BLOCK_SIZE];
 
-	// ugrd
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "ugrd.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+	// A single generation and point in time are used for the whole batch.
+	Rcu_readLock();
+	const WxGeneration* gen = RCU_DEREFERENCE(ctx->gen);
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
+	if (gen->stepCount == 0)
 	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
-		{
-			goto fail;
-		}
-
-		insertWxGridUgrd(wxGrid, x, y, f);
+		// No forecast steps loaded (yet) in timeline mode
+		Rcu_readUnlock();
+		goto none;
 	}
-	fclose(fp);
 
-	// vgrd
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "vgrd.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
+	WxSpan span;
+	if (currentTime)
 	{
-		goto fail;
+		getWxCurrentSpan(gen, &span);
 	}
-
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
+	else
 	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
-		{
-			goto fail;
-		}
-
-		insertWxGridVgrd(wxGrid, x, y, f);
+		getWxSpan(gen, t, &span);
 	}
-	fclose(fp);
 
-	// gust
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "gust.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
+	for (size_t i = 0; i < n; )
 	{
-		goto fail;
-	}
+		int lanes = 0;
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
+		for (; i < n && lanes < WX_BATCH_BLOCK_SIZE; i++)
 		{
-			goto fail;
+			const bool ok = (validLonLat(pos[i].lon, pos[i].lat) && getWxCell(ctx->gridConf, pos + i, cells + lanes));
+			if (valid)
+			{
+				valid[i] = ok;
+			}
+
+			if (ok)
+			{
+				cellPos[lanes++] = i;
+			}
 		}
 
-		insertWxGridGust(wxGrid, x, y, f);
-	}
-	fclose(fp);
-
-	// tmp
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "tmp.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
-
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
+		if (lanes == 0)
 		{
-			goto fail;
+			continue;
 		}
 
-		insertWxGridTmp(wxGrid, x, y, f);
-	}
-	fclose(fp);
+		// Pad a partial block by repeating its first cell, so that all lanes hold sane values.
+		for (int l = 0; l < WX_BATCH_BLOCK_SIZE; l++)
+		{
+			const WxCell* cell = cells + ((l < lanes) ? l : 0);
+			xFrac[l] = cell->xFrac;
+			yFrac[l] = cell->yFrac;
+		}
 
-	// dpt
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "dpt.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+		for (int k = 0; k < WX_FIELD_COUNT; k++)
+		{
+			if (!(fields & WX_FIELD_INFO[k].requiredBy))
+			{
+				continue;
+			}
+
+			for (int l = 0; l < WX_BATCH_BLOCK_SIZE; l++)
+			{
+				const int* idx = cells[(l < lanes) ? l : 0].idx;
+
+				double lv[WX_CELL_CORNERS];
+				getWxCellValues(span.grid0, k, idx, lv);
+				getWxCellValues(span.grid1, k, idx, lv + WX_CELL_POINTS);
+
+				for (int c = 0; c < WX_CELL_CORNERS; c++)
+				{
+					v[c][l] = lv[c];
+				}
+			}
+
+			_wxInterpKernel(v, xFrac, yFrac, span.tFrac, WX_FIELD_INFO[k].interpSign, f[k]);
+		}
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
+		for (int l = 0; l < lanes; l++)
 		{
-			goto fail;
+			double lf[WX_FIELD_COUNT];
+			for (int k = 0; k < WX_FIELD_COUNT; k++)
+			{
+				if (fields & WX_FIELD_INFO[k].requiredBy)
+				{
+					lf[k] = f[k][l];
+				}
+			}
+
+			setWx(wx + cellPos[l], &span, cells + l, lf, fields);
 		}
 
-		insertWxGridDpt(wxGrid, x, y, f);
+		count += lanes;
 	}
-	fclose(fp);
 
-	// pres
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "pres.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
+	Rcu_readUnlock();
+	return count;
+
+none:
+	if (valid)
 	{
-		goto fail;
+		memset(valid, 0, n * sizeof(bool));
 	}
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
-		{
-			goto fail;
-		}
+	return 0;
+}
 
-		insertWxGridPres(wxGrid, x, y, f);
-	}
-	fclose(fp);
 
-	// cld
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "cld.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
+PROTEUS_API int proteus_WeatherCtx_sampleSegment(proteus_WeatherCtx* ctx, const proteus_WeatherSegment* seg, int n, proteus_GeoPos* pos, proteus_Weather* wx, bool* valid, uint32_t fields)
+{
+	WxSegmentPath path;
+	if (!seg || n < 1 || !wx || !(seg->speed >= 0.0) || !initWxSegmentPath(&path, seg, n))
 	{
-		goto fail;
+		return -3;
 	}
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
+	if (!ctx->gridConf)
 	{
-		if (readWxPointI(buf, &x, &y, &n) != 0)
-		{
-			goto fail;
-		}
-
-		insertWxGridCld(wxGrid, x, y, (float)n);
+		goto none;
 	}
-	fclose(fp);
 
-	// vis
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "vis.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
+	Rcu_readLock();
+	const WxGeneration* gen = RCU_DEREFERENCE(ctx->gen);
+
+	if (gen->stepCount == 0)
 	{
-		goto fail;
+		// No forecast steps loaded (yet) in timeline mode
+		Rcu_readUnlock();
+		goto none;
 	}
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
-		{
-			goto fail;
-		}
+	int count = 0;
 
-		insertWxGridVis(wxGrid, x, y, f);
-	}
-	fclose(fp);
+	// (Samples are reached in order of time, so the pair of steps to interpolate between only ever moves forward.)
+	int step = getWxSpanStep(gen, seg->startTime);
 
-	// prate
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "prate.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+	WxCellWalk walk;
+	walk.inCell = false;
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
+	// Cell point values loaded for the cell walked to, and the pair of steps, of the previous sample
+	double v[WX_FIELD_COUNT][WX_CELL_CORNERS];
+	uint32_t loadedFields = 0;
+	int cellIdx = -1;
+	const WxGrid* grid0 = 0;
+	const WxGrid* grid1 = 0;
+
+	for (int i = 0; i < n; i++)
 	{
-		if (readWxPointF(buf, &x, &y, &f) != 0)
+		proteus_GeoPos p;
+		nextWxSegmentSample(&path, &p);
+
+		if (pos)
 		{
-			goto fail;
+			pos[i] = p;
 		}
 
-		insertWxGridPrate(wxGrid, x, y, f);
-	}
-	fclose(fp);
+		const bool ok = (validLonLat(p.lon, p.lat) && walkWxCell(ctx->gridConf, &p, &walk));
+		if (valid)
+		{
+			valid[i] = ok;
+		}
 
-	// rain
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "rain.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+		if (!ok)
+		{
+			continue;
+		}
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointI(buf, &x, &y, &n) != 0)
+		const double t = ((double) seg->startTime) + (path.timed ? path.dist / seg->speed : 0.0);
+		while (step < gen->stepCount - 2 && gen->steps[step + 1].validTime <= t)
 		{
-			goto fail;
+			step++;
 		}
 
-		insertWxGridCond(wxGrid, x, y, n, PROTEUS_WX_COND_RAIN);
-	}
-	fclose(fp);
+		WxSpan span;
+		setWxSpan(gen, step, t, &span);
 
-	// snow
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "snow.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+		const WxCell* cell = &walk.cell;
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointI(buf, &x, &y, &n) != 0)
+		if (cell->idx[WX_CELL_A] != cellIdx || span.grid0 != grid0 || span.grid1 != grid1)
 		{
-			goto fail;
+			cellIdx = cell->idx[WX_CELL_A];
+			grid0 = span.grid0;
+			grid1 = span.grid1;
+			loadedFields = 0;
 		}
 
-		insertWxGridCond(wxGrid, x, y, n, PROTEUS_WX_COND_SNOW);
-	}
-	fclose(fp);
-
-	// icep
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "icep.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+		double f[WX_FIELD_COUNT];
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointI(buf, &x, &y, &n) != 0)
+		for (int k = 0; k < WX_FIELD_COUNT; k++)
 		{
-			goto fail;
-		}
+			if (!(fields & WX_FIELD_INFO[k].requiredBy))
+			{
+				continue;
+			}
 
-		insertWxGridCond(wxGrid, x, y, n, PROTEUS_WX_COND_ICEP);
-	}
-	fclose(fp);
+			if (!(loadedFields & (1u << k)))
+			{
+				getWxCellValues(grid0, k, cell->idx, v[k]);
+				getWxCellValues(grid1, k, cell->idx, v[k] + WX_CELL_POINTS);
 
-	// frzr
-	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, "frzr.csv");
-	fp = fopen(filePath, "r");
-	if (fp == 0)
-	{
-		goto fail;
-	}
+				loadedFields |= (1u << k);
+			}
 
-	while (fgets(buf, WX_GRID_PARSE_BUF_SIZE, fp) == buf)
-	{
-		if (readWxPointI(buf, &x, &y, &n) != 0)
-		{
-			goto fail;
+			// (As in interpWxField(), a single grid has nothing to interpolate over time.)
+			f[k] = ((grid0 == grid1) ? interpWxCellPoints(v[k], cell, k) : interpWxCorners(v[k], cell, span.tFrac, k));
 		}
 
-		insertWxGridCond(wxGrid, x, y, n, PROTEUS_WX_COND_FRZR);
+		setWx(wx + i, &span, cell, f, fields);
+		count++;
 	}
-	fclose(fp);
 
+	Rcu_readUnlock();
+	return count;
 
-	if (grid != -1)
+none:
+	for (int i = 0; i < n; i++)
 	{
-		if (grid == 0)
+		if (pos)
 		{
-			_wxGrid0 = wxGrid;
-		}
-		else
-		{
-			_wxGrid1 = wxGrid;
+			nextWxSegmentSample(&path, pos + i);
 		}
 
-		ERRLOG2("Initialized weather grid %d (from %s).", grid, wxDataDirPath);
-	}
-	else
-	{
-		if (0 != pthread_rwlock_wrlock(&_wxGridLock))
+		if (valid)
 		{
-			ERRLOG("updateWxGrid: Failed to lock for write!");
-			goto fail;
+			valid[i] = false;
 		}
+	}
 
-		// Update, so free grid 0 data, grid 0 gets grid 1 data, and grid 1 gets latest data.
-		free(_wxGrid0);
-		_wxGrid0 = _wxGrid1;
-		_wxGrid1 = wxGrid;
-
-		_wxGridPhaseTime = time(0) + WX_DATA_PHASE_IN_SECONDS;
+	return 0;
+}
 
-		if (0 != pthread_rwlock_unlock(&_wxGridLock))
-		{
-			ERRLOG("updateWxGrid: Failed to unlock rwlock!");
-		}
+// Returns false if the segment is invalid.
+static bool initWxSegmentPath(WxSegmentPath* path, const proteus_WeatherSegment* seg, int n)
+{
+	const proteus_GeoPos* start = &seg->start;
+	const proteus_GeoPos* end = &seg->end;
 
-		ERRLOG2("Updated weather grids (latest from %s). Grid phase time: %lu", wxDataDirPath, _wxGridPhaseTime);
+	if (!validLonLat(start->lon, start->lat) || !validLonLat(end->lon, end->lat))
+	{
+		return false;
 	}
 
-	return;
+	path->seg = seg;
+	path->n = n;
+	path->i = 0;
 
-fail:
-	ERRLOG("Failed to update WX grid!");
-	free(wxGrid);
-}
+	path->timed = (seg->speed > 0.0);
+	path->dist = 0.0;
 
-static int readWxPointF(char* s, float* x, float* y, float* f)
-{
-	char* t;
-	char* u;
+	const int steps = ((n > 1) ? n - 1 : 1);
 
-	if ((u = strtok_r(s, ",", &t)) == 0)
+	double dLon = end->lon - start->lon;
+	if (dLon > 180.0)
 	{
-		return -1;
+		dLon -= 360.0;
 	}
-	*x = strtof(u, 0);
-
-	if ((u = strtok_r(0, ",", &t)) == 0)
+	else if (dLon <= -180.0)
 	{
-		return -2;
+		dLon += 360.0;
 	}
-	*y = strtof(u, 0);
 
-	if ((u = strtok_r(0, ",", &t)) == 0)
+	path->stepLon = dLon / steps;
+	path->stepLat = (end->lat - start->lat) / steps;
+
+	if (!seg->greatCircle)
 	{
-		return -3;
+		return true;
 	}
-	*f = strtof(u, 0);
 
-	return 0;
-}
+	double a[3];
+	double b[3];
+	getWxUnitVector(start, a);
+	getWxUnitVector(end, b);
 
-static int readWxPointI(char* s, float* x, float* y, int* n)
-{
-	char* t;
-	char* u;
+	const double cx = (a[1] * b[2]) - (a[2] * b[1]);
+	const double cy = (a[2] * b[0]) - (a[0] * b[2]);
+	const double cz = (a[0] * b[1]) - (a[1] * b[0]);
 
-	if ((u = strtok_r(s, ",", &t)) == 0)
-	{
-		return -1;
-	}
-	*x = strtof(u, 0);
+	const double sinAngle = sqrt((cx * cx) + (cy * cy) + (cz * cz));
+	const double angle = atan2(sinAngle, (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]));
 
-	if ((u = strtok_r(0, ",", &t)) == 0)
+	if (sinAngle < PROTEUS_EPSILON && angle > M_PI_2)
 	{
-		return -2;
+		// The great circle between antipodal points isn't defined.
+		return false;
 	}
-	*y = strtof(u, 0);
 
-	if ((u = strtok_r(0, ",", &t)) == 0)
-	{
-		return -3;
-	}
-	*n = strtol(u, 0, 10);
+	path->stepAngle = angle / steps;
+	path->twoCosStep = 2.0 * cos(path->stepAngle);
 
-	return 0;
-}
+	// The second sample, by spherical linear interpolation between the start and end
+	// (or at the start too, if the start and end are practically the same).
+	const double sa = ((sinAngle < PROTEUS_EPSILON) ? 1.0 : sin(angle - path->stepAngle) / sinAngle);
+	const double sb = ((sinAngle < PROTEUS_EPSILON) ? 0.0 : sin(path->stepAngle) / sinAngle);
 
-static void insertWxGridUgrd(WxGridPoint* wxGrid, float lon, float lat, float ugrd)
-{
-	if (validLonLat((double)lon, (double)lat))
+	for (int c = 0; c < 3; c++)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].windU = ugrd;
+		path->v0[c] = a[c];
+		path->v1[c] = (sa * a[c]) + (sb * b[c]);
 	}
+
+	return true;
 }
 
-static void insertWxGridVgrd(WxGridPoint* wxGrid, float lon, float lat, float vgrd)
+static void getWxUnitVector(const proteus_GeoPos* pos, double* v)
 {
-	if (validLonLat((double)lon, (double)lat))
-	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].windV = vgrd;
-	}
+	const double rlon = ScalarConv_deg2rad(pos->lon);
+	const double rlat = ScalarConv_deg2rad(pos->lat);
+
+	v[0] = cos(rlat) * cos(rlon);
+	v[1] = cos(rlat) * sin(rlon);
+	v[2] = sin(rlat);
 }
 
-static void insertWxGridGust(WxGridPoint* wxGrid, float lon, float lat, float gust)
+// Gets the position of the next sample along a segment (and its distance from the start, if timed).
+static void nextWxSegmentSample(WxSegmentPath* path, proteus_GeoPos* pos)
 {
-	if (validLonLat((double)lon, (double)lat))
+	const proteus_WeatherSegment* seg = path->seg;
+	const int i = path->i++;
+
+	if (i == 0)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].windGust = gust;
+		*pos = seg->start;
+		return;
 	}
-}
 
-static void insertWxGridTmp(WxGridPoint* wxGrid, float lon, float lat, float tmp)
+	if (seg->greatCircle)
+	{
+		if (i > 1)
+		{
+			// Each step rotates by the same angle, so v[i] = 2 cos(step) v[i - 1] - v[i - 2] (rather than
+			// interpolating each sample's unit vector from those of the start and end again).
+			for (int c = 0; c < 3; c++)
+			{
+				const double v = (path->twoCosStep * path->v1[c]) - path->v0[c];
+				path->v0[c] = path->v1[c];
+				path->v1[c] = v;
+			}
+		}
+
+		path->dist = i * path->stepAngle * WX_EARTH_RADIUS;
+
+		const double x = path->v1[0];
+		const double y = path->v1[1];
+		const double z = path->v1[2];
+
+		pos->lat = ScalarConv_rad2deg(atan2(z, sqrt((x * x) + (y * y))));
+		pos->lon = ScalarConv_rad2deg(atan2(y, x));
+	}
+	else
+	{
+		if (path->timed)
+		{
+			// Length of the step from the previous sample, with the length of a degree of longitude at its middle
+			const double midLat = seg->start.lat + (path->stepLat * (i - 0.5));
+			const double dx = path->stepLon * cos(ScalarConv_deg2rad(midLat));
+			const double dy = path->stepLat;
+
+			path->dist += WX_EARTH_RADIUS * ScalarConv_deg2rad(sqrt((dx * dx) + (dy * dy)));
+		}
+
+		pos->lat = seg->start.lat + (path->stepLat * i);
+		pos->lon = seg->start.lon + (path->stepLon * i);
+	}
+
+	if (i == path->n - 1)
+	{
+		*pos = seg->end;
+		return;
+	}
+
+	// Longitudes in the range of [-180, 180)
+	if (pos->lon >= 180.0)
+	{
+		pos->lon -= 360.0;
+	}
+	else if (pos->lon < -180.0)
+	{
+		pos->lon += 360.0;
+	}
+}
+
+
+PROTEUS_API proteus_WeatherCache* proteus_Weather_createCache(void)
+{
+	// Zero-initialized, so nothing is cached yet.
+	return calloc(1, sizeof(proteus_WeatherCache));
+}
+
+PROTEUS_API void proteus_Weather_freeCache(proteus_WeatherCache* cache)
+{
+	free(cache);
+}
+
+PROTEUS_API bool proteus_WeatherCtx_getCached(proteus_WeatherCtx* ctx, proteus_WeatherCache* cache, const proteus_GeoPos* pos, time_t t, proteus_Weather* wx, uint32_t fields)
+{
+	if (!ctx->gridConf)
+	{
+		return false;
+	}
+
+	if (!validLonLat(pos->lon, pos->lat))
+	{
+		return false;
+	}
+
+	WxCell cell;
+	if (!getWxCell(ctx->gridConf, pos, &cell))
+	{
+		// Outside of the region loaded
+		return false;
+	}
+
+	Rcu_readLock();
+	const WxGeneration* gen = RCU_DEREFERENCE(ctx->gen);
+
+	if (gen->stepCount == 0)
+	{
+		// No forecast steps loaded (yet) in timeline mode
+		Rcu_readUnlock();
+		return false;
+	}
+
+	WxSpan span;
+	getWxSpan(gen, t, &span);
+
+	if (cache->genSeq == gen->seq &&
+			cache->cellIdx == cell.idx[WX_CELL_A] &&
+			cache->grid0 == span.grid0 &&
+			cache->grid1 == span.grid1)
+	{
+		cache->stats.hits++;
+	}
+	else
+	{
+		cache->genSeq = gen->seq;
+		cache->grid0 = span.grid0;
+		cache->grid1 = span.grid1;
+		cache->cellIdx = cell.idx[WX_CELL_A];
+		cache->loadedFields = 0;
+
+		cache->stats.misses++;
+	}
+
+	double f[WX_FIELD_COUNT];
+
+	for (int k = 0; k < WX_FIELD_COUNT; k++)
+	{
+		if (!(fields & WX_FIELD_INFO[k].requiredBy))
+		{
+			continue;
+		}
+
+		double* v = cache->v[k];
+
+		if (!(cache->loadedFields & (1u << k)))
+		{
+			getWxCellValues(span.grid0, k, cell.idx, v);
+			getWxCellValues(span.grid1, k, cell.idx, v + WX_CELL_POINTS);
+
+			cache->loadedFields |= (1u << k);
+		}
+
+		f[k] = interpWxCorners(v, &cell, span.tFrac, k);
+	}
+
+	setWx(wx, &span, &cell, f, fields);
+
+	Rcu_readUnlock();
+	return true;
+}
+
+PROTEUS_API void proteus_Weather_getCacheStats(const proteus_WeatherCache* cache, proteus_WeatherCacheStats* stats)
+{
+	*stats = cache->stats;
+}
+
+
+PROTEUS_API int proteus_Weather_writeSnapshot(int sourceDataGrid, const char* csvDir, const char* snapshotFile)
+{
+	if (sourceDataGrid < PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00 ||
+			sourceDataGrid > PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25)
+	{
+		return -3;
+	}
+
+	if (!csvDir || !snapshotFile || strlen(csvDir) >= WX_GRID_FILE_PATH_MAXLEN)
+	{
+		return -3;
+	}
+
+	const WxGridConfig* conf = &GRID_CONFIG[sourceDataGrid];
+
+	WxGrid* wxGrid = allocWxGrid(0, conf, false);
+	if (!wxGrid)
+	{
+		ERRLOG("writeSnapshot: Alloc failed for wxGrid!");
+		return -4;
+	}
+
+	// Zero-fill, so that plane padding bytes are deterministic in the snapshot payload.
+	memset(wxGrid->data, 0, wxGrid->dataSize);
+
+	int rc = 0;
+
+	if (loadWxGridCsv(wxGrid, conf, csvDir, 1, 0) != 0)
+	{
+		ERRLOG1("writeSnapshot: Failed to read CSV data from %s!", csvDir);
+		rc = -1;
+		goto done;
+	}
+
+	GridSnapshotInfo info;
+	getWxSnapshotInfo(conf, &info);
+
+	if (GridSnapshot_write(snapshotFile, &info, wxGrid->data, wxGrid->dataSize) != 0)
+	{
+		rc = -2;
+		goto done;
+	}
+
+	ERRLOG2("Wrote weather snapshot %s (from %s).", snapshotFile, csvDir);
+
+done:
+	freeWxGrid(wxGrid);
+	return rc;
+}
+
+
+
+static void updateWxGrid(proteus_WeatherCtx* ctx, int grid, const char* wxDataDirPath)
+{
+	const uint64_t contentHash = (ctx->watchFiles ? hashWxData(wxDataDirPath) : 0);
+
+	if (grid == -1 && contentHash != 0)
+	{
+		for (int i = 0; i < WX_PHASE_STEPS; i++)
+		{
+			if (ctx->gen->steps[i].grid->contentHash == contentHash)
+			{
+				ERRLOG1("Weather data in %s is unchanged, so not updating.", wxDataDirPath);
+				return;
+			}
+		}
+	}
+
+	// When updating weather grids, start from the latest grid's data (in case new values are unavailable for some reason).
+	WxGrid* wxGrid = loadWxGrid(ctx, wxDataDirPath, ((grid == -1) ? ctx->gen->steps[WX_PHASE_STEPS - 1].grid : 0));
+	if (!wxGrid)
+	{
+		goto fail;
+	}
+
+	wxGrid->contentHash = contentHash;
+
+
+	if (grid != -1)
+	{
+		ctx->gen->steps[grid].grid = wxGrid;
+
+		ERRLOG2("Initialized weather grid %d (from %s).", grid, wxDataDirPath);
+	}
+	else
+	{
+		// Update, so grid 0 gets grid 1 data, and grid 1 gets latest data.
+		WxGeneration* gen = allocWxGeneration(WX_PHASE_STEPS);
+		if (!gen)
+		{
+			ERRLOG("updateWxGrid: Alloc failed for generation!");
+			goto fail;
+		}
+
+		const time_t curTime = Scheduler_now();
+
+		pthread_mutex_lock(&ctx->publishLock);
+
+		gen->steps[0].grid = ctx->gen->steps[1].grid;
+		gen->steps[0].validTime = curTime;
+		gen->steps[1].grid = wxGrid;
+		gen->steps[1].validTime = curTime + WX_DATA_PHASE_IN_SECONDS;
+
+		publishWxGeneration(ctx, gen);
+
+		pthread_mutex_unlock(&ctx->publishLock);
+
+		ERRLOG2("Updated weather grids (latest from %s). Grid phase time: %lu", wxDataDirPath, curTime + WX_DATA_PHASE_IN_SECONDS);
+
+		refreshWxBlend(ctx);
+	}
+
+	return;
+
+fail:
+	ERRLOG("Failed to update WX grid!");
+	freeWxGrid(wxGrid);
+}
+
+static WxGrid* loadWxGrid(proteus_WeatherCtx* ctx, const char* wxDataDirPath, const WxGrid* baseGrid)
+{
+	WxGrid* wxGrid = allocWxGrid(ctx->gridPools, ctx->gridConf, false);
+	if (!wxGrid)
+	{
+		ERRLOG("loadWxGrid: Alloc failed for wxGrid!");
+		return 0;
+	}
+
+	const int snapRc = loadWxGridSnapshot(wxGrid, ctx->gridConf, wxDataDirPath);
+	if (snapRc != 0)
+	{
+		if (snapRc != -1)
+		{
+			ERRLOG1("loadWxGrid: Ignoring invalid snapshot in %s and falling back to CSV data.", wxDataDirPath);
+		}
+
+		if (baseGrid)
+		{
+			copyWxGridValues(wxGrid, baseGrid, ctx->gridConf);
+		}
+		else
+		{
+			// Setting up weather grid for the first time, so initialize the grid to zeros.
+			memset(wxGrid->data, 0, wxGrid->dataSize);
+		}
+
+		if (loadWxGridCsv(wxGrid, ctx->gridConf, wxDataDirPath, ctx->ingestThreads, &ctx->condOpsPool) != 0)
+		{
+			freeWxGrid(wxGrid);
+			return 0;
+		}
+	}
+
+	if (ctx->quantize)
+	{
+		WxGrid* qGrid = quantizeWxGrid(ctx, wxGrid);
+		if (!qGrid)
+		{
+			ERRLOG("loadWxGrid: Alloc failed for quantized wxGrid!");
+		}
+
+		freeWxGrid(wxGrid);
+		return qGrid;
+	}
+
+	return wxGrid;
+}
+
+static WxGeneration* allocWxGeneration(int stepCount)
+{
+	WxGeneration* gen = calloc(1, sizeof(WxGeneration) + (stepCount * sizeof(WxStep)));
+	if (gen)
+	{
+		gen->seq = __atomic_add_fetch(&_wxGenSeq, 1, __ATOMIC_RELAXED);
+		gen->stepCount = stepCount;
+	}
+
+	return gen;
+}
+
+static void publishWxGeneration(proteus_WeatherCtx* ctx, WxGeneration* gen)
+{
+	WxGeneration* oldGen = ctx->gen;
+
+	RCU_ASSIGN_POINTER(ctx->gen, gen);
+
+	// Wait for readers that may still be using the old generation, then free the grids it no longer shares with the new one.
+	Rcu_synchronize();
+
+	for (int i = 0; i < oldGen->stepCount; i++)
+	{
+		bool shared = false;
+		for (int k = 0; k < gen->stepCount && !shared; k++)
+		{
+			shared = (gen->steps[k].grid == oldGen->steps[i].grid);
+		}
+
+		if (!shared)
+		{
+			freeWxGrid(oldGen->steps[i].grid);
+		}
+	}
+
+	freeWxGrid(oldGen->blend);
+	free(oldGen);
+}
+
+// Publishes a generation with a time-blended grid for the current time (if enabled).
+static void refreshWxBlend(proteus_WeatherCtx* ctx)
+{
+	if (ctx->blendInterval == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&ctx->publishLock);
+
+	const WxGeneration* oldGen = ctx->gen;
+	if (oldGen->stepCount == 0)
+	{
+		pthread_mutex_unlock(&ctx->publishLock);
+		return;
+	}
+
+	const time_t curTime = Scheduler_now();
+
+	WxGeneration* gen = allocWxGeneration(oldGen->stepCount);
+	WxGrid* blend = (gen ? blendWxGrid(ctx, oldGen, curTime) : 0);
+	if (!blend)
+	{
+		ERRLOG("refreshWxBlend: Alloc failed for time-blended grid!");
+		pthread_mutex_unlock(&ctx->publishLock);
+		free(gen);
+		return;
+	}
+
+	memcpy(gen->steps, oldGen->steps, oldGen->stepCount * sizeof(WxStep));
+	gen->blend = blend;
+	gen->blendTime = curTime;
+
+	publishWxGeneration(ctx, gen);
+
+	pthread_mutex_unlock(&ctx->publishLock);
+}
+
+static WxGrid* blendWxGrid(proteus_WeatherCtx* ctx, const WxGeneration* gen, time_t t)
+{
+	WxGrid* blend = allocWxGrid(ctx->gridPools, ctx->gridConf, ctx->quantize);
+	if (!blend)
+	{
+		return 0;
+	}
+
+	WxSpan span;
+	getWxSpan(gen, t, &span);
+
+	const double tFrac = span.tFrac;
+	const size_t points = getGridPoints(ctx->gridConf);
+
+	// Temporal interpolation first, which (being linear) is equivalent to doing it after spatial interpolation.
+	for (int k = 0; k < WX_FIELD_COUNT; k++)
+	{
+		for (size_t i = 0; i < points; i++)
+		{
+			setWxGridValue(blend, k, i, (getWxGridValue(span.grid0, k, i) * (1.0 - tFrac)) + (getWxGridValue(span.grid1, k, i) * tFrac));
+		}
+	}
+
+	memcpy(blend->cond, ((tFrac < 0.5) ? span.grid0->cond : span.grid1->cond), points * sizeof(uint8_t));
+
+	return blend;
+}
+
+// Sets up the grid pools for the current grid configuration, pre-faulting the buffers
+// needed for steady state updates: in legacy mode, the two forecast points and the load
+// target, otherwise just the load target (plus the live and next time-blended grids).
+// With parallel ingestion, the buffer of pending precipitation condition bit operations
+// of a load is pooled too.
+static int initWxGridPools(proteus_WeatherCtx* ctx, bool hugePages)
+{
+	const int blendGrids = ((ctx->blendInterval > 0) ? 2 : 0);
+	const int grids = ((ctx->timelineSteps == 0) ? (WX_PHASE_STEPS + 1) : 1) + blendGrids;
+
+	if (ctx->ingestThreads > 1)
+	{
+		const size_t condOpsSize = getWxCsvCondFieldCount() * getGridPoints(ctx->gridConf) * sizeof(uint8_t);
+		if (0 != GridPool_init(&ctx->condOpsPool, condOpsSize, 1, false))
+		{
+			return -1;
+		}
+	}
+
+	if (ctx->quantize)
+	{
+		// Grids are loaded unquantized (see loadWxGrid()), one at a time.
+		return ((0 == GridPool_init(&ctx->gridPools[0], WX_GRID_HEADER_SIZE + getWxGridDataSize(ctx->gridConf, false), 1, hugePages) &&
+					0 == GridPool_init(&ctx->gridPools[1], WX_GRID_HEADER_SIZE + getWxGridDataSize(ctx->gridConf, true), grids, hugePages)) ? 0 : -1);
+	}
+
+	return GridPool_init(&ctx->gridPools[0], WX_GRID_HEADER_SIZE + getWxGridDataSize(ctx->gridConf, false), grids, hugePages);
+}
+
+static size_t getWxGridPlaneSize(const WxGridConfig* conf, bool quantized)
+{
+	const size_t valueSize = (quantized ? sizeof(uint16_t) : sizeof(float));
+
+	// Round up plane sizes, so that each plane is aligned.
+	return ((getGridPoints(conf) * valueSize) + WX_PLANE_ALIGNMENT - 1) & ~((size_t) WX_PLANE_ALIGNMENT - 1);
+}
+
+static size_t getWxGridDataSize(const WxGridConfig* conf, bool quantized)
+{
+	const size_t condSize = (getGridPoints(conf) + WX_PLANE_ALIGNMENT - 1) & ~((size_t) WX_PLANE_ALIGNMENT - 1);
+
+	return (WX_FIELD_COUNT * getWxGridPlaneSize(conf, quantized)) + condSize;
+}
+
+// Allocates a grid from a context's pools (see initWxGridPools()), or from the heap if pools is zero.
+static WxGrid* allocWxGrid(GridPool* pools, const WxGridConfig* conf, bool quantized)
+{
+	const size_t dataSize = getWxGridDataSize(conf, quantized);
+
+	// Grids of another configuration (such as when writing snapshots) come from the heap.
+	GridPool* pool = (pools ? &pools[quantized ? 1 : 0] : 0);
+	if (pool && pool->bufSize != WX_GRID_HEADER_SIZE + dataSize)
+	{
+		pool = 0;
+	}
+
+	char* buf = (pool ? GridPool_get(pool) : aligned_alloc(WX_PLANE_ALIGNMENT, WX_GRID_HEADER_SIZE + dataSize));
+	if (!buf)
+	{
+		return 0;
+	}
+
+	WxGrid* wxGrid = (WxGrid*) buf;
+
+	wxGrid->pool = pool;
+	wxGrid->contentHash = 0;
+
+	setWxGridData(wxGrid, conf, quantized, buf + WX_GRID_HEADER_SIZE);
+
+	return wxGrid;
+}
+
+// Points a grid (or a view of grid data, such as a snapshot payload) at its data and planes.
+static void setWxGridData(WxGrid* wxGrid, const WxGridConfig* conf, bool quantized, void* data)
+{
+	const size_t planeSize = getWxGridPlaneSize(conf, quantized);
+
+	wxGrid->data = data;
+	wxGrid->dataSize = getWxGridDataSize(conf, quantized);
+	wxGrid->quantized = quantized;
+
+	for (int k = 0; k < WX_FIELD_COUNT; k++)
+	{
+		void* plane = ((char*) wxGrid->data) + (k * planeSize);
+
+		wxGrid->planes[k] = (quantized ? 0 : (float*) plane);
+		wxGrid->qplanes[k] = (quantized ? (uint16_t*) plane : 0);
+	}
+
+	wxGrid->cond = ((uint8_t*) wxGrid->data) + (WX_FIELD_COUNT * planeSize);
+}
+
+static void freeWxGrid(WxGrid* wxGrid)
+{
+	if (!wxGrid)
+	{
+		return;
+	}
+
+	if (wxGrid->pool)
+	{
+		GridPool_put(wxGrid->pool, wxGrid);
+	}
+	else
+	{
+		free(wxGrid);
+	}
+}
+
+static WxGrid* quantizeWxGrid(proteus_WeatherCtx* ctx, const WxGrid* wxGrid)
+{
+	WxGrid* qGrid = allocWxGrid(ctx->gridPools, ctx->gridConf, true);
+	if (qGrid)
+	{
+		copyWxGridValues(qGrid, wxGrid, ctx->gridConf);
+	}
+
+	return qGrid;
+}
+
+// Copies all values of a grid into another grid of the same size, converting between quantized and unquantized values as needed.
+static void copyWxGridValues(WxGrid* dst, const WxGrid* src, const WxGridConfig* conf)
+{
+	if (dst->quantized == src->quantized)
+	{
+		memcpy(dst->data, src->data, dst->dataSize);
+		return;
+	}
+
+	const size_t points = getGridPoints(conf);
+
+	for (int k = 0; k < WX_FIELD_COUNT; k++)
+	{
+		for (size_t i = 0; i < points; i++)
+		{
+			setWxGridValue(dst, k, i, getWxGridValue(src, k, i));
+		}
+	}
+
+	memcpy(dst->cond, src->cond, points * sizeof(uint8_t));
+}
+
+static double getWxGridValue(const WxGrid* wxGrid, int field, size_t i)
+{
+	if (wxGrid->quantized)
+	{
+		return WX_FIELD_INFO[field].qOffset + (wxGrid->qplanes[field][i] * WX_FIELD_INFO[field].qStep);
+	}
+
+	return wxGrid->planes[field][i];
+}
+
+static void setWxGridValue(WxGrid* wxGrid, int field, size_t i, double value)
+{
+	if (wxGrid->quantized)
+	{
+		// Round to the nearest step, clamping to the range of the quantized values.
+		const double q = floor(((value - WX_FIELD_INFO[field].qOffset) / WX_FIELD_INFO[field].qStep) + 0.5);
+
+		if (!(q > 0.0))
+		{
+			// (Also catches NaN.)
+			wxGrid->qplanes[field][i] = 0;
+		}
+		else if (q > WX_QUANTIZED_MAX)
+		{
+			wxGrid->qplanes[field][i] = WX_QUANTIZED_MAX;
+		}
+		else
+		{
+			wxGrid->qplanes[field][i] = (uint16_t) q;
+		}
+	}
+	else
+	{
+		wxGrid->planes[field][i] = (float) value;
+	}
+}
+
+// Loads the values of a field at the points of a cell (see WX_CELL_POINTS), dequantizing them if needed.
+static void getWxCellValues(const WxGrid* wxGrid, int field, const int* idx, double* v)
+{
+	if (wxGrid->quantized)
+	{
+		const uint16_t* plane = wxGrid->qplanes[field];
+		const double offset = WX_FIELD_INFO[field].qOffset;
+		const double step = WX_FIELD_INFO[field].qStep;
+
+		for (int c = 0; c < WX_CELL_POINTS; c++)
+		{
+			v[c] = offset + (plane[idx[c]] * step);
+		}
+	}
+	else
+	{
+		const float* plane = wxGrid->planes[field];
+
+		for (int c = 0; c < WX_CELL_POINTS; c++)
+		{
+			v[c] = plane[idx[c]];
+		}
+	}
+}
+
+// Parallel ingestion (with threads > 1) takes a buffer of pending precipitation condition bit
+// operations from condOpsPool, which must then be initialized (see initWxGridPools()).
+static int loadWxGridCsv(WxGrid* wxGrid, const WxGridConfig* conf, const char* wxDataDirPath, int threads, GridPool* condOpsPool)
+{
+	WxIngestJob job;
+
+	job.wxGrid = wxGrid;
+	job.conf = conf;
+	job.wxDataDirPath = wxDataDirPath;
+	job.nextField = 0;
+	job.failed = false;
+
+	memset(job.condOps, 0, sizeof(job.condOps));
+
+	if (threads > WX_CSV_FIELD_COUNT)
+	{
+		threads = WX_CSV_FIELD_COUNT;
+	}
+
+	if (threads <= 1 || !condOpsPool)
+	{
+		// Serial ingestion: precipitation condition bits are applied directly to the grid.
+		for (int i = 0; i < WX_CSV_FIELD_COUNT; i++)
+		{
+			if (loadWxGridCsvField(&job, i) != 0)
+			{
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	int rc = 0;
+	int started = 0;
+	pthread_t workers[WX_CSV_FIELD_COUNT];
+
+	// Precipitation condition fields all share the "cond" plane of the grid, so each of them
+	// is parsed into its own plane of pending bit operations, which are merged once all workers are done.
+	const size_t points = getGridPoints(conf);
+	uint8_t* condOpsBuf = GridPool_get(condOpsPool);
+	if (!condOpsBuf)
+	{
+		ERRLOG("loadWxGridCsv: Alloc failed for condOps!");
+		return -1;
+	}
+
+	memset(condOpsBuf, WX_COND_OP_NONE, condOpsPool->bufSize);
+
+	for (int i = 0, k = 0; i < WX_CSV_FIELD_COUNT; i++)
+	{
+		if (WX_CSV_FIELDS[i].cond != 0)
+		{
+			job.condOps[i] = condOpsBuf + (k++ * points);
+		}
+	}
+
+	if (0 != pthread_mutex_init(&job.lock, 0))
+	{
+		ERRLOG("loadWxGridCsv: Failed to init mutex!");
+		rc = -1;
+		goto done;
+	}
+
+	for (; started < threads; started++)
+	{
+		if (0 != pthread_create(&workers[started], 0, &wxIngestWorkerMain, &job))
+		{
+			ERRLOG("loadWxGridCsv: Failed to create ingest worker thread!");
+			break;
+		}
+	}
+
+	if (started == 0)
+	{
+		// Couldn't start any workers, so just do all the work on this thread.
+		wxIngestWorkerMain(&job);
+	}
+
+	for (int i = 0; i < started; i++)
+	{
+		pthread_join(workers[i], 0);
+	}
+
+	pthread_mutex_destroy(&job.lock);
+
+	if (job.failed)
+	{
+		rc = -1;
+		goto done;
+	}
+
+	for (int i = 0; i < WX_CSV_FIELD_COUNT; i++)
+	{
+		const uint8_t* ops = job.condOps[i];
+		if (!ops)
+		{
+			continue;
+		}
+
+		const uint8_t wxCond = WX_CSV_FIELDS[i].cond;
+		for (size_t k = 0; k < points; k++)
+		{
+			if (ops[k] == WX_COND_OP_SET)
+			{
+				wxGrid->cond[k] |= wxCond;
+			}
+			else if (ops[k] == WX_COND_OP_CLEAR)
+			{
+				wxGrid->cond[k] &= ~wxCond;
+			}
+		}
+	}
+
+done:
+	GridPool_put(condOpsPool, condOpsBuf);
+
+	return rc;
+}
+
+static int getWxCsvCondFieldCount(void)
+{
+	int count = 0;
+	for (int i = 0; i < WX_CSV_FIELD_COUNT; i++)
+	{
+		if (WX_CSV_FIELDS[i].cond != 0)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static void* wxIngestWorkerMain(void* arg)
+{
+	WxIngestJob* job = (WxIngestJob*) arg;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&job->lock);
+		const int field = (job->failed ? WX_CSV_FIELD_COUNT : job->nextField++);
+		pthread_mutex_unlock(&job->lock);
+
+		if (field >= WX_CSV_FIELD_COUNT)
+		{
+			break;
+		}
+
+		if (loadWxGridCsvField(job, field) != 0)
+		{
+			pthread_mutex_lock(&job->lock);
+			job->failed = true;
+			pthread_mutex_unlock(&job->lock);
+		}
+	}
+
+	return 0;
+}
+
+static int loadWxGridCsvField(WxIngestJob* job, int field)
+{
+	const WxCsvField* csvField = &WX_CSV_FIELDS[field];
+	uint8_t* condOps = job->condOps[field];
+
+	char filePath[WX_GRID_FILE_PATH_MAXLEN + 64];
+	getWxCsvFieldPath(filePath, job->wxDataDirPath, field);
+
+	RowReader rr;
+	if (RowReader_open(&rr, filePath) != 0)
+	{
+		return -1;
+	}
+
+	float cols[3];
+	int rc;
+
+	while ((rc = RowReader_next(&rr, cols, 3)) == 1)
+	{
+		const float x = cols[0];
+		const float y = cols[1];
+
+		if (csvField->cond == 0)
+		{
+			insertWxGridField(job->wxGrid, job->conf, csvField->field, x, y, (csvField->intValues ? (float) RowParser_toInt(cols[2]) : cols[2]));
+		}
+		else if (condOps)
+		{
+			const int i = (validLonLat((double)x, (double)y) ? getLonLatIndexForInsert(job->conf, x, y) : -1);
+			if (i >= 0)
+			{
+				condOps[i] = (RowParser_toInt(cols[2]) ? WX_COND_OP_SET : WX_COND_OP_CLEAR);
+			}
+		}
+		else
+		{
+			insertWxGridCond(job->wxGrid, job->conf, x, y, RowParser_toInt(cols[2]), csvField->cond);
+		}
+	}
+
+	RowReader_close(&rr);
+
+	return ((rc == 0) ? 0 : -1);
+}
+
+// Gets the path of the CSV file of a field (or of its gzip compressed form, if only that exists).
+// Returns true if either exists (otherwise the path is that of the uncompressed file).
+static bool getWxCsvFieldPath(char* filePath, const char* wxDataDirPath, int field)
+{
+	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, WX_CSV_FIELDS[field].fileName);
+	if (0 == access(filePath, R_OK))
+	{
+		return true;
+	}
+
+	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s.gz", wxDataDirPath, WX_CSV_FIELDS[field].fileName);
+	if (0 == access(filePath, R_OK))
+	{
+		return true;
+	}
+
+	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, WX_CSV_FIELDS[field].fileName);
+	return false;
+}
+
+static int loadWxGridSnapshot(WxGrid* wxGrid, const WxGridConfig* conf, const char* wxDataDirPath)
+{
+	char filePath[WX_GRID_FILE_PATH_MAXLEN + 64];
+	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME);
+
+	// Snapshots always hold the whole grid.
+	const WxGridConfig* full = getWxFullGridConfig(conf);
+
+	GridSnapshotInfo info;
+	getWxSnapshotInfo(full, &info);
+
+	GridSnapshot snap;
+	const int rc = GridSnapshot_map(&snap, filePath, &info);
+	if (rc != 0)
+	{
+		return rc;
+	}
+
+	if (snap.payloadLen != getWxGridDataSize(full, false))
+	{
+		ERRLOG1("Snapshot %s has an unexpected payload size!", filePath);
+		GridSnapshot_unmap(&snap);
+		return -2;
+	}
+
+	if (conf->storeX == full->storeX && conf->storeY == full->storeY && conf->tileShift == full->tileShift)
+	{
+		// The snapshot payload is already in grid layout, so this is the only copy made.
+		memcpy(wxGrid->data, snap.payload, snap.payloadLen);
+	}
+	else
+	{
+		WxGrid view;
+		setWxGridData(&view, full, false, (void*) snap.payload);
+
+		copyWxGridWindow(wxGrid, conf, &view, full);
+	}
+
+	GridSnapshot_unmap(&snap);
+
+	return 0;
+}
+
+// Copies the stored window of a grid from a whole grid (of the same resolution).
+static void copyWxGridWindow(WxGrid* wxGrid, const WxGridConfig* conf, const WxGrid* src, const WxGridConfig* srcConf)
+{
+	for (int y = 0; y < conf->storeY; y++)
+	{
+		for (int x = 0; x < conf->storeX; x++)
+		{
+			const int srcX = (conf->originX + x) % conf->gridX;
+			const int i = getXYIndex(conf, x, y);
+			const int j = getXYIndex(srcConf, srcX, conf->originY + y);
+
+			for (int k = 0; k < WX_FIELD_COUNT; k++)
+			{
+				wxGrid->planes[k][i] = src->planes[k][j];
+			}
+
+			wxGrid->cond[i] = src->cond[j];
+		}
+	}
+}
+
+// Gets the configuration of the whole grid of the same resolution as a (possibly windowed) configuration.
+static const WxGridConfig* getWxFullGridConfig(const WxGridConfig* conf)
+{
+	for (size_t i = 0; i < sizeof(GRID_CONFIG) / sizeof(WxGridConfig); i++)
+	{
+		if (GRID_CONFIG[i].gridX == conf->gridX)
+		{
+			return &GRID_CONFIG[i];
+		}
+	}
+
+	return conf;
+}
+
+static void getWxSnapshotInfo(const WxGridConfig* conf, GridSnapshotInfo* info)
+{
+	info->kind = GRID_SNAPSHOT_KIND_WEATHER;
+	info->version = WX_SNAPSHOT_VERSION;
+	info->gridX = conf->gridX;
+	info->gridY = conf->gridY;
+	info->pointSize = (WX_FIELD_COUNT * sizeof(float)) + sizeof(uint8_t);
+	info->tileShift = conf->tileShift;
+}
+
+static void insertWxGridField(WxGrid* wxGrid, const WxGridConfig* conf, int field, float lon, float lat, float value)
 {
 	if (validLonLat((double)lon, (double)lat))
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].temp = tmp;
+		const int i = getLonLatIndexForInsert(conf, lon, lat);
+		if (i >= 0)
+		{
+			wxGrid->planes[field][i] = value;
+		}
+	}
+}
+
+static void insertWxGridCond(WxGrid* wxGrid, const WxGridConfig* conf, float lon, float lat, int value, uint8_t wxCond)
+{
+	if (!validLonLat((double)lon, (double)lat))
+	{
+		return;
+	}
+
+	const int i = getLonLatIndexForInsert(conf, lon, lat);
+	if (i < 0)
+	{
+		return;
+	}
+
+	if (value)
+	{
+		wxGrid->cond[i] |= wxCond;
+	}
+	else
+	{
+		wxGrid->cond[i] &= ~wxCond;
+	}
+}
+
+// Returns -1 for points outside of the stored window.
+static int getLonLatIndexForInsert(const WxGridConfig* conf, float lon, float lat)
+{
+	int ilon = ((int) roundf(lon * conf->scale)) + conf->offsetX;
+	int ilat = ((int) roundf(lat * conf->scale)) + conf->offsetY;
+
+	// Wraparound at longitude 180
+	if (ilon == conf->gridX)
+	{
+		ilon = 0;
+	}
+
+	int x = ilon - conf->originX;
+	if (x < 0)
+	{
+		x += conf->gridX;
+	}
+
+	const int y = ilat - conf->originY;
+
+	if (x >= conf->storeX || y < 0 || y >= conf->storeY)
+	{
+		return -1;
+	}
+
+	return getXYIndex(conf, x, y);
+}
+
+// Index of a stored point, by its coordinates within the stored window
+static int getXYIndex(const WxGridConfig* conf, int x, int y)
+{
+	const int shift = conf->tileShift;
+	if (shift == 0)
+	{
+		return y * conf->storeX + x;
+	}
+
+	const int mask = (1 << shift) - 1;
+	const int tile = ((y >> shift) * conf->tilesX) + (x >> shift);
+
+	return (tile << (2 * shift)) + ((y & mask) << shift) + (x & mask);
+}
+
+// Number of points stored in each plane of a grid (including any padding of its tiles)
+static size_t getGridPoints(const WxGridConfig* conf)
+{
+	if (conf->tileShift == 0)
+	{
+		return (size_t) conf->storeX * conf->storeY;
+	}
+
+	return ((size_t) conf->tilesX * conf->tilesY) << (2 * conf->tileShift);
+}
+
+// Returns false for positions outside of the stored window.
+static bool getWxCell(const WxGridConfig* conf, const proteus_GeoPos* pos, WxCell* cell)
+{
+	// Integral coordinates on the weather grids (corresponding to the "A" points below)
+	// Values of "ilon" and "ilat" are assumed valid because of lon/lat check done by the caller.
+	int ilon = ((int) floor(pos->lon * conf->scale)) + conf->offsetX;
+	int ilat = ((int) floor(pos->lat * conf->scale)) + conf->offsetY;
+
+	// Wraparound at longitude 180
+	if (ilon == conf->gridX)
+	{
+		ilon = 0;
+	}
+
+	/**
+	 * From a weather grid, four grid points (A, B, C, D) are chosen for interpolation:
+	 *
+	 * ilat+1 -- C-----------D
+	 *           |           |   ^
+	 *           |           |   |
+	 *           |           |   N
+	 *           |           |     E --->
+	 *   ilat -- A-----------B
+	 *
+	 *           |           |
+	 *           ilon        ilon+1
+	 *
+	 * This is performed on both separate grids (representing separate forecast hours)
+	 * to arrive at eight points, which are then used for the trilinear interpolation
+	 * to compute the final weather data for a given point at the present time.
+	 */
+
+	// Coordinates of A within the stored window
+	int x = ilon - conf->originX;
+	if (x < 0)
+	{
+		x += conf->gridX;
+	}
+
+	const int y = ilat - conf->originY;
+
+	// Just west of the 180 degree line of longitude, B and D points wrap around to x=0
+	// (only if all longitudes are stored, otherwise B and D must be within the window).
+	const bool allLon = (conf->storeX == conf->gridX);
+	if (x >= conf->storeX - (allLon ? 0 : 1))
+	{
+		return false;
+	}
+
+	const int xB = ((x == conf->storeX - 1) ? 0 : x + 1);
+
+	// At the north pole, C and D points are forced to be the same as A and B, respectively.
+	const int yC = ((ilat == conf->gridY - 1) ? y : y + 1);
+
+	if (y < 0 || yC >= conf->storeY)
+	{
+		return false;
 	}
+
+	// Grid points {A,B,C,D}, at the same indices on both weather grids
+	cell->idx[WX_CELL_A] = getXYIndex(conf, x, y);
+	cell->idx[WX_CELL_B] = getXYIndex(conf, xB, y);
+	cell->idx[WX_CELL_C] = getXYIndex(conf, x, yC);
+	cell->idx[WX_CELL_D] = getXYIndex(conf, xB, yC);
+
+	setWxCellFrac(conf, pos, ilon, ilat, cell);
+
+	return true;
 }
 
-static void insertWxGridDpt(WxGridPoint* wxGrid, float lon, float lat, float dpt)
+// Sets the position within a cell, of which the "A" point is at (ilon, ilat) on the weather grids.
+static void setWxCellFrac(const WxGridConfig* conf, const proteus_GeoPos* pos, int ilon, int ilat, WxCell* cell)
 {
-	if (validLonLat((double)lon, (double)lat))
+	cell->xFrac = (ilon == 0 && pos->lon == 180.0) ? 0.0 : (pos->lon * conf->scale) - ((double) (ilon - conf->offsetX));
+	cell->yFrac = (pos->lat * conf->scale) - ((double) (ilat - conf->offsetY));
+}
+
+// Gets the cell of a position, as getWxCell() does, but only finds the points of the cell again once the
+// position has moved out of the cell of the previous position walked to (as when walking along a segment).
+static bool walkWxCell(const WxGridConfig* conf, const proteus_GeoPos* pos, WxCellWalk* walk)
+{
+	int ilon = ((int) floor(pos->lon * conf->scale)) + conf->offsetX;
+	const int ilat = ((int) floor(pos->lat * conf->scale)) + conf->offsetY;
+
+	if (ilon == conf->gridX)
+	{
+		ilon = 0;
+	}
+
+	if (walk->inCell && ilon == walk->ilon && ilat == walk->ilat)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].dewpoint = dpt;
+		setWxCellFrac(conf, pos, ilon, ilat, &walk->cell);
+		return true;
 	}
+
+	walk->ilon = ilon;
+	walk->ilat = ilat;
+	walk->inCell = getWxCell(conf, pos, &walk->cell);
+
+	return walk->inCell;
 }
 
-static void insertWxGridPres(WxGridPoint* wxGrid, float lon, float lat, float pres)
+static void getWxSpan(const WxGeneration* gen, time_t t, WxSpan* span)
 {
-	if (validLonLat((double)lon, (double)lat))
+	setWxSpan(gen, getWxSpanStep(gen, t), (double) t, span);
+}
+
+// Returns the first step of the last pair of steps starting at or before the given time (or of the first pair, if none do).
+static int getWxSpanStep(const WxGeneration* gen, time_t t)
+{
+	int lo = 0;
+	int hi = gen->stepCount - 2;
+	while (lo < hi)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].pressure = pres;
+		const int mid = (lo + hi + 1) / 2;
+		if (gen->steps[mid].validTime <= t)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
 	}
+
+	return lo;
 }
 
-static void insertWxGridCld(WxGridPoint* wxGrid, float lon, float lat, float cld)
+// Sets the span of the pair of steps starting with the given one, for a point in time (possibly between whole seconds).
+static void setWxSpan(const WxGeneration* gen, int step, double t, WxSpan* span)
 {
-	if (validLonLat((double)lon, (double)lat))
+	if (gen->stepCount == 1)
+	{
+		span->grid0 = gen->steps[0].grid;
+		span->grid1 = gen->steps[0].grid;
+		span->tFrac = 0.0;
+		return;
+	}
+
+	const WxStep* step0 = gen->steps + step;
+	const WxStep* step1 = step0 + 1;
+
+	// Clamped for times outside of the range of the forecast steps
+	const double tDiff = ((double) step1->validTime) - t;
+	double tFrac = 1.0 - (tDiff / ((double) (step1->validTime - step0->validTime)));
+	if (tFrac < 0.0)
+	{
+		tFrac = 0.0;
+	}
+	else if (tFrac > 1.0)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].cloud = cld;
+		tFrac = 1.0;
 	}
+
+	span->grid0 = step0->grid;
+	span->grid1 = step1->grid;
+	span->tFrac = tFrac;
 }
 
-static void insertWxGridVis(WxGridPoint* wxGrid, float lon, float lat, float vis)
+static void getWxCurrentSpan(const WxGeneration* gen, WxSpan* span)
 {
-	if (validLonLat((double)lon, (double)lat))
+	if (gen->blend)
+	{
+		span->grid0 = gen->blend;
+		span->grid1 = gen->blend;
+		span->tFrac = 0.0;
+	}
+	else
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].visibility = vis;
+		getWxSpan(gen, time(0), span);
 	}
 }
 
-static void insertWxGridPrate(WxGridPoint* wxGrid, float lon, float lat, float prate)
+static double interpWxField(const WxSpan* span, const WxCell* cell, int field)
 {
-	if (validLonLat((double)lon, (double)lat))
+	double v[WX_CELL_CORNERS];
+
+	getWxCellValues(span->grid0, field, cell->idx, v);
+
+	if (span->grid0 == span->grid1)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].prate = prate;
+		// A single grid (such as the time-blended grid), so there's nothing to interpolate over time.
+		return interpWxCellPoints(v, cell, field);
 	}
+
+	getWxCellValues(span->grid1, field, cell->idx, v + WX_CELL_POINTS);
+
+	return interpWxCorners(v, cell, span->tFrac, field);
 }
 
-static void insertWxGridCond(WxGridPoint* wxGrid, float lon, float lat, int value, uint8_t wxCond)
+// Interpolates over time between cell point values already loaded from both grids (see WX_CELL_CORNERS).
+static double interpWxCorners(const double* v, const WxCell* cell, double tFrac, int field)
 {
-	if (!validLonLat((double)lon, (double)lat))
+	const double v_0 = interpWxCellPoints(v, cell, field);
+	const double v_1 = interpWxCellPoints(v + WX_CELL_POINTS, cell, field);
+
+	return (v_0 * (1.0 - tFrac)) + (v_1 * tFrac);
+}
+
+// Interpolates spatially between the point values of a cell in a single grid.
+static double interpWxCellPoints(const double* v, const WxCell* cell, int field)
+{
+	const double xFrac = cell->xFrac;
+	const double yFrac = cell->yFrac;
+
+	const double v0 = (v[WX_CELL_A] * (1.0 - xFrac)) + (v[WX_CELL_B] * xFrac);
+	const double v1 = (v[WX_CELL_C] * (1.0 - xFrac)) + (v[WX_CELL_D] * xFrac);
+
+	return WX_FIELD_INFO[field].interpSign * ((v0 * (1.0 - yFrac)) + (v1 * yFrac));
+}
+
+static void setWx(proteus_Weather* wx, const WxSpan* span, const WxCell* cell, const double* f, uint32_t fields)
+{
+	if (fields & (PROTEUS_WX_FIELD_WIND | PROTEUS_WX_FIELD_WIND_GUST))
+	{
+		const double windU = f[WX_FIELD_WIND_U];
+		const double windV = f[WX_FIELD_WIND_V];
+		const double windMag = sqrt((windU * windU) + (windV * windV));
+
+		if (fields & PROTEUS_WX_FIELD_WIND)
+		{
+			if (fabs(windV) < PROTEUS_EPSILON)
+			{
+				if (windU < -PROTEUS_EPSILON)
+				{
+					wx->wind.angle = 270.0;
+				}
+				else if (windU > PROTEUS_EPSILON)
+				{
+					wx->wind.angle = 90.0;
+				}
+				else
+				{
+					wx->wind.angle = 0.0;
+				}
+			}
+			else
+			{
+				wx->wind.angle = ScalarConv_rad2deg(atan(windU / windV));
+
+				if (windV < 0.0)
+				{
+					wx->wind.angle += 180.0;
+				}
+				else if (windU < 0.0)
+				{
+					wx->wind.angle += 360.0;
+				}
+			}
+
+			wx->wind.mag = windMag;
+		}
+
+		if (fields & PROTEUS_WX_FIELD_WIND_GUST)
+		{
+			wx->windGust = f[WX_FIELD_WIND_GUST];
+
+			// In the unlikely event that the gust speed here is less than the wind vector's magnitude,
+			// set the gust speed to the wind vector magnitude's value.
+			if (wx->windGust < windMag)
+			{
+				wx->windGust = windMag;
+			}
+		}
+	}
+
+
+	if (fields & PROTEUS_WX_FIELD_TEMP)
+	{
+		wx->temp = f[WX_FIELD_TEMP] - 273.15;
+	}
+
+	if (fields & PROTEUS_WX_FIELD_DEWPOINT)
+	{
+		wx->dewpoint = f[WX_FIELD_DEWPOINT] - 273.15;
+	}
+
+	if (fields & PROTEUS_WX_FIELD_PRESSURE)
+	{
+		wx->pressure = f[WX_FIELD_PRESSURE] / 100.0;
+	}
+
+	if (fields & PROTEUS_WX_FIELD_CLOUD)
+	{
+		wx->cloud = f[WX_FIELD_CLOUD];
+	}
+
+	if (fields & PROTEUS_WX_FIELD_VISIBILITY)
+	{
+		wx->visibility = f[WX_FIELD_VISIBILITY];
+	}
+
+	if (fields & PROTEUS_WX_FIELD_PRATE)
+	{
+		wx->prate = f[WX_FIELD_PRATE] * 3600.0;
+	}
+
+
+	if (!(fields & PROTEUS_WX_FIELD_COND))
 	{
 		return;
 	}
 
-	if (value)
+	const double xFrac = cell->xFrac;
+	const double yFrac = cell->yFrac;
+	const uint8_t* cond = ((span->tFrac < 0.5) ? span->grid0->cond : span->grid1->cond);
+
+	if (xFrac < 0.5 && yFrac < 0.5)
+	{
+		wx->cond = cond[cell->idx[WX_CELL_A]];
+	}
+	else if (xFrac > 0.5 && yFrac < 0.5)
+	{
+		wx->cond = cond[cell->idx[WX_CELL_B]];
+	}
+	else if (xFrac < 0.5 && yFrac > 0.5)
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].cond |= wxCond;
+		wx->cond = cond[cell->idx[WX_CELL_C]];
 	}
 	else
 	{
-		wxGrid[getLonLatIndexForInsert(lon, lat)].cond &= ~wxCond;
+		wx->cond = cond[cell->idx[WX_CELL_D]];
 	}
 }
 
-static int getLonLatIndexForInsert(float lon, float lat)
+
+/**
+ * Batch interpolation kernels
+ *
+ * Each kernel interpolates one field at WX_BATCH_BLOCK_SIZE positions, using
+ * exactly the operations of interpWxField(), in the same order, so that results
+ * are bit-identical to those of the scalar path.
+ */
+
+#if !defined(__SSE2__)
+static void interpWxBlockScalar(double v[WX_CELL_CORNERS][WX_BATCH_BLOCK_SIZE], const double* xFrac, const double* yFrac, double tFrac, double sign, double* out)
 {
-	int ilon = ((int) roundf(lon * _gridConf->scale)) + _gridConf->offsetX;
-	int ilat = ((int) roundf(lat * _gridConf->scale)) + _gridConf->offsetY;
+	for (int l = 0; l < WX_BATCH_BLOCK_SIZE; l++)
+	{
+		const double v0_0 = (v[WX_CELL_A][l] * (1.0 - xFrac[l])) + (v[WX_CELL_B][l] * xFrac[l]);
+		const double v1_0 = (v[WX_CELL_C][l] * (1.0 - xFrac[l])) + (v[WX_CELL_D][l] * xFrac[l]);
+		const double v_0 = sign * ((v0_0 * (1.0 - yFrac[l])) + (v1_0 * yFrac[l]));
 
-	// Wraparound at longitude 180
-	if (ilon == _gridConf->gridX)
+		const double v0_1 = (v[WX_CELL_POINTS + WX_CELL_A][l] * (1.0 - xFrac[l])) + (v[WX_CELL_POINTS + WX_CELL_B][l] * xFrac[l]);
+		const double v1_1 = (v[WX_CELL_POINTS + WX_CELL_C][l] * (1.0 - xFrac[l])) + (v[WX_CELL_POINTS + WX_CELL_D][l] * xFrac[l]);
+		const double v_1 = sign * ((v0_1 * (1.0 - yFrac[l])) + (v1_1 * yFrac[l]));
+
+		out[l] = (v_0 * (1.0 - tFrac)) + (v_1 * tFrac);
+	}
+}
+#endif // !defined(__SSE2__)
+
+#if defined(__SSE2__)
+#define WX_LERP_PD(a, b, w1, w) _mm_add_pd(_mm_mul_pd((a), (w1)), _mm_mul_pd((b), (w)))
+
+static void interpWxBlockSse2(double v[WX_CELL_CORNERS][WX_BATCH_BLOCK_SIZE], const double* xFrac, const double* yFrac, double tFrac, double sign, double* out)
+{
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d s = _mm_set1_pd(sign);
+	const __m128d t = _mm_set1_pd(tFrac);
+	const __m128d t1 = _mm_sub_pd(one, t);
+
+	for (int l = 0; l < WX_BATCH_BLOCK_SIZE; l += 2)
 	{
-		ilon = 0;
+		const __m128d x = _mm_loadu_pd(xFrac + l);
+		const __m128d x1 = _mm_sub_pd(one, x);
+		const __m128d y = _mm_loadu_pd(yFrac + l);
+		const __m128d y1 = _mm_sub_pd(one, y);
+
+		const __m128d v0_0 = WX_LERP_PD(_mm_loadu_pd(v[WX_CELL_A] + l), _mm_loadu_pd(v[WX_CELL_B] + l), x1, x);
+		const __m128d v1_0 = WX_LERP_PD(_mm_loadu_pd(v[WX_CELL_C] + l), _mm_loadu_pd(v[WX_CELL_D] + l), x1, x);
+		const __m128d v_0 = _mm_mul_pd(s, WX_LERP_PD(v0_0, v1_0, y1, y));
+
+		const __m128d v0_1 = WX_LERP_PD(_mm_loadu_pd(v[WX_CELL_POINTS + WX_CELL_A] + l), _mm_loadu_pd(v[WX_CELL_POINTS + WX_CELL_B] + l), x1, x);
+		const __m128d v1_1 = WX_LERP_PD(_mm_loadu_pd(v[WX_CELL_POINTS + WX_CELL_C] + l), _mm_loadu_pd(v[WX_CELL_POINTS + WX_CELL_D] + l), x1, x);
+		const __m128d v_1 = _mm_mul_pd(s, WX_LERP_PD(v0_1, v1_1, y1, y));
+
+		_mm_storeu_pd(out + l, WX_LERP_PD(v_0, v_1, t1, t));
+	}
+}
+#endif // defined(__SSE2__)
+
+#if defined(WX_HAVE_AVX_KERNEL)
+#define WX_LERP_PD256(a, b, w1, w) _mm256_add_pd(_mm256_mul_pd((a), (w1)), _mm256_mul_pd((b), (w)))
+
+__attribute__((target("avx2")))
+static void interpWxBlockAvx2(double v[WX_CELL_CORNERS][WX_BATCH_BLOCK_SIZE], const double* xFrac, const double* yFrac, double tFrac, double sign, double* out)
+{
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d s = _mm256_set1_pd(sign);
+	const __m256d t = _mm256_set1_pd(tFrac);
+	const __m256d t1 = _mm256_sub_pd(one, t);
+
+	for (int l = 0; l < WX_BATCH_BLOCK_SIZE; l += 4)
+	{
+		const __m256d x = _mm256_loadu_pd(xFrac + l);
+		const __m256d x1 = _mm256_sub_pd(one, x);
+		const __m256d y = _mm256_loadu_pd(yFrac + l);
+		const __m256d y1 = _mm256_sub_pd(one, y);
+
+		const __m256d v0_0 = WX_LERP_PD256(_mm256_loadu_pd(v[WX_CELL_A] + l), _mm256_loadu_pd(v[WX_CELL_B] + l), x1, x);
+		const __m256d v1_0 = WX_LERP_PD256(_mm256_loadu_pd(v[WX_CELL_C] + l), _mm256_loadu_pd(v[WX_CELL_D] + l), x1, x);
+		const __m256d v_0 = _mm256_mul_pd(s, WX_LERP_PD256(v0_0, v1_0, y1, y));
+
+		const __m256d v0_1 = WX_LERP_PD256(_mm256_loadu_pd(v[WX_CELL_POINTS + WX_CELL_A] + l), _mm256_loadu_pd(v[WX_CELL_POINTS + WX_CELL_B] + l), x1, x);
+		const __m256d v1_1 = WX_LERP_PD256(_mm256_loadu_pd(v[WX_CELL_POINTS + WX_CELL_C] + l), _mm256_loadu_pd(v[WX_CELL_POINTS + WX_CELL_D] + l), x1, x);
+		const __m256d v_1 = _mm256_mul_pd(s, WX_LERP_PD256(v0_1, v1_1, y1, y));
+
+		_mm256_storeu_pd(out + l, WX_LERP_PD256(v_0, v_1, t1, t));
+	}
+}
+#endif // defined(WX_HAVE_AVX_KERNEL)
+
+static WxInterpKernel selectWxInterpKernel(void)
+{
+#if defined(WX_HAVE_AVX_KERNEL)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return &interpWxBlockAvx2;
 	}
+#endif
 
-	return getXYIndex(ilon, ilat);
+#if defined(__SSE2__)
+	return &interpWxBlockSse2;
+#else
+	return &interpWxBlockScalar;
+#endif
 }
 
-static int getXYIndex(int x, int y)
+static void initWxInterpKernel(void)
 {
-	return y * _gridConf->gridX + x;
+	_wxInterpKernel = selectWxInterpKernel();
 }
 
 static bool validLonLat(double lon, double lat)
@@ -1006,123 +2959,283 @@ static bool validLonLat(double lon, double lat)
 	return (lon >= -180.0 && lon <= 180.0 && lat >= -90.0 && lat <= 90.0);
 }
 
+static bool validWxRegion(const proteus_WeatherRegion* region)
+{
+	return (validLonLat(region->west, region->south) &&
+			validLonLat(region->east, region->north) &&
+			region->south <= region->north &&
+			region->margin >= 0.0 && region->margin <= 180.0);
+}
+
+// Sets up the configuration of a grid as stored by a context, covering a region (if any) and
+// stored row by row (if rowMajor) or in the layout of the whole grid.
+static void initWxGridConfig(WxGridConfig* conf, const WxGridConfig* full, const proteus_WeatherRegion* region, bool rowMajor)
+{
+	if (region)
+	{
+		setWxRegionConfig(conf, full, region);
+	}
+	else
+	{
+		*conf = *full;
+	}
+
+	if (rowMajor)
+	{
+		conf->tileShift = 0;
+		conf->tilesX = 0;
+		conf->tilesY = 0;
+	}
+}
 
-static void resetWx(bool stopThread)
+// Sets up the configuration of the window of a grid covering a region (and its margin).
+static void setWxRegionConfig(WxGridConfig* conf, const WxGridConfig* full, const proteus_WeatherRegion* region)
 {
-	if (stopThread)
+	*conf = *full;
+
+	const double s = full->scale;
+
+	// Longitude span of the region, eastward from its west edge (across longitude 180, if need be)
+	double width = region->east - region->west;
+	if (width < 0.0)
 	{
-		pthread_mutex_lock(&_wxUpdaterThreadRunLock);
-		_wxUpdaterThreadStop = true;
-		pthread_cond_signal(&_wxUpdaterThreadCond);
-		pthread_mutex_unlock(&_wxUpdaterThreadRunLock);
+		width += 360.0;
+	}
 
-		pthread_join(_wxUpdaterThread, 0);
+	const double west = region->west - region->margin;
+	width += 2.0 * region->margin;
+
+	// Grid points spanned by the region, plus those just east and north of it (for the
+	// B, C and D points of the cells along its edges).
+	const int x0 = (int) floor(west * s);
+	const int x1 = ((int) floor((west + width) * s)) + 1;
+
+	if (x1 - x0 + 1 >= full->gridX)
+	{
+		conf->originX = 0;
+		conf->storeX = full->gridX;
+	}
+	else
+	{
+		conf->originX = (((x0 + full->offsetX) % full->gridX) + full->gridX) % full->gridX;
+		conf->storeX = x1 - x0 + 1;
 	}
 
-	pthread_rwlock_destroy(&_wxGridLock);
+	int y0 = ((int) floor((region->south - region->margin) * s)) + full->offsetY;
+	int y1 = ((int) floor((region->north + region->margin) * s)) + 1 + full->offsetY;
+
+	y0 = ((y0 < 0) ? 0 : y0);
+	y1 = ((y1 > full->gridY - 1) ? full->gridY - 1 : y1);
+
+	conf->originY = y0;
+	conf->storeY = y1 - y0 + 1;
 
-	pthread_mutex_destroy(&_wxUpdaterThreadRunLock);
-	pthread_cond_destroy(&_wxUpdaterThreadCond);
+	if (conf->tileShift != 0)
+	{
+		const int mask = (1 << conf->tileShift) - 1;
+
+		conf->tilesX = (conf->storeX + mask) >> conf->tileShift;
+		conf->tilesY = (conf->storeY + mask) >> conf->tileShift;
+	}
+}
 
-	_wxUpdaterThreadStop = false;
 
-	if (_f1Dir)
+static void resetWx(proteus_WeatherCtx* ctx)
+{
+	// (Waits for the watch functions and jobs, if they're running. Watches go first, as they schedule reload jobs.)
+	for (int i = 0; i < 2; i++)
 	{
-		free(_f1Dir);
-		_f1Dir = 0;
+		FileWatch_remove(ctx->watches[i].watch);
+		Scheduler_cancel(ctx->watches[i].reloadJob);
+
+		ctx->watches[i].watch = 0;
+		ctx->watches[i].reloadJob = 0;
 	}
 
-	if (_f2Dir)
+	Scheduler_cancel(ctx->blendJob);
+	Scheduler_cancel(ctx->updateJob);
+
+	ctx->blendJob = 0;
+	ctx->updateJob = 0;
+
+	if (ctx->f1Dir)
 	{
-		free(_f2Dir);
-		_f2Dir = 0;
+		free(ctx->f1Dir);
+		ctx->f1Dir = 0;
 	}
 
-	if (_wxGrid0)
+	if (ctx->f2Dir)
 	{
-		free(_wxGrid0);
-		_wxGrid0 = 0;
+		free(ctx->f2Dir);
+		ctx->f2Dir = 0;
 	}
 
-	if (_wxGrid1)
+	if (ctx->gen)
 	{
-		free(_wxGrid1);
-		_wxGrid1 = 0;
+		for (int i = 0; i < ctx->gen->stepCount; i++)
+		{
+			freeWxGrid(ctx->gen->steps[i].grid);
+		}
+
+		freeWxGrid(ctx->gen->blend);
+		free(ctx->gen);
+		ctx->gen = 0;
 	}
 
-	_gridConf = 0;
+	GridPool_destroy(&ctx->gridPools[0]);
+	GridPool_destroy(&ctx->gridPools[1]);
+	GridPool_destroy(&ctx->condOpsPool);
+
+	ctx->gridConf = 0;
+	ctx->ingestThreads = 1;
+	ctx->timelineSteps = 0;
+	ctx->blendInterval = 0;
+	ctx->quantize = false;
+	ctx->watchFiles = false;
 }
 
-static void* wxUpdaterMain()
+// Updates the weather grids (when not in timeline mode).
+static time_t wxUpdateJob(void* arg, time_t deadline)
 {
-	bool update = false;
+	proteus_WeatherCtx* ctx = (proteus_WeatherCtx*) arg;
 
-	for (;;)
+	// Updates at 04Z, 10Z, 16Z and 22Z (+15 minutes) use the "f1" data, and the others the "f2" data.
+	const int hour = (int) ((deadline % (24 * 3600)) / 3600);
+	updateWxGrid(ctx, -1, ((hour % 6 == 4) ? ctx->f1Dir : ctx->f2Dir));
+
+	// (Skipping any updates missed, if running late.)
+	const time_t curTime = Scheduler_now();
+	return getNextWxUpdateTime((curTime > deadline) ? curTime : deadline);
+}
+
+// Returns the first update time after t: once every three hours (at 01Z, 04Z, 07Z, 10Z, 13Z, 16Z, 19Z and 22Z), at 15 minutes past the hour.
+static time_t getNextWxUpdateTime(time_t t)
+{
+	const time_t day = t - (t % (24 * 3600));
+
+	time_t next = day + 3600 + (15 * 60);
+	while (next <= t)
 	{
-		const time_t curTime = time(0);
-		struct tm tres;
-		if (&tres != gmtime_r(&curTime, &tres))
-		{
-			ERRLOG("gmtime_r failed!");
-			sleep(5);
+		next += 3 * 3600;
+	}
 
-			continue;
-		}
+	return next;
+}
 
-		const int hour = tres.tm_hour;
-		const int min = tres.tm_min;
+static void startWxBlendJob(proteus_WeatherCtx* ctx)
+{
+	refreshWxBlend(ctx);
 
-		// Attempt to update once every three hours (at 01Z, 04Z, 07Z, 10Z, 13Z, 16Z, 19Z and 22Z), at 15 minutes past the hour.
-		if ((hour % 3 == 1) && (min < 15))
-		{
-			update = true;
-		}
-		else if (min >= 15 && update)
-		{
-			const char* wxDataDir = ((hour % 6 == 4) ? _f1Dir : _f2Dir);
-			updateWxGrid(-1, wxDataDir);
-			update = false;
-		}
+	if ((ctx->blendJob = Scheduler_add(Scheduler_now() + ctx->blendInterval, &wxBlendJob, ctx, BLEND_JOB_NAME)) < 0)
+	{
+		ctx->blendJob = 0;
+		ERRLOG("Failed to schedule time-blended grid refreshes! Current time queries will interpolate between forecast steps instead.");
+	}
+}
 
+static time_t wxBlendJob(void* arg, time_t deadline)
+{
+	(void) deadline;
 
-		const struct timespec waitUntilTime = { .tv_sec = time(0) + 60, .tv_nsec = 0 };
-		if (0 != pthread_mutex_lock(&_wxUpdaterThreadRunLock))
-		{
-			ERRLOG("wxUpdaterMain: pthread_mutex_lock failed!");
-			sleep(1);
-			continue;
-		}
+	proteus_WeatherCtx* ctx = (proteus_WeatherCtx*) arg;
 
-		bool stopThread = false;
+	refreshWxBlend(ctx);
 
-		if (_wxUpdaterThreadStop)
-		{
-			goto iter_end;
-		}
+	return Scheduler_now() + ctx->blendInterval;
+}
 
-		// TODO: Wait until we need to update the grids. Polling with a short time interval here is lazy and causes pointless frequent wakeups.
-		int rc = pthread_cond_timedwait(&_wxUpdaterThreadCond, &_wxUpdaterThreadRunLock, &waitUntilTime);
+static void startWxWatches(proteus_WeatherCtx* ctx)
+{
+	// (Only one watch, if both forecast points use the same directory.)
+	const int dirs = ((0 == strcmp(ctx->f1Dir, ctx->f2Dir)) ? 1 : 2);
 
-		if (rc != 0 && rc != ETIMEDOUT)
+	for (int i = 0; i < dirs; i++)
+	{
+		if ((ctx->watches[i].watch = FileWatch_add((i == 0) ? ctx->f1Dir : ctx->f2Dir, true, &wxWatchFunc, &ctx->watches[i])) < 0)
 		{
-			ERRLOG1("wxUpdaterMain: pthread_cond_timedwait failed with rc=%d", rc);
-			return 0;
+			ctx->watches[i].watch = 0;
+			ERRLOG("Failed to watch weather data directory! Weather grids will only be updated at the scheduled times.");
 		}
+	}
+}
+
+static void wxWatchFunc(void* arg, const char* name)
+{
+	WxDirWatch* w = (WxDirWatch*) arg;
+	const char* wxDataDirPath = ((w->i == 0) ? w->ctx->f1Dir : w->ctx->f2Dir);
 
-iter_end:
-		stopThread = _wxUpdaterThreadStop;
+	bool dataFile = (0 == strcmp(name, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME));
+	for (int k = 0; k < WX_CSV_FIELD_COUNT && !dataFile; k++)
+	{
+		const size_t len = strlen(WX_CSV_FIELDS[k].fileName);
+		dataFile = (0 == strncmp(name, WX_CSV_FIELDS[k].fileName, len) && (name[len] == '\0' || 0 == strcmp(name + len, ".gz")));
+	}
 
-		if (0 != pthread_mutex_unlock(&_wxUpdaterThreadRunLock))
-		{
-			ERRLOG("wxUpdaterMain: pthread_mutex_unlock failed!");
-		}
+	if (!dataFile || !isWxDataComplete(wxDataDirPath))
+	{
+		return;
+	}
 
-		if (stopThread)
+	// Reload once the data settles, pushing back any reload already pending (while more files are still being written).
+	Scheduler_cancel(w->reloadJob);
+
+	if ((w->reloadJob = Scheduler_add(Scheduler_now() + FILE_WATCH_SETTLE_SECONDS, &wxReloadJob, w, RELOAD_JOB_NAME)) < 0)
+	{
+		w->reloadJob = 0;
+		ERRLOG1("Failed to schedule reload of weather data in %s!", wxDataDirPath);
+	}
+}
+
+static time_t wxReloadJob(void* arg, time_t deadline)
+{
+	(void) deadline;
+
+	const WxDirWatch* w = (const WxDirWatch*) arg;
+	updateWxGrid(w->ctx, -1, ((w->i == 0) ? w->ctx->f1Dir : w->ctx->f2Dir));
+
+	return 0;
+}
+
+// Returns true if the directory holds a snapshot, or all of the CSV files of a forecast point.
+static bool isWxDataComplete(const char* wxDataDirPath)
+{
+	char filePath[WX_GRID_FILE_PATH_MAXLEN + 64];
+
+	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME);
+	if (0 == access(filePath, R_OK))
+	{
+		return true;
+	}
+
+	for (int i = 0; i < WX_CSV_FIELD_COUNT; i++)
+	{
+		if (!getWxCsvFieldPath(filePath, wxDataDirPath, i))
 		{
-			ERRLOG("wxUpdaterMain: Thread was commanded to stop.");
-			break;
+			return false;
 		}
 	}
 
-	return 0;
+	return true;
+}
+
+// Returns a hash of the forecast data in the directory (the snapshot, if any, or else the CSV files), or zero if it couldn't be read.
+static uint64_t hashWxData(const char* wxDataDirPath)
+{
+	char filePath[WX_GRID_FILE_PATH_MAXLEN + 64];
+	uint64_t hash = FILE_WATCH_HASH_INIT;
+
+	snprintf(filePath, WX_GRID_FILE_PATH_MAXLEN + 64, "%s/%s", wxDataDirPath, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME);
+	int rc = FileWatch_hashFile(filePath, &hash);
+	if (rc == 0)
+	{
+		return hash;
+	}
+
+	for (int i = 0; i < WX_CSV_FIELD_COUNT && rc != -2; i++)
+	{
+		getWxCsvFieldPath(filePath, wxDataDirPath, i);
+		rc = FileWatch_hashFile(filePath, &hash);
+	}
+
+	return ((rc == -2) ? 0 : hash);
 }
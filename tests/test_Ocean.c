@@ -14,26 +14,86 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "tests.h"
 #include "tests_assert.h"
 
 #include "proteus/Ocean.h"
+#include "proteus/ScalarConv.h"
+#include "proteus/Scheduler.h"
 
 #define OCEAN_DATA_FILE_1 "./test_data/ocean/f1.csv"
 #define OCEAN_DATA_FILE_2 "./test_data/ocean/f1.csv"
 
+#define QUANTIZE_TEST_POSITIONS (2000)
+#define ADVECT_TEST_PARTICLES (5000)
+#define INGEST_TEST_POSITIONS (2000)
+
 static int test_spatial_interpolation();
 static int test_out_of_bounds_geo();
+static int test_coastal_cells();
+static int test_ice_field();
+static int test_quantize();
+static int test_grid_size();
+static int test_advect();
+static int test_ingest_threads();
+static int test_watch();
+static int test_watch_missing();
 
 static bool validLonLat(double lon, double lat);
+static time_t runOceanReload(time_t t0);
 
 int test_Ocean_run()
 {
 	// TODO: Need a more complete test. This just sanity checks that we read the data,
 	//       and that some of the weather items were filled in correctly (sea surface temperature and salinity).
 
+	// (With its own data, in its own context.)
+	if (test_coastal_cells() != 0)
+	{
+		return 1;
+	}
+
+	if (test_ice_field() != 0)
+	{
+		return 1;
+	}
+
+	if (test_quantize() != 0)
+	{
+		return 1;
+	}
+
+	if (test_grid_size() != 0)
+	{
+		return 1;
+	}
+
+	if (test_advect() != 0)
+	{
+		return 1;
+	}
+
+	if (test_ingest_threads() != 0)
+	{
+		return 1;
+	}
+
+	if (test_watch() != 0)
+	{
+		return 1;
+	}
+
+	if (test_watch_missing() != 0)
+	{
+		return 1;
+	}
+
 	if (0 != proteus_Ocean_init(OCEAN_DATA_FILE_1, OCEAN_DATA_FILE_2))
 	{
 		return 1;
@@ -226,6 +286,712 @@ static int test_out_of_bounds_geo()
 	return 0;
 }
 
+static int test_coastal_cells()
+{
+	char dir[] = "/tmp/proteus_test_coastal_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// Cells with one land corner (C), at 40N 60W and across the antimeridian
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,10.0,0,0,30.0\n");
+	fprintf(fp, "-59.6,40,14.0,0,0,32.0\n");
+	fprintf(fp, "-59.6,40.4,18.0,0,0,37.0\n");
+	fprintf(fp, "179.6,40,20.0,0,0,30.0\n");
+	fprintf(fp, "180,40,22.0,0,0,31.0\n");
+	fprintf(fp, "180,40.4,24.0,0,0,35.0\n");
+	fclose(fp);
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0);
+
+	if (0 != proteus_OceanCtx_init(ctx, file, file))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_OceanData od;
+
+	// A
+	p.lat = 40.0;
+	p.lon = -60.0;
+	IS_TRUE(proteus_OceanCtx_get(ctx, &p, &od));
+	EQUALS_FLT(10.0f, od.surfaceTemp);
+	EQUALS_FLT(30.0f, od.salinity);
+
+	// 0.25A + 0.75C, with C the average of A, B and D
+	p.lat = 40.3;
+	p.lon = -60.0;
+	IS_TRUE(proteus_OceanCtx_get(ctx, &p, &od));
+	EQUALS_FLT((10.0f * 0.25f) + (14.0f * 0.75f), od.surfaceTemp);
+	EQUALS_FLT((30.0f * 0.25f) + (33.0f * 0.75f), od.salinity);
+
+	// Middle of the cell
+	p.lat = 40.2;
+	p.lon = -59.8;
+	IS_TRUE(proteus_OceanCtx_get(ctx, &p, &od));
+	EQUALS_FLT((10.0f + 14.0f + 14.0f + 18.0f) / 4.0f, od.surfaceTemp);
+	EQUALS_FLT((30.0f + 32.0f + 33.0f + 37.0f) / 4.0f, od.salinity);
+
+	// Middle of the cell across the antimeridian
+	p.lat = 40.2;
+	p.lon = 179.8;
+	IS_TRUE(proteus_OceanCtx_get(ctx, &p, &od));
+	EQUALS_FLT((20.0f + 22.0f + 22.0f + 24.0f) / 4.0f, od.surfaceTemp);
+	EQUALS_FLT((30.0f + 31.0f + 32.0f + 35.0f) / 4.0f, od.salinity);
+
+	// Cells with all land corners
+	p.lat = 40.2;
+	p.lon = -60.6;
+	IS_FALSE(proteus_OceanCtx_get(ctx, &p, &od));
+
+	p.lat = 40.6;
+	p.lon = -60.2;
+	IS_FALSE(proteus_OceanCtx_get(ctx, &p, &od));
+
+	proteus_OceanCtx_destroy(ctx);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_ice_field()
+{
+	char dir[] = "/tmp/proteus_test_ice_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// A cell with partial ice at its A and C corners, and full ice at its B and D corners
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,70,-1.5,0.1,0.2,34.0\n");
+	fprintf(fp, "-59.6,70,-1.8,0.1,0.2,33.0\n");
+	fprintf(fp, "-60,70.4,-1.5,0.1,0.2,34.0\n");
+	fprintf(fp, "-59.6,70.4,-1.8,0.1,0.2,33.0\n");
+	fclose(fp);
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0);
+
+	if (0 != proteus_OceanCtx_init(ctx, file, file))
+	{
+		return 1;
+	}
+
+	const float partialIce = ((-7500.0f * -1.5f) / 34.0f) - 300.0f;
+
+	proteus_GeoPos p;
+	proteus_OceanData od;
+	proteus_OceanData odIce;
+
+	// A
+	p.lat = 70.0;
+	p.lon = -60.0;
+	IS_TRUE(proteus_OceanCtx_get(ctx, &p, &od));
+	EQUALS_FLT(partialIce, od.ice);
+
+	// Ice is interpolated between the corners (rather than computed from the interpolated temperature and salinity).
+	p.lat = 70.1;
+	p.lon = -59.8;
+	IS_TRUE(proteus_OceanCtx_get(ctx, &p, &od));
+	EQUALS_FLT((partialIce + 100.0f) / 2.0f, od.ice);
+
+	// Only ice requested, so nothing else is touched.
+	odIce.current.angle = 1.0;
+	odIce.current.mag = 2.0;
+	odIce.surfaceTemp = 3.0f;
+	odIce.salinity = 4.0f;
+	odIce.ice = -1.0f;
+
+	IS_TRUE(proteus_OceanCtx_getFields(ctx, &p, &odIce, PROTEUS_OCEAN_FIELD_ICE));
+	EQUALS_FLT(od.ice, odIce.ice);
+	EQUALS_DBL(1.0, odIce.current.angle);
+	EQUALS_DBL(2.0, odIce.current.mag);
+	EQUALS_FLT(3.0f, odIce.surfaceTemp);
+	EQUALS_FLT(4.0f, odIce.salinity);
+
+	IS_TRUE(proteus_OceanCtx_getFieldsAt(ctx, &p, time(0), &odIce, PROTEUS_OCEAN_FIELD_ALL));
+	EQUALS_DBL(od.current.angle, odIce.current.angle);
+	EQUALS_DBL(od.current.mag, odIce.current.mag);
+	EQUALS_FLT(od.surfaceTemp, odIce.surfaceTemp);
+	EQUALS_FLT(od.salinity, odIce.salinity);
+	EQUALS_FLT(od.ice, odIce.ice);
+
+	// Land
+	p.lat = 70.9;
+	IS_FALSE(proteus_OceanCtx_getFields(ctx, &p, &odIce, PROTEUS_OCEAN_FIELD_ICE));
+
+	proteus_OceanCtx_destroy(ctx);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_quantize()
+{
+	char dir[] = "/tmp/proteus_test_quantize_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// Random data over 60W to 40W, 60N to 80N (with some land), including some freezing water
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+
+	srand(23);
+	for (int y = 0; y <= 50; y++)
+	{
+		for (int x = 0; x <= 50; x++)
+		{
+			if (rand() % 8 == 0)
+			{
+				continue;
+			}
+
+			const double temp = -2.0 + ((12.0 * rand()) / RAND_MAX);
+			const double u = -2.0 + ((4.0 * rand()) / RAND_MAX);
+			const double v = -2.0 + ((4.0 * rand()) / RAND_MAX);
+			const double salinity = 30.0 + ((7.0 * rand()) / RAND_MAX);
+
+			fprintf(fp, "%.1f,%.1f,%.3f,%.3f,%.3f,%.3f\n", -60.0 + (x * 0.4), 60.0 + (y * 0.4), temp, u, v, salinity);
+		}
+	}
+
+	// A point out of the stored temperature range (clamped)
+	fprintf(fp, "-30,60,70.0,0,0,35.0\n");
+	fclose(fp);
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	proteus_OceanCtx* qctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0 && qctx != 0);
+
+	proteus_OceanOptions opts;
+	proteus_Ocean_getDefaultOptions(&opts);
+	IS_FALSE(opts.quantize);
+
+	if (0 != proteus_OceanCtx_initWithOptions(ctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	opts.quantize = true;
+
+	if (0 != proteus_OceanCtx_initWithOptions(qctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	// Results are within the documented error bounds (plus some slack for the float results).
+	int diffs = 0;
+	int count = 0;
+	for (int i = 0; i < QUANTIZE_TEST_POSITIONS; i++)
+	{
+		const proteus_GeoPos p = { .lat = 60.0 + ((20.0 * rand()) / RAND_MAX), .lon = -60.0 + ((20.0 * rand()) / RAND_MAX) };
+		proteus_OceanData expected;
+		proteus_OceanData od;
+
+		const bool valid = proteus_OceanCtx_get(ctx, &p, &expected);
+		EQUALS(valid, proteus_OceanCtx_get(qctx, &p, &od));
+
+		if (!valid)
+		{
+			continue;
+		}
+
+		count++;
+
+		if (od.surfaceTemp != expected.surfaceTemp)
+		{
+			diffs++;
+		}
+
+		IS_TRUE(fabs(od.current.mag - expected.current.mag) <= 0.00036);
+		IS_TRUE(fabs(od.surfaceTemp - expected.surfaceTemp) <= 0.00051);
+		IS_TRUE(fabs(od.salinity - expected.salinity) <= 0.00051);
+
+		// (Ice is computed from the quantized surface temperature and salinity, which is at least 30 here.)
+		IS_TRUE(fabs(od.ice - expected.ice) <= 4.0 / 30.0);
+	}
+
+	// (Make sure that most positions were on water, and that the grids really were quantized.)
+	IS_TRUE(count > QUANTIZE_TEST_POSITIONS / 2);
+	IS_TRUE(diffs > 0);
+
+	const proteus_GeoPos p = { .lat = 60.0, .lon = -30.0 };
+	proteus_OceanData od;
+	IS_TRUE(proteus_OceanCtx_get(qctx, &p, &od));
+	IS_TRUE(od.surfaceTemp > 55.99f && od.surfaceTemp < 56.0f);
+
+	proteus_OceanCtx_destroy(ctx);
+	proteus_OceanCtx_destroy(qctx);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_grid_size()
+{
+	char dir[] = "/tmp/proteus_test_grid_size_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// Water over 60W to 40W, 60N to 80N, with some land
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+
+	for (int y = 0; y <= 50; y++)
+	{
+		for (int x = 0; x <= 50; x++)
+		{
+			if ((x * y) % 7 == 3)
+			{
+				continue;
+			}
+
+			fprintf(fp, "%.1f,%.1f,5.0,0.1,0.1,34.0\n", -60.0 + (x * 0.4), 60.0 + (y * 0.4));
+		}
+	}
+
+	fclose(fp);
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	proteus_OceanCtx* qctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0 && qctx != 0);
+
+	proteus_OceanGridStats stats;
+	proteus_OceanGridStats qstats;
+
+	// (Nothing held before being initialized.)
+	proteus_OceanCtx_getGridStats(ctx, &stats);
+	EQUALS(0UL, stats.bytes);
+	EQUALS(0, stats.coastalCells);
+
+	proteus_OceanOptions opts;
+	proteus_Ocean_getDefaultOptions(&opts);
+
+	if (0 != proteus_OceanCtx_initWithOptions(ctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	opts.quantize = true;
+
+	if (0 != proteus_OceanCtx_initWithOptions(qctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	proteus_OceanCtx_getGridStats(ctx, &stats);
+	proteus_OceanCtx_getGridStats(qctx, &qstats);
+
+	IS_TRUE(stats.coastalCells > 0);
+	EQUALS(stats.coastalCells, qstats.coastalCells);
+
+	// Against two grids of a struct per grid point (900x426 points, of 20 bytes each), a float grid holds about
+	// the same, and a quantized grid well under half (at most 45%).
+	const size_t structBytes = 2 * 7668000;
+	IS_TRUE(stats.bytes * 20 <= structBytes * 21);
+	IS_TRUE(qstats.bytes * 20 <= structBytes * 9);
+	IS_TRUE(qstats.bytes < stats.bytes);
+
+	proteus_OceanCtx_destroy(ctx);
+	proteus_OceanCtx_destroy(qctx);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_advect()
+{
+	char dir[] = "/tmp/proteus_test_advect_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// A uniform current (0.5 m/s east, 0.25 m/s north) over 60W to 40W, 30N to 40N, with land all around
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+
+	for (int y = 0; y <= 25; y++)
+	{
+		for (int x = 0; x <= 50; x++)
+		{
+			fprintf(fp, "%.1f,%.1f,15.0,0.5,0.25,35.0\n", -60.0 + (x * 0.4), 30.0 + (y * 0.4));
+		}
+	}
+
+	fclose(fp);
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0);
+
+	proteus_GeoPos p = { .lat = 35.0, .lon = -55.0 };
+	bool drifting = true;
+
+	// (Not initialized.)
+	EQUALS(0, proteus_OceanCtx_advect(ctx, &p, 1, time(0), 600.0, 1, PROTEUS_OCEAN_ADVECT_RK4, 1, &drifting));
+	IS_FALSE(drifting);
+	EQUALS_DBL(35.0, p.lat);
+	EQUALS_DBL(-55.0, p.lon);
+
+	if (0 != proteus_OceanCtx_init(ctx, file, file))
+	{
+		return 1;
+	}
+
+	// Invalid arguments
+	EQUALS(-3, proteus_OceanCtx_advect(ctx, &p, 0, time(0), 600.0, 1, PROTEUS_OCEAN_ADVECT_RK4, 1, 0));
+	EQUALS(-3, proteus_OceanCtx_advect(ctx, &p, 1, time(0), 600.0, 1, 3, 1, 0));
+	EQUALS(-3, proteus_OceanCtx_advect(ctx, &p, 1, time(0), 600.0, 1, PROTEUS_OCEAN_ADVECT_RK4, 0, 0));
+	EQUALS(-3, proteus_OceanCtx_advect(ctx, &p, 1, time(0), NAN, 1, PROTEUS_OCEAN_ADVECT_RK4, 1, 0));
+
+	// Six hours of drift, in ten minute steps (about 10.8 km east and 5.4 km north)
+	proteus_GeoPos p2 = p;
+	proteus_GeoPos p4 = p;
+	EQUALS(1, proteus_OceanCtx_advect(ctx, &p2, 1, time(0), 600.0, 36, PROTEUS_OCEAN_ADVECT_RK2, 1, 0));
+	EQUALS(1, proteus_OceanCtx_advect(ctx, &p4, 1, time(0), 600.0, 36, PROTEUS_OCEAN_ADVECT_RK4, 1, 0));
+
+	const double midLat = (p.lat + p4.lat) / 2.0;
+	IS_TRUE(fabs((p4.lat - p.lat) - proteus_ScalarConv_m2dlat(0.25 * 21600.0, midLat)) < 0.00001);
+	IS_TRUE(fabs((p4.lon - p.lon) - proteus_ScalarConv_m2dlon(0.5 * 21600.0, midLat)) < 0.00001);
+
+	IS_TRUE(fabs(p2.lat - p4.lat) < 0.000001);
+	IS_TRUE(fabs(p2.lon - p4.lon) < 0.000001);
+
+	// Backwards in time
+	EQUALS(1, proteus_OceanCtx_advect(ctx, &p4, 1, time(0), -600.0, 36, PROTEUS_OCEAN_ADVECT_RK4, 1, 0));
+	IS_TRUE(fabs(p4.lat - p.lat) < 0.000001);
+	IS_TRUE(fabs(p4.lon - p.lon) < 0.000001);
+
+	// Particles reaching land within three days (east of 39.6W, where cells have no water corners), or already
+	// not drifting, stay put.
+	proteus_GeoPos beached[3] = { { .lat = 35.0, .lon = -41.0 }, { .lat = 35.0, .lon = -41.0 }, { .lat = 35.0, .lon = -50.0 } };
+	bool beachedDrifting[3] = { true, false, true };
+	EQUALS(1, proteus_OceanCtx_advect(ctx, beached, 3, time(0), 600.0, 432, PROTEUS_OCEAN_ADVECT_RK4, 1, beachedDrifting));
+	IS_FALSE(beachedDrifting[0]);
+	IS_TRUE(beached[0].lon > -39.7 && beached[0].lon < -39.2);
+	IS_FALSE(beachedDrifting[1]);
+	EQUALS_DBL(35.0, beached[1].lat);
+	EQUALS_DBL(-41.0, beached[1].lon);
+	IS_TRUE(beachedDrifting[2]);
+
+	// Results are the same however many threads are used.
+	proteus_GeoPos* pos1 = malloc(ADVECT_TEST_PARTICLES * sizeof(proteus_GeoPos));
+	proteus_GeoPos* pos4 = malloc(ADVECT_TEST_PARTICLES * sizeof(proteus_GeoPos));
+	bool* drifting1 = malloc(ADVECT_TEST_PARTICLES * sizeof(bool));
+	bool* drifting4 = malloc(ADVECT_TEST_PARTICLES * sizeof(bool));
+	IS_TRUE(pos1 != 0 && pos4 != 0 && drifting1 != 0 && drifting4 != 0);
+
+	srand(24);
+	for (int i = 0; i < ADVECT_TEST_PARTICLES; i++)
+	{
+		pos1[i].lat = 30.0 + ((10.0 * rand()) / RAND_MAX);
+		pos1[i].lon = -60.0 + ((20.0 * rand()) / RAND_MAX);
+		pos4[i] = pos1[i];
+		drifting1[i] = true;
+		drifting4[i] = true;
+	}
+
+	const int count = proteus_OceanCtx_advect(ctx, pos1, ADVECT_TEST_PARTICLES, time(0), 600.0, 144, PROTEUS_OCEAN_ADVECT_RK4, 1, drifting1);
+	EQUALS(count, proteus_OceanCtx_advect(ctx, pos4, ADVECT_TEST_PARTICLES, time(0), 600.0, 144, PROTEUS_OCEAN_ADVECT_RK4, 4, drifting4));
+
+	// (Some, but not all, particles reached land within a day.)
+	IS_TRUE(count > 0 && count < ADVECT_TEST_PARTICLES);
+
+	for (int i = 0; i < ADVECT_TEST_PARTICLES; i++)
+	{
+		EQUALS_DBL(pos1[i].lat, pos4[i].lat);
+		EQUALS_DBL(pos1[i].lon, pos4[i].lon);
+		EQUALS(drifting1[i], drifting4[i]);
+	}
+
+	free(pos1);
+	free(pos4);
+	free(drifting1);
+	free(drifting4);
+
+	proteus_OceanCtx_destroy(ctx);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_ingest_threads()
+{
+	char dir[] = "/tmp/proteus_test_ingest_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+	char badFile[64];
+	snprintf(badFile, sizeof(badFile), "%s/bad.csv", dir);
+
+	// Random data over 80W to 0, 0 to 80N (with some land), large enough to be parsed in many byte ranges
+	FILE* fp = fopen(file, "w");
+	FILE* badFp = fopen(badFile, "w");
+	IS_TRUE(fp != 0 && badFp != 0);
+
+	srand(25);
+	for (int y = 0; y <= 200; y++)
+	{
+		for (int x = 0; x <= 200; x++)
+		{
+			if (rand() % 8 == 0)
+			{
+				continue;
+			}
+
+			const double temp = -2.0 + ((30.0 * rand()) / RAND_MAX);
+			const double u = -2.0 + ((4.0 * rand()) / RAND_MAX);
+			const double v = -2.0 + ((4.0 * rand()) / RAND_MAX);
+			const double salinity = 30.0 + ((7.0 * rand()) / RAND_MAX);
+
+			fprintf(fp, "%.1f,%.1f,%.3f,%.3f,%.3f,%.3f\n", -80.0 + (x * 0.4), y * 0.4, temp, u, v, salinity);
+			fprintf(badFp, "%.1f,%.1f,%.3f,%.3f,%.3f,%.3f\n", -80.0 + (x * 0.4), y * 0.4, temp, u, v, salinity);
+		}
+
+		if (y == 150)
+		{
+			// A row missing columns, part way through the file
+			fprintf(badFp, "-20.0,60.0,10.0\n");
+		}
+	}
+
+	fclose(fp);
+	fclose(badFp);
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	proteus_OceanCtx* tctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0 && tctx != 0);
+
+	proteus_OceanOptions opts;
+	proteus_Ocean_getDefaultOptions(&opts);
+	EQUALS(1, opts.ingestThreads);
+
+	if (0 != proteus_OceanCtx_initWithOptions(ctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	opts.ingestThreads = 0;
+	EQUALS(-3, proteus_OceanCtx_initWithOptions(tctx, file, file, &opts));
+
+	opts.ingestThreads = 4;
+	IS_TRUE(0 != proteus_OceanCtx_initWithOptions(tctx, badFile, badFile, &opts));
+
+	if (0 != proteus_OceanCtx_initWithOptions(tctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	// Results are the same as when parsed on a single thread.
+	int count = 0;
+	for (int i = 0; i < INGEST_TEST_POSITIONS; i++)
+	{
+		const proteus_GeoPos p = { .lat = (80.0 * rand()) / RAND_MAX, .lon = -80.0 + ((80.0 * rand()) / RAND_MAX) };
+		proteus_OceanData expected;
+		proteus_OceanData od;
+
+		const bool valid = proteus_OceanCtx_get(ctx, &p, &expected);
+		EQUALS(valid, proteus_OceanCtx_get(tctx, &p, &od));
+
+		if (!valid)
+		{
+			continue;
+		}
+
+		count++;
+
+		EQUALS_DBL(expected.current.angle, od.current.angle);
+		EQUALS_DBL(expected.current.mag, od.current.mag);
+		EQUALS_FLT(expected.surfaceTemp, od.surfaceTemp);
+		EQUALS_FLT(expected.salinity, od.salinity);
+		EQUALS_FLT(expected.ice, od.ice);
+	}
+
+	IS_TRUE(count > INGEST_TEST_POSITIONS / 2);
+
+	proteus_OceanCtx_destroy(ctx);
+	proteus_OceanCtx_destroy(tctx);
+
+	unlink(file);
+	unlink(badFile);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_watch()
+{
+	char dir[] = "/tmp/proteus_test_ocean_watch_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,10.0,0,0,30.0\n");
+	fclose(fp);
+
+	// 2026-01-01 00:30Z (next scheduled update at 06:00Z, both grids initialized with the "f1" data)
+	const time_t t0 = 1767227400;
+	tests_fakeTime = t0;
+
+	proteus_Scheduler_setClock(&tests_fakeClock);
+
+	proteus_OceanOptions opts;
+	proteus_Ocean_getDefaultOptions(&opts);
+	IS_FALSE(opts.watchFiles);
+	opts.watchFiles = true;
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0);
+
+	if (0 != proteus_OceanCtx_initWithOptions(ctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_OceanData od;
+
+	p.lat = 40.0;
+	p.lon = -60.0;
+	IS_TRUE(proteus_OceanCtx_getAt(ctx, &p, t0, &od));
+	EQUALS_FLT(10.0f, od.surfaceTemp);
+
+	// Changed data is loaded as the latest grid once written, phasing in from the previous grid.
+	fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,20.0,0,0,30.0\n");
+	fclose(fp);
+
+	const time_t reloadTime = runOceanReload(t0);
+	IS_TRUE(reloadTime != 0);
+
+	IS_TRUE(proteus_OceanCtx_getAt(ctx, &p, reloadTime, &od));
+	EQUALS_FLT(10.0f, od.surfaceTemp);
+	IS_TRUE(proteus_OceanCtx_getAt(ctx, &p, reloadTime + (30 * 86400), &od));
+	EQUALS_FLT(20.0f, od.surfaceTemp);
+
+	// Rewriting the file with the same contents triggers a reload, which finds the data unchanged, and so
+	// leaves the grids as they were (rather than replacing the previous grid and restarting the phase-in).
+	tests_fakeTime += 60;
+
+	fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,20.0,0,0,30.0\n");
+	fclose(fp);
+
+	IS_TRUE(runOceanReload(t0) > reloadTime);
+
+	IS_TRUE(proteus_OceanCtx_getAt(ctx, &p, reloadTime, &od));
+	EQUALS_FLT(10.0f, od.surfaceTemp);
+	IS_TRUE(proteus_OceanCtx_getAt(ctx, &p, reloadTime + (30 * 86400), &od));
+	EQUALS_FLT(20.0f, od.surfaceTemp);
+
+	proteus_OceanCtx_destroy(ctx);
+
+	proteus_Scheduler_setClock(0);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_watch_missing()
+{
+	char dir[] = "/tmp/proteus_test_ocean_watch_missing_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// 2026-01-01 00:30Z
+	const time_t t0 = 1767227400;
+	tests_fakeTime = t0;
+
+	proteus_Scheduler_setClock(&tests_fakeClock);
+
+	proteus_OceanOptions opts;
+	proteus_Ocean_getDefaultOptions(&opts);
+	opts.watchFiles = true;
+
+	proteus_OceanCtx* ctx = proteus_OceanCtx_create();
+	IS_TRUE(ctx != 0);
+
+	// (Jobs of other modules, such as the GeoInfo grid pruner, may already be scheduled.)
+	const time_t nextTime = proteus_Scheduler_getNextTime();
+
+	// Init fails without the data file, leaving no update job or watches behind.
+	EQUALS(-1, proteus_OceanCtx_initWithOptions(ctx, file, file, &opts));
+	EQUALS(nextTime, proteus_Scheduler_getNextTime());
+
+	// So the file arriving later doesn't update (or touch) the uninitialized context.
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,10.0,0,0,30.0\n");
+	fclose(fp);
+
+	// (Time for a watch to see the write, if there were one.)
+	usleep(200000);
+	EQUALS(nextTime, proteus_Scheduler_getNextTime());
+
+	tests_fakeTime = t0 + 86400;
+	EQUALS(0, proteus_Scheduler_runDue());
+
+	const proteus_GeoPos p = { .lat = 40.0, .lon = -60.0 };
+	proteus_OceanData od;
+	IS_FALSE(proteus_OceanCtx_get(ctx, &p, &od));
+
+	proteus_OceanCtx_destroy(ctx);
+
+	proteus_Scheduler_setClock(0);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+
+// Waits for a write of a watched file to schedule a reload (ahead of the next scheduled update, at 06:00Z),
+// then runs it. Returns the time at which it ran, or zero if it wasn't scheduled.
+static time_t runOceanReload(time_t t0)
+{
+	const time_t reloadTime = tests_waitForNextTimeBefore(t0 + (5 * 3600));
+
+	if (reloadTime <= tests_fakeTime || reloadTime >= t0 + (5 * 3600))
+	{
+		return 0;
+	}
+
+	tests_fakeTime = reloadTime;
+	return ((1 == proteus_Scheduler_runDue()) ? reloadTime : 0);
+}
+
 static bool validLonLat(double lon, double lat)
 {
 	return (lon >= -180.0 && lon <= 180.0 && lat >= -90.0 && lat <= 90.0);
@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+#include "tests_assert.h"
+
+#include "RowParser.h"
+
+#define RANDOM_TEST_VALUES (100000)
+
+// Inputs covering the parser's edge cases (each compared against strtof())
+static const char* FLOAT_INPUTS[] = {
+	// Plain values
+	"0", "-0", "1", "-1", "+5", "0.1", "0.3", "3.14159", "-273.15", ".5", "5.", "  12.5", "\t-0.25",
+
+	// Exponents
+	"1e-3", "2E+5", "1.5e10", "-7.25E-7", "6.02214076e23", "5e", "5e+", "1e0", "1e22", "1e-22",
+
+	// Scaling beyond the exactly representable powers of ten (with pow())
+	"1e23", "1e30", "1e-30", "3.4028235e38", "1.17549435e-38", "1e-45", "1e39", "1e-50", "1e400", "1e-400",
+	"123456789e-40", "0.000000000000000000000000123456",
+
+	// Mantissas longer than 19 digits (dropping digits)
+	"12345678901234567890123", "123456789012345678901234567890e-10", "0.12345678901234567890123456789",
+	"1.00000000000000000000001", "99999999999999999999999999999", "-0.000000000000000000001234567890123456789",
+
+	// Values near the middle of two floats (rounding within 1 ULP)
+	"16777217", "16777219", "0.1000000015", "1.00000006", "0.30000001192092896", "33554435",
+
+	// Not-a-numbers and infinities
+	"nan", "NaN", "-nan", "NAN", "inf", "-inf", "INF", "Infinity", "-Infinity",
+
+	// Not numbers at all
+	"abc", "-", "."
+};
+
+static int test_float_inputs();
+static int test_random_values();
+static int test_columns();
+
+static bool withinOneUlp(float v, float expected);
+static int parseOne(const char* s, float* v);
+
+
+int test_RowParser_run()
+{
+	if (test_float_inputs() != 0)
+	{
+		return 1;
+	}
+
+	if (test_random_values() != 0)
+	{
+		return 1;
+	}
+
+	if (test_columns() != 0)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_float_inputs()
+{
+	for (size_t i = 0; i < (sizeof(FLOAT_INPUTS) / sizeof(const char*)); i++)
+	{
+		const char* s = FLOAT_INPUTS[i];
+
+		float v;
+		EQUALS(0, parseOne(s, &v));
+
+		const float expected = strtof(s, 0);
+		if (!withinOneUlp(v, expected))
+		{
+			printf("\t%s: %.9g != strtof() %.9g\n", s, v, expected);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int test_random_values()
+{
+	static const char* FORMATS[] = { "%.3f", "%.6f", "%.9g", "%.17g", "%.4e", "%.12E" };
+	char s[64];
+
+	srand(3);
+	for (int i = 0; i < RANDOM_TEST_VALUES; i++)
+	{
+		// Random magnitudes over the whole range of floats
+		const double v = ((2.0 * rand()) / RAND_MAX - 1.0) * pow(10.0, (rand() % 80) - 40);
+		snprintf(s, sizeof(s), FORMATS[i % (sizeof(FORMATS) / sizeof(const char*))], v);
+
+		float parsed;
+		EQUALS(0, parseOne(s, &parsed));
+
+		const float expected = strtof(s, 0);
+		if (!withinOneUlp(parsed, expected))
+		{
+			printf("\t%s: %.9g != strtof() %.9g\n", s, parsed, expected);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int test_columns()
+{
+	const char row[] = "1.5,,-2e3,  7\n8,9\n";
+	const char* p = row;
+	const char* end = row + strlen(row);
+	float cols[ROW_PARSER_MAX_COLS];
+
+	// (Empty columns are skipped, as with strtok().)
+	EQUALS(0, RowParser_parseRow(&p, end, cols, 3));
+	EQUALS_FLT(1.5f, cols[0]);
+	EQUALS_FLT(-2000.0f, cols[1]);
+	EQUALS_FLT(7.0f, cols[2]);
+
+	// A row ending before the third column
+	EQUALS(-3, RowParser_parseRow(&p, end, cols, 3));
+	EQUALS_FLT(8.0f, cols[0]);
+	EQUALS_FLT(9.0f, cols[1]);
+	IS_TRUE(p == end);
+
+	return 0;
+}
+
+// Whether a value is the same as expected (the same kind of NaN or infinity, or zero of the same sign), or
+// the float next to it.
+static bool withinOneUlp(float v, float expected)
+{
+	if (isnan(v) || isnan(expected))
+	{
+		return (isnan(v) && isnan(expected) && signbit(v) == signbit(expected));
+	}
+
+	if (v == expected)
+	{
+		return (signbit(v) == signbit(expected));
+	}
+
+	return (nextafterf(expected, v) == v);
+}
+
+// Parses a single column row holding s.
+static int parseOne(const char* s, float* v)
+{
+	char row[128];
+	snprintf(row, sizeof(row), "%s\n", s);
+
+	const char* p = row;
+	const int rc = RowParser_parseRow(&p, row + strlen(row), v, 1);
+
+	return ((rc == 0 && *p == '\0') ? 0 : -1);
+}
@@ -15,23 +15,40 @@
  */
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "tests.h"
 #include "tests_assert.h"
 
+#include "proteus/Scheduler.h"
 #include "proteus/Wave.h"
 
-#define WAVE_DATA_FILE_1 "./test_data/wave/f1.csv"
-#define WAVE_DATA_FILE_2 "./test_data/wave/f1.csv"
+#define WAVE_DATA_DIR "./test_data/wave"
+#define WAVE_DATA_FILE_1 WAVE_DATA_DIR "/f1.csv"
+#define WAVE_DATA_FILE_2 WAVE_DATA_DIR "/f1.csv"
+
+#define INGEST_TEST_POSITIONS (2000)
 
 static int test_spatial_interpolation();
 static int test_spatial_interpolation_180();
 static int test_out_of_bounds_geo();
+static int test_watch();
+static int test_watch_missing();
+static int test_ctx();
+static int test_ingest_threads();
 
 static bool validLonLat(double lon, double lat);
 
 int test_Wave_run()
 {
+	// (With its own data, in its own context.)
+	if (test_ingest_threads() != 0)
+	{
+		return 1;
+	}
+
 	if (0 != proteus_Wave_init(WAVE_DATA_FILE_1, WAVE_DATA_FILE_2))
 	{
 		return 1;
@@ -82,6 +99,19 @@ int test_Wave_run()
 	EQUALS_FLT(2.35f, wd.waveHeight);
 
 
+	// Both forecast points are the same, so the query time doesn't matter (and is clamped outside of the forecast window).
+	p.lat = 40.0;
+	p.lon = -60.0;
+	IS_TRUE(proteus_Wave_getAt(&p, time(0) - 86400, &wd));
+	EQUALS_FLT(1.96f, wd.waveHeight);
+	IS_TRUE(proteus_Wave_getAt(&p, time(0) + 86400, &wd));
+	EQUALS_FLT(1.96f, wd.waveHeight);
+
+	p.lat = 55.0;
+	p.lon = -100.0;
+	IS_FALSE(proteus_Wave_getAt(&p, time(0), &wd));
+
+
 	if (test_spatial_interpolation() != 0)
 	{
 		return 1;
@@ -97,6 +127,21 @@ int test_Wave_run()
 		return 1;
 	}
 
+	if (test_watch() != 0)
+	{
+		return 1;
+	}
+
+	if (test_watch_missing() != 0)
+	{
+		return 1;
+	}
+
+	if (test_ctx() != 0)
+	{
+		return 1;
+	}
+
 
 	return 0;
 }
@@ -255,6 +300,265 @@ static int test_out_of_bounds_geo()
 	return 0;
 }
 
+static int test_watch()
+{
+	char dir[] = "/tmp/proteus_test_watch_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+	EQUALS(0, tests_copyFile(WAVE_DATA_DIR, "f1.csv", dir, "f1.csv"));
+
+	// 2026-01-01 00:30Z (next scheduled update at 06:00Z)
+	const time_t t0 = 1767227400;
+	tests_fakeTime = t0;
+
+	proteus_Scheduler_setClock(&tests_fakeClock);
+
+	proteus_WaveOptions opts;
+	proteus_Wave_getDefaultOptions(&opts);
+	IS_FALSE(opts.watchFiles);
+	opts.watchFiles = true;
+
+	if (0 != proteus_Wave_initWithOptions(file, file, &opts))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_WaveData wd;
+
+	p.lat = 40.0;
+	p.lon = -60.0;
+	IS_TRUE(proteus_Wave_getAt(&p, t0 + 86400, &wd));
+	EQUALS_FLT(1.96f, wd.waveHeight);
+
+	// Changed data (with only one grid point, so that all others keep their previous values) is loaded once written.
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,5.0\n");
+	fclose(fp);
+
+	const time_t reloadTime = tests_waitForNextTimeBefore(t0 + (5 * 3600));
+
+	IS_TRUE(reloadTime > t0 && reloadTime < t0 + (5 * 3600));
+
+	tests_fakeTime = reloadTime;
+	EQUALS(1, proteus_Scheduler_runDue());
+
+	IS_TRUE(proteus_Wave_getAt(&p, reloadTime + 86400, &wd));
+	EQUALS_FLT(5.0f, wd.waveHeight);
+
+	p.lat = -36.0;
+	p.lon = 0.0;
+	IS_TRUE(proteus_Wave_getAt(&p, reloadTime + 86400, &wd));
+	EQUALS_FLT(3.57f, wd.waveHeight);
+
+	proteus_Scheduler_setClock(0);
+
+	if (0 != proteus_Wave_init(WAVE_DATA_FILE_1, WAVE_DATA_FILE_2))
+	{
+		return 1;
+	}
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_watch_missing()
+{
+	char dir[] = "/tmp/proteus_test_wave_watch_missing_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// 2026-01-01 00:30Z
+	const time_t t0 = 1767227400;
+	tests_fakeTime = t0;
+
+	proteus_Scheduler_setClock(&tests_fakeClock);
+
+	proteus_WaveOptions opts;
+	proteus_Wave_getDefaultOptions(&opts);
+	opts.watchFiles = true;
+
+	proteus_WaveCtx* ctx = proteus_WaveCtx_create();
+	IS_TRUE(ctx != 0);
+
+	// (Jobs of other modules, such as the GeoInfo grid pruner, may already be scheduled.)
+	const time_t nextTime = proteus_Scheduler_getNextTime();
+
+	// Init fails without the data file, leaving no update job or watches behind.
+	EQUALS(-1, proteus_WaveCtx_initWithOptions(ctx, file, file, &opts));
+	EQUALS(nextTime, proteus_Scheduler_getNextTime());
+
+	// So the file arriving later doesn't update (or touch) the uninitialized context.
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,5.0\n");
+	fclose(fp);
+
+	// (Time for a watch to see the write, if there were one.)
+	usleep(200000);
+	EQUALS(nextTime, proteus_Scheduler_getNextTime());
+
+	tests_fakeTime = t0 + 86400;
+	EQUALS(0, proteus_Scheduler_runDue());
+
+	const proteus_GeoPos p = { .lat = 40.0, .lon = -60.0 };
+	proteus_WaveData wd;
+	IS_FALSE(proteus_WaveCtx_get(ctx, &p, &wd));
+
+	proteus_WaveCtx_destroy(ctx);
+
+	proteus_Scheduler_setClock(0);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_ctx()
+{
+	char dir[] = "/tmp/proteus_test_ctx_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	// Data with only one grid point (so that all others are invalid)
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+	fprintf(fp, "-60,40,5.0\n");
+	fclose(fp);
+
+	proteus_WaveCtx* ctx = proteus_WaveCtx_create();
+	IS_TRUE(ctx != 0);
+	IS_TRUE(ctx != proteus_WaveCtx_getDefault());
+
+	proteus_GeoPos p;
+	proteus_WaveData wd;
+
+	p.lat = 40.0;
+	p.lon = -60.0;
+
+	// Not initialized yet
+	IS_FALSE(proteus_WaveCtx_get(ctx, &p, &wd));
+
+	if (0 != proteus_WaveCtx_init(ctx, file, file))
+	{
+		return 1;
+	}
+
+	IS_TRUE(proteus_WaveCtx_get(ctx, &p, &wd));
+	EQUALS_FLT(5.0f, wd.waveHeight);
+
+	// The default context keeps its own data.
+	IS_TRUE(proteus_Wave_get(&p, &wd));
+	EQUALS_FLT(1.96f, wd.waveHeight);
+	IS_TRUE(proteus_WaveCtx_get(proteus_WaveCtx_getDefault(), &p, &wd));
+	EQUALS_FLT(1.96f, wd.waveHeight);
+
+	p.lat = -36.0;
+	p.lon = 0.0;
+	IS_FALSE(proteus_WaveCtx_getAt(ctx, &p, time(0), &wd));
+	IS_TRUE(proteus_Wave_getAt(&p, time(0), &wd));
+	EQUALS_FLT(3.57f, wd.waveHeight);
+
+	proteus_WaveCtx_destroy(ctx);
+
+	// (The default context is never destroyed.)
+	proteus_WaveCtx_destroy(proteus_WaveCtx_getDefault());
+	IS_TRUE(proteus_Wave_get(&p, &wd));
+	EQUALS_FLT(3.57f, wd.waveHeight);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_ingest_threads()
+{
+	char dir[] = "/tmp/proteus_test_ingest_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	char file[64];
+	snprintf(file, sizeof(file), "%s/f1.csv", dir);
+
+	// Random data over the whole grid (with some points missing), large enough to be parsed in many byte ranges
+	FILE* fp = fopen(file, "w");
+	IS_TRUE(fp != 0);
+
+	srand(25);
+	for (int y = -90; y <= 90; y++)
+	{
+		for (int x = -180; x < 180; x++)
+		{
+			if (rand() % 8 != 0)
+			{
+				fprintf(fp, "%d,%d,%.3f\n", x, y, (8.0 * rand()) / RAND_MAX);
+			}
+		}
+	}
+
+	fclose(fp);
+
+	proteus_WaveCtx* ctx = proteus_WaveCtx_create();
+	proteus_WaveCtx* tctx = proteus_WaveCtx_create();
+	IS_TRUE(ctx != 0 && tctx != 0);
+
+	proteus_WaveOptions opts;
+	proteus_Wave_getDefaultOptions(&opts);
+	EQUALS(1, opts.ingestThreads);
+
+	if (0 != proteus_WaveCtx_initWithOptions(ctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	opts.ingestThreads = 0;
+	EQUALS(-3, proteus_WaveCtx_initWithOptions(tctx, file, file, &opts));
+
+	opts.ingestThreads = 4;
+	if (0 != proteus_WaveCtx_initWithOptions(tctx, file, file, &opts))
+	{
+		return 1;
+	}
+
+	// Results are the same as when parsed on a single thread.
+	int count = 0;
+	for (int i = 0; i < INGEST_TEST_POSITIONS; i++)
+	{
+		const proteus_GeoPos p = { .lat = -90.0 + ((180.0 * rand()) / RAND_MAX), .lon = -180.0 + ((360.0 * rand()) / RAND_MAX) };
+		proteus_WaveData expected;
+		proteus_WaveData wd;
+
+		const bool valid = proteus_WaveCtx_get(ctx, &p, &expected);
+		EQUALS(valid, proteus_WaveCtx_get(tctx, &p, &wd));
+
+		if (valid)
+		{
+			count++;
+			EQUALS_FLT(expected.waveHeight, wd.waveHeight);
+		}
+	}
+
+	IS_TRUE(count > INGEST_TEST_POSITIONS / 2);
+
+	proteus_WaveCtx_destroy(ctx);
+	proteus_WaveCtx_destroy(tctx);
+
+	unlink(file);
+	rmdir(dir);
+
+	return 0;
+}
+
 static bool validLonLat(double lon, double lat)
 {
 	return (lon >= -180.0 && lon <= 180.0 && lat >= -90.0 && lat <= 90.0);
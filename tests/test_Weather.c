@@ -14,17 +14,44 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
 #include "tests.h"
 #include "tests_assert.h"
 
+#include "proteus/Scheduler.h"
 #include "proteus/Weather.h"
 
 static int test_grid_1p00();
+static int test_snapshot_1p00();
+static int test_parallel_ingest_1p00();
+static int test_batch_1p00();
+static int test_fields_1p00();
+static int test_time_1p00();
+static int test_timeline();
+static int test_cache_1p00();
+static int test_blend();
+static int test_quantize_1p00();
+static int test_tiled_0p25();
+static int test_huge_pages_1p00();
+static int test_scheduler_1p00();
+static int test_watch_1p00();
+static int test_gzip_1p00();
+static int test_region();
+static int test_ctx_1p00();
+static int test_segment_1p00();
 static int test_grid_0p50();
 static int test_grid_0p25();
 
 static int test_out_of_bounds_geo();
 static bool validLonLat(double lon, double lat);
+static int gzipFile(const char* srcDir, const char* name, const char* dstDir, int members);
+static int checkRegion(int sourceDataGrid, const char* dir, const proteus_WeatherRegion* region, double cell);
 
 int test_Weather_run()
 {
@@ -36,6 +63,91 @@ int test_Weather_run()
 		return 1;
 	}
 
+	if (test_snapshot_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_parallel_ingest_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_batch_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_fields_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_time_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_timeline() != 0)
+	{
+		return 1;
+	}
+
+	if (test_cache_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_blend() != 0)
+	{
+		return 1;
+	}
+
+	if (test_quantize_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_tiled_0p25() != 0)
+	{
+		return 1;
+	}
+
+	if (test_huge_pages_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_scheduler_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_watch_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_gzip_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_region() != 0)
+	{
+		return 1;
+	}
+
+	if (test_ctx_1p00() != 0)
+	{
+		return 1;
+	}
+
+	if (test_segment_1p00() != 0)
+	{
+		return 1;
+	}
+
 	if (test_grid_0p50() != 0)
 	{
 		return 1;
@@ -192,10 +304,1615 @@ static int test_spatial_interpolation_1p00()
 }
 
 
-#define WEATHER_DIR_0P50_1 "./test_data/weather_0p50_f1/"
-#define WEATHER_DIR_0P50_2 "./test_data/weather_0p50_f1/"
+static int test_snapshot_1p00()
+{
+	char snapDir[] = "/tmp/proteus_test_wx_XXXXXX";
+	char snapFile[sizeof(snapDir) + 64];
 
-static int test_spatial_interpolation_0p50();
+	if (!mkdtemp(snapDir))
+	{
+		return 1;
+	}
+
+	snprintf(snapFile, sizeof(snapFile), "%s/%s", snapDir, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME);
+
+	int rc = 1;
+
+	if (0 != proteus_Weather_writeSnapshot(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, snapFile))
+	{
+		goto done;
+	}
+
+	// The snapshot directory has no CSV files, so this can only succeed by loading the snapshot.
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, snapDir, snapDir))
+	{
+		goto done;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+
+	p.lat = 44.0;
+	p.lon = -63.0;
+	if (!proteus_Weather_get(&p, &wx, false) ||
+			fabsf(wx.temp - (293.161f - 273.15f)) > PROTEUS_FLT_EPSILON ||
+			fabsf(wx.dewpoint - (290.822f - 273.15f)) > PROTEUS_FLT_EPSILON ||
+			fabsf(wx.windGust - 12.166f) > PROTEUS_FLT_EPSILON)
+	{
+		goto done;
+	}
+
+	if (test_spatial_interpolation_1p00() != 0)
+	{
+		goto done;
+	}
+
+	// Corrupt one byte of the payload, which must cause the snapshot to be rejected.
+	FILE* fp = fopen(snapFile, "r+b");
+	if (!fp || fseek(fp, -1, SEEK_END) != 0 || fputc(0x5a, fp) == EOF)
+	{
+		if (fp)
+		{
+			fclose(fp);
+		}
+		goto done;
+	}
+	fclose(fp);
+
+	if (0 == proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, snapDir, snapDir))
+	{
+		goto done;
+	}
+
+	rc = 0;
+
+done:
+	unlink(snapFile);
+	rmdir(snapDir);
+
+	return rc;
+}
+
+static int test_parallel_ingest_1p00()
+{
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+
+	opts.ingestThreads = 0;
+	IS_FALSE(0 == proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &opts));
+
+	opts.ingestThreads = 4;
+	if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &opts))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+
+	p.lat = 44.0;
+	p.lon = -63.0;
+	IS_TRUE(proteus_Weather_get(&p, &wx, false));
+	EQUALS_FLT(293.161f - 273.15f, wx.temp);
+	EQUALS_FLT(290.822f - 273.15f, wx.dewpoint);
+	EQUALS_FLT(12.166f, wx.windGust);
+
+	return test_spatial_interpolation_1p00();
+}
+
+#define BATCH_TEST_COUNT (1003)
+
+static int test_batch_1p00()
+{
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos* pos = malloc(BATCH_TEST_COUNT * sizeof(proteus_GeoPos));
+	proteus_Weather* wx = malloc(BATCH_TEST_COUNT * sizeof(proteus_Weather));
+	bool* valid = malloc(BATCH_TEST_COUNT * sizeof(bool));
+	if (!pos || !wx || !valid)
+	{
+		return 1;
+	}
+
+	// Cover the whole globe (including grid edges, wraparound and poles), with some invalid positions mixed in.
+	size_t validCount = 0;
+	for (int i = 0; i < BATCH_TEST_COUNT; i++)
+	{
+		pos[i].lat = -91.0 + ((182.0 * i) / (BATCH_TEST_COUNT - 1));
+		pos[i].lon = 180.5 - ((361.0 * ((i * 37) % BATCH_TEST_COUNT)) / (BATCH_TEST_COUNT - 1));
+
+		if (i % 97 == 0)
+		{
+			pos[i].lon = 180.0;
+		}
+
+		if (validLonLat(pos[i].lon, pos[i].lat))
+		{
+			validCount++;
+		}
+	}
+
+	for (int w = 0; w < 2; w++)
+	{
+		const bool windOnly = (w == 1);
+
+		EQUALS(validCount, proteus_Weather_getBatch(pos, BATCH_TEST_COUNT, wx, valid, windOnly));
+
+		for (int i = 0; i < BATCH_TEST_COUNT; i++)
+		{
+			proteus_Weather expected;
+			EQUALS(valid[i], proteus_Weather_get(pos + i, &expected, windOnly));
+
+			if (!valid[i])
+			{
+				continue;
+			}
+
+			// Batch results are computed exactly as single query results are.
+			EQUALS(expected.wind.angle, wx[i].wind.angle);
+			EQUALS(expected.wind.mag, wx[i].wind.mag);
+			EQUALS(expected.windGust, wx[i].windGust);
+
+			if (!windOnly)
+			{
+				EQUALS(expected.temp, wx[i].temp);
+				EQUALS(expected.dewpoint, wx[i].dewpoint);
+				EQUALS(expected.pressure, wx[i].pressure);
+				EQUALS(expected.cloud, wx[i].cloud);
+				EQUALS(expected.visibility, wx[i].visibility);
+				EQUALS(expected.prate, wx[i].prate);
+				EQUALS(expected.cond, wx[i].cond);
+			}
+		}
+	}
+
+	// Partial and empty batches
+	EQUALS(1, proteus_Weather_getBatch(pos + 500, 1, wx, 0, false));
+	EQUALS(0, proteus_Weather_getBatch(pos, 0, wx, valid, false));
+
+	free(pos);
+	free(wx);
+	free(valid);
+
+	return 0;
+}
+
+static int test_fields_1p00()
+{
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather all;
+	proteus_Weather wx;
+
+	p.lat = 44.3;
+	p.lon = -63.6;
+	IS_TRUE(proteus_Weather_get(&p, &all, false));
+
+	// Requested fields match those of a full query, and others are left untouched.
+	memset(&wx, 0, sizeof(wx));
+	wx.temp = -999.0;
+	wx.visibility = -999.0;
+	IS_TRUE(proteus_Weather_getFields(&p, &wx, PROTEUS_WX_FIELD_WIND | PROTEUS_WX_FIELD_PRESSURE));
+	EQUALS(all.wind.angle, wx.wind.angle);
+	EQUALS(all.wind.mag, wx.wind.mag);
+	EQUALS(all.pressure, wx.pressure);
+	EQUALS(-999.0, wx.temp);
+	EQUALS(-999.0, wx.visibility);
+	EQUALS(0.0, wx.windGust);
+
+	memset(&wx, 0, sizeof(wx));
+	wx.cond = 0xff;
+	IS_TRUE(proteus_Weather_getFields(&p, &wx, PROTEUS_WX_FIELD_VISIBILITY | PROTEUS_WX_FIELD_COND));
+	EQUALS(all.visibility, wx.visibility);
+	EQUALS(all.cond, wx.cond);
+	EQUALS(0.0, wx.wind.angle);
+	EQUALS(0.0, wx.wind.mag);
+	EQUALS(0.0, wx.pressure);
+
+	// Gust speed alone still accounts for the wind vector's magnitude.
+	memset(&wx, 0, sizeof(wx));
+	IS_TRUE(proteus_Weather_getFields(&p, &wx, PROTEUS_WX_FIELD_WIND_GUST));
+	EQUALS(all.windGust, wx.windGust);
+	EQUALS(0.0, wx.wind.mag);
+
+	memset(&wx, 0, sizeof(wx));
+	IS_TRUE(proteus_Weather_getFields(&p, &wx, PROTEUS_WX_FIELD_ALL));
+	EQUALS(all.temp, wx.temp);
+	EQUALS(all.dewpoint, wx.dewpoint);
+	EQUALS(all.cloud, wx.cloud);
+	EQUALS(all.prate, wx.prate);
+	EQUALS(all.windGust, wx.windGust);
+
+	memset(&wx, 0, sizeof(wx));
+	EQUALS(1, proteus_Weather_getBatchFields(&p, 1, &wx, 0, PROTEUS_WX_FIELD_TEMP | PROTEUS_WX_FIELD_DEWPOINT));
+	EQUALS(all.temp, wx.temp);
+	EQUALS(all.dewpoint, wx.dewpoint);
+	EQUALS(0.0, wx.wind.mag);
+	EQUALS(0.0, wx.windGust);
+
+	p.lat = 91.0;
+	IS_FALSE(proteus_Weather_getFields(&p, &wx, PROTEUS_WX_FIELD_ALL));
+
+	return 0;
+}
+
+static int test_time_1p00()
+{
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p[2];
+	proteus_Weather now;
+	proteus_Weather wx[2];
+
+	p[0].lat = 44.3;
+	p[0].lon = -63.6;
+	p[1].lat = -36.5;
+	p[1].lon = 179.5;
+	IS_TRUE(proteus_Weather_get(p, &now, false));
+
+	// Both forecast points are the same, so the query time doesn't matter (and is clamped outside of the forecast window).
+	const time_t times[] = { time(0), time(0) - 86400, time(0) + 86400, 0 };
+	for (size_t i = 0; i < sizeof(times) / sizeof(time_t); i++)
+	{
+		IS_TRUE(proteus_Weather_getAt(p, times[i], wx, PROTEUS_WX_FIELD_ALL));
+		EQUALS(now.wind.angle, wx[0].wind.angle);
+		EQUALS(now.wind.mag, wx[0].wind.mag);
+		EQUALS(now.temp, wx[0].temp);
+		EQUALS(now.pressure, wx[0].pressure);
+		EQUALS(now.cond, wx[0].cond);
+
+		EQUALS(2, proteus_Weather_getBatchAt(p, 2, times[i], wx, 0, PROTEUS_WX_FIELD_ALL));
+		EQUALS(now.wind.angle, wx[0].wind.angle);
+		EQUALS(now.temp, wx[0].temp);
+		EQUALS(now.cond, wx[0].cond);
+	}
+
+	p[0].lat = 91.0;
+	IS_FALSE(proteus_Weather_getAt(p, time(0), wx, PROTEUS_WX_FIELD_ALL));
+
+	return 0;
+}
+
+#define TIMELINE_TEST_STEPS (4)
+
+static const char* WX_CSV_FILE_NAMES[] = {
+	"ugrd.csv", "vgrd.csv", "gust.csv", "tmp.csv", "dpt.csv", "pres.csv", "cld.csv",
+	"vis.csv", "prate.csv", "rain.csv", "snow.csv", "icep.csv", "frzr.csv"
+};
+
+#define WX_CSV_FILE_COUNT (sizeof(WX_CSV_FILE_NAMES) / sizeof(const char*))
+
+// Writes forecast data with a single grid point (at 0,0), where only the temperature is set.
+static int writeTimelineStep(const char* dir, float tempC, bool remove)
+{
+	for (size_t i = 0; i < WX_CSV_FILE_COUNT; i++)
+	{
+		char filePath[256];
+		snprintf(filePath, sizeof(filePath), "%s/%s", dir, WX_CSV_FILE_NAMES[i]);
+
+		if (remove)
+		{
+			unlink(filePath);
+			continue;
+		}
+
+		FILE* fp = fopen(filePath, "w");
+		if (!fp)
+		{
+			return 1;
+		}
+
+		fprintf(fp, "0,0,%.3f\n", ((strcmp(WX_CSV_FILE_NAMES[i], "tmp.csv") == 0) ? tempC + 273.15f : 0.0f));
+		fclose(fp);
+	}
+
+	return 0;
+}
+
+static int test_timeline()
+{
+	char dirs[TIMELINE_TEST_STEPS][32];
+	const char* dirPtrs[TIMELINE_TEST_STEPS];
+	time_t validTimes[TIMELINE_TEST_STEPS];
+	time_t steps[TIMELINE_TEST_STEPS];
+
+	const time_t t0 = 1700000000;
+
+	int rc = 1;
+	int created = 0;
+
+	for (; created < TIMELINE_TEST_STEPS; created++)
+	{
+		strcpy(dirs[created], "/tmp/proteus_test_wx_XXXXXX");
+		if (!mkdtemp(dirs[created]) || writeTimelineStep(dirs[created], 10.0f * created, false) != 0)
+		{
+			goto done;
+		}
+
+		dirPtrs[created] = dirs[created];
+		validTimes[created] = t0 + (3600 * created);
+	}
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	opts.timelineSteps = 3;
+
+	// Timeline updates are only possible in timeline mode.
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2) ||
+			-3 != proteus_Weather_addStep(dirs[0], t0) ||
+			2 != proteus_Weather_getSteps(steps, TIMELINE_TEST_STEPS))
+	{
+		goto done;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+
+	p.lat = 0.0;
+	p.lon = 0.0;
+
+	// No steps yet, so no data
+	if (0 != proteus_Weather_initTimeline(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, 0, 0, 0, &opts) ||
+			proteus_Weather_getAt(&p, t0, &wx, PROTEUS_WX_FIELD_TEMP) ||
+			0 != proteus_Weather_getBatchAt(&p, 1, t0, &wx, 0, PROTEUS_WX_FIELD_TEMP))
+	{
+		goto done;
+	}
+
+	// Steps added out of order are kept in order of valid time.
+	if (0 != proteus_Weather_addStep(dirs[1], validTimes[1]) ||
+			0 != proteus_Weather_addStep(dirs[0], validTimes[0]) ||
+			0 != proteus_Weather_addStep(dirs[2], validTimes[2]) ||
+			3 != proteus_Weather_getSteps(steps, TIMELINE_TEST_STEPS) ||
+			steps[0] != validTimes[0] || steps[1] != validTimes[1] || steps[2] != validTimes[2])
+	{
+		goto done;
+	}
+
+	const struct
+	{
+		time_t t;
+		float temp;
+	} CHECKS[] = {
+		{ t0 - 3600, 0.0f }, // clamped
+		{ t0, 0.0f },
+		{ t0 + 900, 2.5f },
+		{ t0 + 3600, 10.0f },
+		{ t0 + 5400, 15.0f },
+		{ t0 + 7200, 20.0f },
+		{ t0 + 36000, 20.0f } // clamped
+	};
+
+	for (size_t i = 0; i < sizeof(CHECKS) / sizeof(CHECKS[0]); i++)
+	{
+		IS_TRUE(proteus_Weather_getAt(&p, CHECKS[i].t, &wx, PROTEUS_WX_FIELD_TEMP));
+		EQUALS_FLT(CHECKS[i].temp, wx.temp);
+
+		EQUALS(1, proteus_Weather_getBatchAt(&p, 1, CHECKS[i].t, &wx, 0, PROTEUS_WX_FIELD_TEMP));
+		EQUALS_FLT(CHECKS[i].temp, wx.temp);
+	}
+
+	// The timeline is full, so adding a step evicts the oldest one, and older steps are rejected.
+	EQUALS(0, proteus_Weather_addStep(dirs[3], validTimes[3]));
+	EQUALS(3, proteus_Weather_getSteps(steps, TIMELINE_TEST_STEPS));
+	EQUALS(validTimes[1], steps[0]);
+	EQUALS(-3, proteus_Weather_addStep(dirs[0], validTimes[0]));
+
+	IS_TRUE(proteus_Weather_getAt(&p, t0, &wx, PROTEUS_WX_FIELD_TEMP));
+	EQUALS_FLT(10.0f, wx.temp);
+	IS_TRUE(proteus_Weather_getAt(&p, t0 + 9000, &wx, PROTEUS_WX_FIELD_TEMP));
+	EQUALS_FLT(25.0f, wx.temp);
+
+	// A step with an existing valid time replaces that step.
+	EQUALS(0, proteus_Weather_addStep(dirs[0], validTimes[2]));
+	EQUALS(3, proteus_Weather_getSteps(steps, TIMELINE_TEST_STEPS));
+	IS_TRUE(proteus_Weather_getAt(&p, validTimes[2], &wx, PROTEUS_WX_FIELD_TEMP));
+	EQUALS_FLT(0.0f, wx.temp);
+
+	// Steps before the one bracketing the given time are evicted.
+	EQUALS(0, proteus_Weather_evictSteps(validTimes[2] - 1));
+	EQUALS(1, proteus_Weather_evictSteps(validTimes[2] + 1));
+	EQUALS(2, proteus_Weather_getSteps(steps, 1));
+	EQUALS(validTimes[2], steps[0]);
+
+	// Initial steps may be provided as a directory list (up to the maximum number of steps).
+	EQUALS(-3, proteus_Weather_initTimeline(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dirPtrs, validTimes, TIMELINE_TEST_STEPS, &opts));
+	EQUALS(0, proteus_Weather_initTimeline(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dirPtrs + 1, validTimes + 1, 3, &opts));
+	EQUALS(3, proteus_Weather_getSteps(steps, TIMELINE_TEST_STEPS));
+	IS_TRUE(proteus_Weather_getAt(&p, t0 + 9000, &wx, PROTEUS_WX_FIELD_TEMP));
+	EQUALS_FLT(25.0f, wx.temp);
+
+	rc = 0;
+
+done:
+	for (int i = 0; i < created; i++)
+	{
+		writeTimelineStep(dirs[i], 0.0f, true);
+		rmdir(dirs[i]);
+	}
+
+	return rc;
+}
+
+static int test_cache_1p00()
+{
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	proteus_WeatherCache* cache = proteus_Weather_createCache();
+	if (!cache)
+	{
+		return 1;
+	}
+
+	proteus_WeatherCacheStats stats;
+	proteus_Weather_getCacheStats(cache, &stats);
+	EQUALS(0, stats.hits);
+	EQUALS(0, stats.misses);
+
+	const time_t t = time(0);
+
+	proteus_GeoPos p;
+	proteus_Weather expected;
+	proteus_Weather wx;
+
+	// Move east across three grid cells, in steps of 0.01 degrees (so, 300 queries in total).
+	p.lat = 44.55;
+	for (int i = 0; i < 300; i++)
+	{
+		p.lon = -63.995 + (0.01 * i);
+
+		// Alternate between wind-only and full queries, so that fields are loaded into the cache lazily.
+		const uint32_t fields = ((i % 2 == 0) ? (PROTEUS_WX_FIELD_WIND | PROTEUS_WX_FIELD_WIND_GUST) : PROTEUS_WX_FIELD_ALL);
+
+		IS_TRUE(proteus_Weather_getAt(&p, t, &expected, fields));
+		IS_TRUE(proteus_Weather_getCached(cache, &p, t, &wx, fields));
+
+		EQUALS(expected.wind.angle, wx.wind.angle);
+		EQUALS(expected.wind.mag, wx.wind.mag);
+		EQUALS(expected.windGust, wx.windGust);
+
+		if (fields == PROTEUS_WX_FIELD_ALL)
+		{
+			EQUALS(expected.temp, wx.temp);
+			EQUALS(expected.dewpoint, wx.dewpoint);
+			EQUALS(expected.pressure, wx.pressure);
+			EQUALS(expected.cloud, wx.cloud);
+			EQUALS(expected.visibility, wx.visibility);
+			EQUALS(expected.prate, wx.prate);
+			EQUALS(expected.cond, wx.cond);
+		}
+	}
+
+	proteus_Weather_getCacheStats(cache, &stats);
+	EQUALS(297, stats.hits);
+	EQUALS(3, stats.misses);
+
+	// Invalid positions don't touch the cache.
+	p.lat = 91.0;
+	IS_FALSE(proteus_Weather_getCached(cache, &p, t, &wx, PROTEUS_WX_FIELD_ALL));
+
+	// New weather grids invalidate the cache.
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	p.lat = 44.55;
+	IS_TRUE(proteus_Weather_getCached(cache, &p, t, &wx, PROTEUS_WX_FIELD_ALL));
+	IS_TRUE(proteus_Weather_getAt(&p, t, &expected, PROTEUS_WX_FIELD_ALL));
+	EQUALS(expected.temp, wx.temp);
+
+	proteus_Weather_getCacheStats(cache, &stats);
+	EQUALS(297, stats.hits);
+	EQUALS(4, stats.misses);
+
+	proteus_Weather_freeCache(cache);
+
+	return 0;
+}
+
+static int test_blend()
+{
+	char dirs[2][32];
+	const char* dirPtrs[2];
+	time_t validTimes[2];
+
+	const time_t now = time(0);
+
+	int rc = 1;
+	int created = 0;
+
+	for (; created < 2; created++)
+	{
+		strcpy(dirs[created], "/tmp/proteus_test_wx_XXXXXX");
+		if (!mkdtemp(dirs[created]) || writeTimelineStep(dirs[created], 10.0f * created, false) != 0)
+		{
+			goto done;
+		}
+
+		dirPtrs[created] = dirs[created];
+		validTimes[created] = now - 1800 + (3600 * created);
+	}
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	opts.blendInterval = 60;
+
+	if (0 != proteus_Weather_initTimeline(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dirPtrs, validTimes, 2, &opts))
+	{
+		goto done;
+	}
+
+	const time_t blendTime = proteus_Weather_getBlendTime();
+	if (blendTime < now || blendTime > time(0))
+	{
+		goto done;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+	proteus_Weather expected;
+
+	p.lat = 0.0;
+	p.lon = 0.0;
+
+	// Current time queries use the grid blended for the blend time.
+	IS_TRUE(proteus_Weather_get(&p, &wx, false));
+	IS_TRUE(proteus_Weather_getAt(&p, blendTime, &expected, PROTEUS_WX_FIELD_ALL));
+	EQUALS_FLT(expected.temp, wx.temp);
+	EQUALS_FLT(5.0f + ((blendTime - now) / 360.0f), wx.temp);
+
+	EQUALS(1, proteus_Weather_getBatch(&p, 1, &wx, 0, false));
+	EQUALS_FLT(expected.temp, wx.temp);
+
+	// Queries at a given time don't use the time-blended grid.
+	IS_TRUE(proteus_Weather_getAt(&p, validTimes[1], &wx, PROTEUS_WX_FIELD_ALL));
+	EQUALS_FLT(10.0f, wx.temp);
+
+	// The time-blended grid is refreshed when forecast steps change.
+	EQUALS(0, proteus_Weather_addStep(dirs[0], validTimes[1]));
+	IS_TRUE(proteus_Weather_get(&p, &wx, false));
+	EQUALS_FLT(0.0f, wx.temp);
+
+	// Two forecast point mode also supports time-blended grids.
+	if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &opts) ||
+			0 == proteus_Weather_getBlendTime())
+	{
+		goto done;
+	}
+
+	p.lat = 44.0;
+	p.lon = -63.0;
+	IS_TRUE(proteus_Weather_get(&p, &wx, false));
+	EQUALS_FLT(293.161f - 273.15f, wx.temp);
+	EQUALS_FLT(290.822f - 273.15f, wx.dewpoint);
+	EQUALS_FLT(12.166f, wx.windGust);
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2) ||
+			0 != proteus_Weather_getBlendTime())
+	{
+		goto done;
+	}
+
+	rc = 0;
+
+done:
+	for (int i = 0; i < created; i++)
+	{
+		writeTimelineStep(dirs[i], 0.0f, true);
+		rmdir(dirs[i]);
+	}
+
+	return rc;
+}
+
+#define WEATHER_DIR_0P50_1 "./test_data/weather_0p50_f1/"
+#define WEATHER_DIR_0P50_2 "./test_data/weather_0p50_f1/"
+
+static int test_spatial_interpolation_0p50();
+
+#define QUANTIZE_TEST_POSITIONS (500)
+
+static int test_quantize_1p00()
+{
+	proteus_GeoPos pos[QUANTIZE_TEST_POSITIONS];
+	proteus_Weather expected[QUANTIZE_TEST_POSITIONS];
+	proteus_Weather wx[QUANTIZE_TEST_POSITIONS];
+	bool valid[QUANTIZE_TEST_POSITIONS];
+
+	srand(12);
+	for (int i = 0; i < QUANTIZE_TEST_POSITIONS; i++)
+	{
+		pos[i].lat = -90.0 + ((180.0 * rand()) / RAND_MAX);
+		pos[i].lon = -180.0 + ((360.0 * rand()) / RAND_MAX);
+	}
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	for (int i = 0; i < QUANTIZE_TEST_POSITIONS; i++)
+	{
+		IS_TRUE(proteus_Weather_get(pos + i, expected + i, false));
+	}
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	IS_FALSE(opts.quantize);
+	opts.quantize = true;
+
+	if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &opts))
+	{
+		return 1;
+	}
+
+	// Results are within the documented error bounds (plus some slack for the float results).
+	int diffs = 0;
+	for (int i = 0; i < QUANTIZE_TEST_POSITIONS; i++)
+	{
+		IS_TRUE(proteus_Weather_get(pos + i, wx + i, false));
+
+		if (wx[i].temp != expected[i].temp)
+		{
+			diffs++;
+		}
+
+		IS_TRUE(fabs(wx[i].wind.mag - expected[i].wind.mag) <= 0.003);
+		IS_TRUE(fabs(wx[i].windGust - expected[i].windGust) <= 0.003);
+		IS_TRUE(fabs(wx[i].temp - expected[i].temp) <= 0.0021);
+		IS_TRUE(fabs(wx[i].dewpoint - expected[i].dewpoint) <= 0.0021);
+		IS_TRUE(fabs(wx[i].pressure - expected[i].pressure) <= 0.0026);
+		IS_TRUE(fabs(wx[i].cloud - expected[i].cloud) <= 0.0011);
+		IS_TRUE(fabs(wx[i].visibility - expected[i].visibility) <= 0.26);
+		IS_TRUE(fabs(wx[i].prate - expected[i].prate) <= 0.0019);
+		EQUALS(expected[i].cond, wx[i].cond);
+	}
+
+	// (Make sure that the grids really were quantized.)
+	IS_TRUE(diffs > 0);
+
+	// Batch queries dequantize exactly as single queries do.
+	proteus_Weather batch[QUANTIZE_TEST_POSITIONS];
+	EQUALS(QUANTIZE_TEST_POSITIONS, proteus_Weather_getBatch(pos, QUANTIZE_TEST_POSITIONS, batch, valid, false));
+
+	for (int i = 0; i < QUANTIZE_TEST_POSITIONS; i++)
+	{
+		IS_TRUE(valid[i]);
+		EQUALS(wx[i].wind.mag, batch[i].wind.mag);
+		EQUALS(wx[i].temp, batch[i].temp);
+		EQUALS(wx[i].pressure, batch[i].pressure);
+		EQUALS(wx[i].visibility, batch[i].visibility);
+	}
+
+	// Back to the defaults (unquantized grids), for the tests that follow.
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+// The 0.25 degree grid is tiled, so load it from the 1.00 degree data (which fills every fourth point of it), and check it against the 1.00 degree grid.
+// The same goes for the grid stored row by row, whether loaded from the CSV files or converted from a (tiled) snapshot.
+static int test_tiled_0p25()
+{
+	const int gridX = 360;
+	const int gridY = 181;
+
+	char snapDir[] = "/tmp/proteus_test_wx_XXXXXX";
+	char snapFile[sizeof(snapDir) + 64];
+
+	if (!mkdtemp(snapDir))
+	{
+		return 1;
+	}
+
+	snprintf(snapFile, sizeof(snapFile), "%s/%s", snapDir, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME);
+
+	proteus_Weather* expected = malloc(gridX * gridY * sizeof(proteus_Weather));
+	if (!expected)
+	{
+		rmdir(snapDir);
+		return 1;
+	}
+
+	int rc = 1;
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		goto done;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+
+	for (int y = 0; y < gridY; y++)
+	{
+		for (int x = 0; x < gridX; x++)
+		{
+			p.lat = y - 90.0;
+			p.lon = x - 180.0;
+			if (!proteus_Weather_get(&p, expected + (y * gridX) + x, false))
+			{
+				goto done;
+			}
+		}
+	}
+
+	if (0 != proteus_Weather_writeSnapshot(PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25, WEATHER_DIR_1P00_1, snapFile))
+	{
+		goto done;
+	}
+
+	// Tiled, then row by row (from the CSV files, then with the first forecast point from the snapshot)
+	for (int layout = 0; layout < 3; layout++)
+	{
+		proteus_WeatherOptions opts;
+		proteus_Weather_getDefaultOptions(&opts);
+		opts.rowMajor = (layout != 0);
+
+		if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25, ((layout == 2) ? snapDir : WEATHER_DIR_1P00_1), WEATHER_DIR_1P00_2, &opts))
+		{
+			goto done;
+		}
+
+		for (int y = 0; y < gridY; y++)
+		{
+			for (int x = 0; x < gridX; x++)
+			{
+				const proteus_Weather* e = expected + (y * gridX) + x;
+
+				// Same values at the shared grid points
+				p.lat = y - 90.0;
+				p.lon = x - 180.0;
+				if (!proteus_Weather_get(&p, &wx, false) ||
+						wx.temp != e->temp ||
+						wx.pressure != e->pressure ||
+						wx.windGust != e->windGust ||
+						wx.cond != e->cond)
+				{
+					printf("\tMismatch at lon=%f lat=%f\n", p.lon, p.lat);
+					goto done;
+				}
+
+				// Half of the values, between each shared grid point and the empty (zero) grid point
+				// to the west or south of it (so also across the edges of tiles)
+				if (x > 0 && y > 0)
+				{
+					p.lon = x - 180.0 - 0.125;
+					if (!proteus_Weather_get(&p, &wx, false) || fabs(wx.windGust - (0.5 * e->windGust)) > 0.0001)
+					{
+						printf("\tMismatch at lon=%f lat=%f\n", p.lon, p.lat);
+						goto done;
+					}
+
+					p.lon = x - 180.0;
+					p.lat = y - 90.0 - 0.125;
+					if (!proteus_Weather_get(&p, &wx, false) || fabs(wx.windGust - (0.5 * e->windGust)) > 0.0001)
+					{
+						printf("\tMismatch at lon=%f lat=%f\n", p.lon, p.lat);
+						goto done;
+					}
+				}
+			}
+		}
+	}
+
+	rc = 0;
+
+done:
+	free(expected);
+	unlink(snapFile);
+	rmdir(snapDir);
+
+	// Back to the 1.00 degree grid, for the tests that follow.
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	return rc;
+}
+
+// Grids backed by huge pages (or regular pages, if none are available) hold the same data.
+static int test_huge_pages_1p00()
+{
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather expected;
+	proteus_Weather wx;
+
+	p.lat = 44.55;
+	p.lon = -63.45;
+	IS_TRUE(proteus_Weather_get(&p, &expected, false));
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	IS_FALSE(opts.hugePages);
+	opts.hugePages = true;
+	opts.blendInterval = 60;
+
+	// (Twice, so that the grid pools are reset and set up again.)
+	for (int i = 0; i < 2; i++)
+	{
+		if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &opts))
+		{
+			return 1;
+		}
+
+		IS_TRUE(proteus_Weather_get(&p, &wx, false));
+		EQUALS(expected.temp, wx.temp);
+		EQUALS(expected.pressure, wx.pressure);
+		EQUALS(expected.windGust, wx.windGust);
+	}
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_scheduler_1p00()
+{
+	// 2026-01-01 00:30Z
+	const time_t t0 = 1767227400;
+	tests_fakeTime = t0;
+
+	proteus_Scheduler_setClock(&tests_fakeClock);
+
+	// (Twice, so that the first update job is cancelled on re-init.)
+	for (int i = 0; i < 2; i++)
+	{
+		if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+		{
+			return 1;
+		}
+	}
+
+	// Next update at 01:15Z.
+	EQUALS(t0 + 2700, proteus_Scheduler_getNextTime());
+	EQUALS(0, proteus_Scheduler_runDue());
+
+	tests_fakeTime = t0 + 2699;
+	EQUALS(0, proteus_Scheduler_runDue());
+
+	tests_fakeTime = t0 + 2700;
+	EQUALS(1, proteus_Scheduler_runDue());
+	EQUALS(0, proteus_Scheduler_runDue());
+
+	// Then every three hours.
+	EQUALS(t0 + 2700 + 10800, proteus_Scheduler_getNextTime());
+
+	// Updates missed (while the clock jumped ahead) are skipped, rather than run back to back.
+	tests_fakeTime = t0 + 2700 + (3 * 10800) + 60;
+	EQUALS(1, proteus_Scheduler_runDue());
+	EQUALS(t0 + 2700 + (4 * 10800), proteus_Scheduler_getNextTime());
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+	p.lat = 44.55;
+	p.lon = -63.45;
+	IS_TRUE(proteus_Weather_get(&p, &wx, false));
+
+	// Blend refreshes are scheduled alongside the updates.
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	opts.blendInterval = 60;
+
+	if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &opts))
+	{
+		return 1;
+	}
+
+	EQUALS(tests_fakeTime + 60, proteus_Scheduler_getNextTime());
+	tests_fakeTime += 60;
+	EQUALS(1, proteus_Scheduler_runDue());
+	EQUALS(tests_fakeTime + 60, proteus_Scheduler_getNextTime());
+
+	proteus_Scheduler_setClock(0);
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_watch_1p00()
+{
+	char dir[] = "/tmp/proteus_test_watch_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	for (size_t i = 0; i < WX_CSV_FILE_COUNT; i++)
+	{
+		EQUALS(0, tests_copyFile(WEATHER_DIR_1P00_1, WX_CSV_FILE_NAMES[i], dir, WX_CSV_FILE_NAMES[i]));
+	}
+
+	// 2026-01-01 00:30Z (next scheduled update at 01:15Z)
+	const time_t t0 = 1767227400;
+	tests_fakeTime = t0;
+
+	proteus_Scheduler_setClock(&tests_fakeClock);
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	IS_FALSE(opts.watchFiles);
+	opts.watchFiles = true;
+
+	if (0 != proteus_Weather_initWithOptions(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dir, dir, &opts))
+	{
+		return 1;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather expected;
+	proteus_Weather wx;
+	p.lat = 44.55;
+	p.lon = -63.45;
+	IS_TRUE(proteus_Weather_get(&p, &expected, false));
+
+	time_t steps0[2];
+	time_t steps[2];
+	EQUALS(2, proteus_Weather_getSteps(steps0, 2));
+
+	// Rewriting a file with the same contents triggers a reload, which is skipped.
+	EQUALS(0, tests_copyFile(WEATHER_DIR_1P00_1, "tmp.csv", dir, "tmp.csv"));
+
+	time_t reloadTime = tests_waitForNextTimeBefore(t0 + 2700);
+	IS_TRUE(reloadTime > t0 && reloadTime < t0 + 2700);
+
+	tests_fakeTime = reloadTime;
+	EQUALS(1, proteus_Scheduler_runDue());
+	EQUALS(2, proteus_Weather_getSteps(steps, 2));
+	EQUALS(steps0[0], steps[0]);
+	EQUALS(steps0[1], steps[1]);
+
+	// Changed data is loaded (here with dew point temperature values in place of temperature values).
+	EQUALS(0, tests_copyFile(WEATHER_DIR_1P00_1, "dpt.csv", dir, "tmp.csv"));
+
+	reloadTime = tests_waitForNextTimeBefore(t0 + 2700);
+	IS_TRUE(reloadTime > tests_fakeTime && reloadTime < t0 + 2700);
+
+	tests_fakeTime = reloadTime;
+	EQUALS(1, proteus_Scheduler_runDue());
+	EQUALS(2, proteus_Weather_getSteps(steps, 2));
+	EQUALS(reloadTime, steps[0]);
+	IS_TRUE(steps[1] > reloadTime);
+
+	// (Well past the phase time, so only the latest data is used.)
+	IS_TRUE(proteus_Weather_getAt(&p, steps[1] + 3600, &wx, PROTEUS_WX_FIELD_TEMP));
+	EQUALS_FLT(expected.dewpoint, wx.temp);
+
+	// The scheduled update (from the same directory) is skipped, as its data is already loaded.
+	EQUALS(2, proteus_Weather_getSteps(steps0, 2));
+
+	tests_fakeTime = t0 + 2700;
+	EQUALS(1, proteus_Scheduler_runDue());
+	EQUALS(2, proteus_Weather_getSteps(steps, 2));
+	EQUALS(steps0[0], steps[0]);
+	EQUALS(steps0[1], steps[1]);
+
+	proteus_Scheduler_setClock(0);
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	char path[256];
+	for (size_t i = 0; i < WX_CSV_FILE_COUNT; i++)
+	{
+		snprintf(path, sizeof(path), "%s/%s", dir, WX_CSV_FILE_NAMES[i]);
+		unlink(path);
+	}
+
+	rmdir(dir);
+
+	return 0;
+}
+
+static int test_gzip_1p00()
+{
+	char dir[] = "/tmp/proteus_test_gzip_XXXXXX";
+	IS_TRUE(mkdtemp(dir) != 0);
+
+	// Every other file compressed (with the temperature data as two concatenated gzip members).
+	for (size_t i = 0; i < WX_CSV_FILE_COUNT; i++)
+	{
+		if (i % 2 == 0)
+		{
+			EQUALS(0, tests_copyFile(WEATHER_DIR_1P00_1, WX_CSV_FILE_NAMES[i], dir, WX_CSV_FILE_NAMES[i]));
+		}
+		else
+		{
+			EQUALS(0, gzipFile(WEATHER_DIR_1P00_1, WX_CSV_FILE_NAMES[i], dir, ((strcmp(WX_CSV_FILE_NAMES[i], "tmp.csv") == 0) ? 2 : 1)));
+		}
+	}
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	const double lats[] = { 44.55, -36.2, 0.0, 71.9, -60.5 };
+	const double lons[] = { -63.45, 0.0, 179.5, -120.25, 20.0 };
+	const int n = (int) (sizeof(lats) / sizeof(double));
+
+	proteus_GeoPos p;
+	proteus_Weather expected[5];
+	proteus_Weather wx;
+
+	for (int i = 0; i < n; i++)
+	{
+		p.lat = lats[i];
+		p.lon = lons[i];
+		IS_TRUE(proteus_Weather_get(&p, &expected[i], false));
+	}
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dir, dir))
+	{
+		return 1;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		p.lat = lats[i];
+		p.lon = lons[i];
+		IS_TRUE(proteus_Weather_get(&p, &wx, false));
+		EQUALS(expected[i].wind.angle, wx.wind.angle);
+		EQUALS(expected[i].wind.mag, wx.wind.mag);
+		EQUALS(expected[i].windGust, wx.windGust);
+		EQUALS(expected[i].temp, wx.temp);
+		EQUALS(expected[i].dewpoint, wx.dewpoint);
+		EQUALS(expected[i].pressure, wx.pressure);
+		EQUALS(expected[i].cloud, wx.cloud);
+		EQUALS(expected[i].visibility, wx.visibility);
+		EQUALS(expected[i].prate, wx.prate);
+		EQUALS(expected[i].cond, wx.cond);
+	}
+
+	// Truncated compressed data fails to load.
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s.gz", dir, "vgrd.csv");
+
+	struct stat st;
+	EQUALS(0, stat(path, &st));
+	EQUALS(0, truncate(path, st.st_size / 2));
+
+	IS_TRUE(0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dir, dir));
+
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	for (size_t i = 0; i < WX_CSV_FILE_COUNT; i++)
+	{
+		snprintf(path, sizeof(path), "%s/%s%s", dir, WX_CSV_FILE_NAMES[i], ((i % 2 == 0) ? "" : ".gz"));
+		unlink(path);
+	}
+
+	rmdir(dir);
+
+	return 0;
+}
+
+
+static int test_region()
+{
+	char snapDir[] = "/tmp/proteus_test_wx_XXXXXX";
+	char snapFile[sizeof(snapDir) + 64];
+
+	if (!mkdtemp(snapDir))
+	{
+		return 1;
+	}
+
+	snprintf(snapFile, sizeof(snapFile), "%s/%s", snapDir, PROTEUS_WEATHER_SNAPSHOT_FILE_NAME);
+
+	int rc = 1;
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+
+	// North Atlantic, loaded from the CSV files
+	const proteus_WeatherRegion atlantic = { .west = -80.0, .east = 0.0, .south = 0.0, .north = 70.0, .margin = 2.0 };
+	if (0 != checkRegion(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, &atlantic, 1.0))
+	{
+		goto done;
+	}
+
+	// Across the 180 degree line of longitude, on a tiled grid, loaded from a snapshot
+	// (of the 1.00 degree data, as in test_tiled_0p25())
+	if (0 != proteus_Weather_writeSnapshot(PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25, WEATHER_DIR_1P00_1, snapFile))
+	{
+		goto done;
+	}
+
+	const proteus_WeatherRegion pacific = { .west = 170.0, .east = -170.0, .south = -10.0, .north = 10.0, .margin = 1.0 };
+	if (0 != checkRegion(PROTEUS_WEATHER_SOURCE_DATA_GRID_0P25, snapDir, &pacific, 0.25))
+	{
+		goto done;
+	}
+
+	// All longitudes, up to the north pole
+	const proteus_WeatherRegion arctic = { .west = -180.0, .east = 180.0, .south = 80.0, .north = 90.0, .margin = 0.0 };
+	if (0 != checkRegion(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, &arctic, 1.0))
+	{
+		goto done;
+	}
+
+	const proteus_WeatherRegion invalid = { .west = -80.0, .east = 0.0, .south = 10.0, .north = 0.0, .margin = 0.0 };
+	if (-3 != proteus_Weather_initRegion(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &invalid, &opts))
+	{
+		goto done;
+	}
+
+	rc = 0;
+
+done:
+	unlink(snapFile);
+	rmdir(snapDir);
+
+	// Back to the whole 1.00 degree grid, for the tests that follow.
+	if (0 != proteus_Weather_init(PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2))
+	{
+		return 1;
+	}
+
+	return rc;
+}
+
+static int test_ctx_1p00()
+{
+	proteus_WeatherCtx* ctx = proteus_WeatherCtx_create();
+	IS_TRUE(ctx != 0);
+	IS_TRUE(ctx != proteus_WeatherCtx_getDefault());
+
+	proteus_GeoPos p[2];
+	proteus_Weather wx[2];
+	proteus_Weather e;
+	bool valid[2];
+
+	// North Atlantic, and western Pacific
+	p[0].lat = 45.5;
+	p[0].lon = -40.25;
+	p[1].lat = 10.0;
+	p[1].lon = 150.0;
+
+	// Not initialized yet
+	IS_FALSE(proteus_WeatherCtx_get(ctx, &p[0], &wx[0], false));
+
+	// The context only holds a region, while the default context holds the whole grid.
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+
+	const proteus_WeatherRegion atlantic = { .west = -80.0, .east = 0.0, .south = 0.0, .north = 70.0, .margin = 2.0 };
+	if (0 != proteus_WeatherCtx_initRegion(ctx, PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, WEATHER_DIR_1P00_1, WEATHER_DIR_1P00_2, &atlantic, &opts))
+	{
+		return 1;
+	}
+
+	IS_TRUE(proteus_WeatherCtx_get(ctx, &p[0], &wx[0], false));
+	IS_TRUE(proteus_Weather_get(&p[0], &e, false));
+	EQUALS_DBL(e.temp, wx[0].temp);
+	EQUALS_DBL(e.pressure, wx[0].pressure);
+	EQUALS_DBL(e.wind.mag, wx[0].wind.mag);
+	EQUALS_DBL(e.wind.angle, wx[0].wind.angle);
+
+	IS_FALSE(proteus_WeatherCtx_get(ctx, &p[1], &wx[1], false));
+	IS_TRUE(proteus_Weather_get(&p[1], &e, false));
+	IS_TRUE(proteus_WeatherCtx_get(proteus_WeatherCtx_getDefault(), &p[1], &wx[1], false));
+	EQUALS_DBL(e.temp, wx[1].temp);
+
+	EQUALS(1, proteus_WeatherCtx_getBatch(ctx, p, 2, wx, valid, false));
+	IS_TRUE(valid[0]);
+	IS_FALSE(valid[1]);
+
+	EQUALS(2, proteus_Weather_getBatch(p, 2, wx, valid, false));
+
+	proteus_WeatherCtx_destroy(ctx);
+
+	// (The default context is never destroyed.)
+	proteus_WeatherCtx_destroy(proteus_WeatherCtx_getDefault());
+	IS_TRUE(proteus_Weather_get(&p[1], &wx[1], false));
+	EQUALS_DBL(e.temp, wx[1].temp);
+
+	return 0;
+}
+
+#define SEGMENT_TEST_SAMPLES (300)
+
+// Samples along a segment must match queries at the same positions (when sampled at a single time).
+static int checkSegment(const proteus_WeatherSegment* seg, proteus_GeoPos* pos)
+{
+	proteus_Weather wx[SEGMENT_TEST_SAMPLES];
+	bool valid[SEGMENT_TEST_SAMPLES];
+	proteus_Weather e;
+
+	EQUALS(SEGMENT_TEST_SAMPLES, proteus_Weather_sampleSegment(seg, SEGMENT_TEST_SAMPLES, pos, wx, valid, PROTEUS_WX_FIELD_ALL));
+
+	EQUALS_DBL(seg->start.lon, pos[0].lon);
+	EQUALS_DBL(seg->start.lat, pos[0].lat);
+	EQUALS_DBL(seg->end.lon, pos[SEGMENT_TEST_SAMPLES - 1].lon);
+	EQUALS_DBL(seg->end.lat, pos[SEGMENT_TEST_SAMPLES - 1].lat);
+
+	for (int i = 0; i < SEGMENT_TEST_SAMPLES; i++)
+	{
+		IS_TRUE(valid[i]);
+		IS_TRUE(pos[i].lon >= -180.0 && pos[i].lon < 180.0);
+		IS_TRUE(proteus_Weather_getAt(pos + i, seg->startTime, &e, PROTEUS_WX_FIELD_ALL));
+
+		if (wx[i].temp != e.temp ||
+				wx[i].dewpoint != e.dewpoint ||
+				wx[i].pressure != e.pressure ||
+				wx[i].cloud != e.cloud ||
+				wx[i].visibility != e.visibility ||
+				wx[i].prate != e.prate ||
+				wx[i].windGust != e.windGust ||
+				wx[i].wind.mag != e.wind.mag ||
+				wx[i].wind.angle != e.wind.angle ||
+				wx[i].cond != e.cond)
+		{
+			printf("\tMismatch at lon=%f lat=%f\n", pos[i].lon, pos[i].lat);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int test_segment_1p00()
+{
+	proteus_GeoPos pos[SEGMENT_TEST_SAMPLES];
+
+	proteus_WeatherSegment seg;
+	seg.greatCircle = false;
+	seg.startTime = time(0);
+	seg.speed = 0.0;
+
+	// Across the North Atlantic
+	seg.start.lon = -70.0;
+	seg.start.lat = 40.0;
+	seg.end.lon = -10.0;
+	seg.end.lat = 50.0;
+
+	if (checkSegment(&seg, pos) != 0)
+	{
+		return 1;
+	}
+
+	for (int i = 1; i < SEGMENT_TEST_SAMPLES; i++)
+	{
+		IS_TRUE(pos[i].lon > pos[i - 1].lon);
+		IS_TRUE(pos[i].lat > pos[i - 1].lat);
+	}
+
+	// The great circle bulges toward the pole (reaching about 49 degrees halfway along, rather than 45).
+	seg.greatCircle = true;
+
+	if (checkSegment(&seg, pos) != 0)
+	{
+		return 1;
+	}
+
+	IS_TRUE(pos[SEGMENT_TEST_SAMPLES / 2].lat > 48.5);
+
+	// Across the 180 degree line of longitude (the shorter way around)
+	seg.start.lon = 175.0;
+	seg.start.lat = -10.0;
+	seg.end.lon = -175.0;
+	seg.end.lat = 10.0;
+
+	for (int gc = 0; gc < 2; gc++)
+	{
+		seg.greatCircle = (gc == 1);
+
+		if (checkSegment(&seg, pos) != 0)
+		{
+			return 1;
+		}
+
+		for (int i = 0; i < SEGMENT_TEST_SAMPLES; i++)
+		{
+			IS_TRUE(pos[i].lon >= 175.0 - PROTEUS_DBL_EPSILON || pos[i].lon <= -175.0 + PROTEUS_DBL_EPSILON);
+		}
+	}
+
+	// A single sample is at the start.
+	proteus_Weather wx[2];
+	EQUALS(1, proteus_Weather_sampleSegment(&seg, 1, pos, wx, 0, PROTEUS_WX_FIELD_TEMP));
+	EQUALS_DBL(seg.start.lon, pos[0].lon);
+	EQUALS_DBL(seg.start.lat, pos[0].lat);
+
+	EQUALS(-3, proteus_Weather_sampleSegment(&seg, 0, pos, wx, 0, PROTEUS_WX_FIELD_TEMP));
+
+	seg.speed = -1.0;
+	EQUALS(-3, proteus_Weather_sampleSegment(&seg, 2, pos, wx, 0, PROTEUS_WX_FIELD_TEMP));
+	seg.speed = 0.0;
+
+	seg.end.lat = 91.0;
+	EQUALS(-3, proteus_Weather_sampleSegment(&seg, 2, pos, wx, 0, PROTEUS_WX_FIELD_TEMP));
+
+	// The great circle between antipodal points isn't defined (but the track is).
+	seg.start.lon = 0.0;
+	seg.start.lat = 0.0;
+	seg.end.lon = 180.0;
+	seg.end.lat = 0.0;
+	EQUALS(-3, proteus_Weather_sampleSegment(&seg, 2, pos, wx, 0, PROTEUS_WX_FIELD_TEMP));
+	seg.greatCircle = false;
+	EQUALS(2, proteus_Weather_sampleSegment(&seg, 2, pos, wx, 0, PROTEUS_WX_FIELD_TEMP));
+
+
+	// Sample times follow the speed along the segment, across forecast steps (each with a single grid
+	// point, at 0,0, where the temperature rises by 10 degrees an hour).
+	char dirs[TIMELINE_TEST_STEPS][32];
+	const char* dirPtrs[TIMELINE_TEST_STEPS];
+	time_t validTimes[TIMELINE_TEST_STEPS];
+
+	const time_t t0 = 1700000000;
+
+	int rc = 1;
+	int created = 0;
+
+	proteus_WeatherCtx* ctx = proteus_WeatherCtx_create();
+	if (!ctx)
+	{
+		goto done;
+	}
+
+	for (; created < TIMELINE_TEST_STEPS; created++)
+	{
+		strcpy(dirs[created], "/tmp/proteus_test_wx_XXXXXX");
+		if (!mkdtemp(dirs[created]) || writeTimelineStep(dirs[created], 10.0f * created, false) != 0)
+		{
+			goto done;
+		}
+
+		dirPtrs[created] = dirs[created];
+		validTimes[created] = t0 + (3600 * created);
+	}
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+	opts.timelineSteps = TIMELINE_TEST_STEPS;
+
+	if (0 != proteus_WeatherCtx_initTimeline(ctx, PROTEUS_WEATHER_SOURCE_DATA_GRID_1P00, dirPtrs, validTimes, TIMELINE_TEST_STEPS, &opts))
+	{
+		goto done;
+	}
+
+	// Northward along the prime meridian, for about 100 km at 10 m/s (reaching the last step)
+	seg.start.lon = 0.0;
+	seg.start.lat = 0.0;
+	seg.end.lon = 0.0;
+	seg.end.lat = 0.9;
+	seg.startTime = t0;
+	seg.speed = 10.0;
+
+	proteus_Weather swx[SEGMENT_TEST_SAMPLES];
+
+	if (SEGMENT_TEST_SAMPLES != proteus_WeatherCtx_sampleSegment(ctx, &seg, SEGMENT_TEST_SAMPLES, pos, swx, 0, PROTEUS_WX_FIELD_TEMP))
+	{
+		goto done;
+	}
+
+	for (int i = 0; i < SEGMENT_TEST_SAMPLES; i++)
+	{
+		// (Degrees of latitude along a meridian, of 111195 metres each on the sphere used for distances.)
+		const double t = (pos[i].lat * 111195.08) / seg.speed;
+		const double tempC = 10.0 * (t / 3600.0);
+
+		// Interpolated toward the points north of 0,0 (at 0 K)
+		const double expected = ((1.0 - pos[i].lat) * (tempC + 273.15)) - 273.15;
+
+		if (fabs(swx[i].temp - expected) > 0.001)
+		{
+			printf("\tUnexpected temperature %f (rather than %f) at lat=%f\n", swx[i].temp, expected, pos[i].lat);
+			goto done;
+		}
+	}
+
+	rc = 0;
+
+done:
+	for (int i = 0; i < created; i++)
+	{
+		writeTimelineStep(dirs[i], 0.0f, true);
+		rmdir(dirs[i]);
+	}
+
+	proteus_WeatherCtx_destroy(ctx);
+
+	return rc;
+}
+
+// Queries within a region (and its margin) must match those of the whole grid, and queries
+// more than a grid cell outside of it must fail.
+static int checkRegion(int sourceDataGrid, const char* dir, const proteus_WeatherRegion* region, double cell)
+{
+	const double step = cell / 2.0;
+
+	const double south = region->south - region->margin;
+	const double north = region->north + region->margin;
+
+	const double lat0 = ((south - 2.0 < -90.0) ? -90.0 : south - 2.0);
+	const double lat1 = ((north + 2.0 > 90.0) ? 90.0 : north + 2.0);
+
+	const int cols = (int) (360.0 / step) + 1;
+	const int rows = (int) ((lat1 - lat0) / step) + 1;
+
+	proteus_Weather* expected = malloc((size_t) cols * rows * sizeof(proteus_Weather));
+	if (!expected)
+	{
+		return 1;
+	}
+
+	int rc = 1;
+
+	if (0 != proteus_Weather_init(sourceDataGrid, dir, dir))
+	{
+		goto done;
+	}
+
+	proteus_GeoPos p;
+	proteus_Weather wx;
+
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < cols; x++)
+		{
+			p.lat = lat0 + (y * step);
+			p.lon = -180.0 + (x * step);
+			if (!proteus_Weather_get(&p, expected + (y * cols) + x, false))
+			{
+				goto done;
+			}
+		}
+	}
+
+	proteus_WeatherOptions opts;
+	proteus_Weather_getDefaultOptions(&opts);
+
+	if (0 != proteus_Weather_initRegion(sourceDataGrid, dir, dir, region, &opts))
+	{
+		goto done;
+	}
+
+	// Longitude span of the region (and its margin), eastward from its west edge
+	const double west = region->west - region->margin;
+	const double width = ((region->east >= region->west) ? 0.0 : 360.0) + region->east - region->west + (2.0 * region->margin);
+
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < cols; x++)
+		{
+			const proteus_Weather* e = expected + (y * cols) + x;
+
+			p.lat = lat0 + (y * step);
+			p.lon = -180.0 + (x * step);
+
+			double dLon = p.lon - west;
+			while (dLon < 0.0)
+			{
+				dLon += 360.0;
+			}
+			while (dLon >= 360.0)
+			{
+				dLon -= 360.0;
+			}
+
+			const double dLat = ((p.lat < south) ? south - p.lat : p.lat - north);
+
+			const bool inside = (dLon <= width && dLat <= 0.0);
+			const bool outside = ((dLon > width + cell && dLon < 360.0 - cell) || dLat > cell);
+
+			const bool ok = proteus_Weather_get(&p, &wx, false);
+
+			if ((inside && !ok) || (outside && ok))
+			{
+				printf("\tUnexpected result (%d) at lon=%f lat=%f\n", ok, p.lon, p.lat);
+				goto done;
+			}
+
+			if (ok && (wx.temp != e->temp ||
+					wx.pressure != e->pressure ||
+					wx.windGust != e->windGust ||
+					wx.wind.mag != e->wind.mag ||
+					wx.wind.angle != e->wind.angle ||
+					wx.cond != e->cond))
+			{
+				printf("\tMismatch at lon=%f lat=%f\n", p.lon, p.lat);
+				goto done;
+			}
+		}
+	}
+
+	rc = 0;
+
+done:
+	free(expected);
+	return rc;
+}
+
+// Compresses a file (to one with a ".gz" suffix added to its name), as the given number of concatenated gzip members.
+static int gzipFile(const char* srcDir, const char* name, const char* dstDir, int members)
+{
+	char path[256];
+
+	snprintf(path, sizeof(path), "%s/%s", srcDir, name);
+	FILE* src = fopen(path, "rb");
+	if (!src)
+	{
+		return -1;
+	}
+
+	fseek(src, 0, SEEK_END);
+	const long memberLen = (ftell(src) / members) + 1;
+	fseek(src, 0, SEEK_SET);
+
+	snprintf(path, sizeof(path), "%s/%s.gz", dstDir, name);
+	unlink(path);
+
+	int rc = 0;
+	char buf[4096];
+
+	for (int m = 0; m < members && rc == 0; m++)
+	{
+		gzFile dst = gzopen(path, "ab");
+		if (!dst)
+		{
+			rc = -1;
+			break;
+		}
+
+		for (long len = 0; len < memberLen; )
+		{
+			const size_t n = fread(buf, 1, ((memberLen - len < (long) sizeof(buf)) ? (size_t) (memberLen - len) : sizeof(buf)), src);
+			if (n == 0)
+			{
+				break;
+			}
+
+			if ((int) n != gzwrite(dst, buf, n))
+			{
+				rc = -1;
+			}
+
+			len += n;
+		}
+
+		if (Z_OK != gzclose(dst))
+		{
+			rc = -1;
+		}
+	}
+
+	fclose(src);
+	return rc;
+}
 
 static int test_grid_0p50()
 {
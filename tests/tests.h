@@ -17,14 +17,32 @@
 #ifndef _tests_h_
 #define _tests_h_
 
+#include <time.h>
+
 int test_Celestial_run();
 int test_Compass_run();
 int test_GeoInfo_run();
 int test_GeoPos_run();
 int test_GeoVec_run();
 int test_Ocean_run();
+int test_RowParser_run();
 int test_ScalarConv_run();
 int test_Wave_run();
 int test_Weather_run();
 
+
+// Shared helpers (see tests_util.c)
+
+// The time given by tests_fakeClock(), for tests to set
+extern time_t tests_fakeTime;
+
+// A clock for proteus_Scheduler_setClock(), giving tests_fakeTime
+time_t tests_fakeClock(void);
+
+// Waits (for up to five seconds) for a job to be scheduled before t, returning the time of the next job.
+time_t tests_waitForNextTimeBefore(time_t t);
+
+// Copies a file (from srcDir/srcName to dstDir/dstName), returning 0 on success or -1 on failure
+int tests_copyFile(const char* srcDir, const char* srcName, const char* dstDir, const char* dstName);
+
 #endif // _tests_h_
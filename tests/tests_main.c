@@ -29,6 +29,7 @@ static const char* TEST_NAMES[] = {
 	"GeoPos",
 	"GeoVec",
 	"Ocean",
+	"RowParser",
 	"ScalarConv",
 	"Wave",
 	"Weather"
@@ -41,6 +42,7 @@ static const test_func TEST_FUNCS[] = {
 	&test_GeoPos_run,
 	&test_GeoVec_run,
 	&test_Ocean_run,
+	&test_RowParser_run,
 	&test_ScalarConv_run,
 	&test_Wave_run,
 	&test_Weather_run
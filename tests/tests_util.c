@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2026 ls4096 <ls4096@8bitbyte.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tests.h"
+
+#include "proteus/Scheduler.h"
+
+
+time_t tests_fakeTime = 0;
+
+time_t tests_fakeClock(void)
+{
+	return tests_fakeTime;
+}
+
+time_t tests_waitForNextTimeBefore(time_t t)
+{
+	time_t next = proteus_Scheduler_getNextTime();
+
+	for (int i = 0; i < 500 && next >= t; i++)
+	{
+		usleep(10000);
+		next = proteus_Scheduler_getNextTime();
+	}
+
+	return next;
+}
+
+int tests_copyFile(const char* srcDir, const char* srcName, const char* dstDir, const char* dstName)
+{
+	char path[256];
+
+	snprintf(path, sizeof(path), "%s/%s", srcDir, srcName);
+	FILE* src = fopen(path, "rb");
+	if (!src)
+	{
+		return -1;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", dstDir, dstName);
+	FILE* dst = fopen(path, "wb");
+	if (!dst)
+	{
+		fclose(src);
+		return -1;
+	}
+
+	char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+	{
+		fwrite(buf, 1, n, dst);
+	}
+
+	fclose(src);
+	return ((0 == fclose(dst)) ? 0 : -1);
+}